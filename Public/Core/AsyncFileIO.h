@@ -0,0 +1,475 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_ASYNC_FILE_IO_H
+#define CORE_ASYNC_FILE_IO_H 1
+
+#include "Future.h"
+#include "IThreadManager.h"
+#include "Base/IOBuffer.h"
+#include <span>
+
+#if PLT_WINDOWS
+#include "Win/WinFile.h"
+#else
+#include "Lnx/LnxFile.h"
+#include "Lnx/LnxIOUring.h"
+#endif
+
+namespace greaper
+{
+	struct AsyncFileIOConfig
+	{
+		IThreadManager* ThreadManager = nullptr; // Creates the completion thread of the io_uring backend, required to use it
+		IThreadPool* FallbackPool = nullptr; // Runs the blocking transfers without io_uring, nullptr runs them on the caller thread
+		uint32 QueueDepth = 128;
+		sizet RegisteredBufferSize = 256 * 1024;
+		uint32 RegisteredBufferCount = 32; // 0 disables the pooled buffers
+		bool UseIOUring = true;
+	};
+
+	struct AsyncReadRequest
+	{
+		OSFile::Handle Handle;
+		int64 Offset;
+		sizet Length;
+	};
+
+	namespace Impl
+	{
+		struct AsyncFileOperation
+		{
+			Promise<IOBuffer> Result;
+			IOBuffer Buffer;
+			OSFile::Handle Handle;
+			int64 Offset;
+			sizet Length;
+			sizet Done;
+			bool IsWrite;
+			bool OwnsHandle;
+		};
+	}
+
+	/**
+	 * Asynchronous positional file reads and writes. On Linux the transfers go
+	 * through an io_uring, batches are handed with a single syscall and reads that
+	 * fit a pooled buffer use its pre-registered pages, a dedicated thread reaps
+	 * the completions and fulfils the futures. Without io_uring each transfer is
+	 * run as a blocking task on the fallback pool.
+	 * The transfers in flight are capped to the completion queue size, callers
+	 * beyond it wait for a completion. A failed transfer, or one the kernel
+	 * refuses to take, breaks its future, check HasValue. Pooled buffers return
+	 * to the service when destroyed, so they must not outlive it.
+	 */
+	class AsyncFileIO
+	{
+		using Operation = Impl::AsyncFileOperation;
+
+		static constexpr sizet MaxTransfer = 1u << 30;
+		static constexpr uint32 SubmitRetries = 16;
+
+		AsyncFileIOConfig m_Config;
+		Impl::IOBufferPool m_BufferPool;
+		Mutex m_InFlightMutex;
+		Signal m_IdleSignal;
+		uint32 m_InFlight = 0;
+#if PLT_LINUX
+		LnxIOUring m_Ring;
+		Mutex m_SubmitMutex;
+		// One permit per completion the ring can hold, minus the wake up entry of the destructor
+		LightweightSemaphore m_RingSlots;
+		std::atomic<uint32> m_RingSlotDebt{ 0 }; // Slots taken without a permit by the completion thread
+		IThread* m_CompletionThread = nullptr;
+		std::atomic_bool m_Stopping{ false };
+		bool m_BuffersRegistered = false;
+#endif
+
+		Operation* CreateOperation(OSFile::Handle handle, bool ownsHandle, int64 offset, IOBuffer buffer, sizet length, bool isWrite)
+		{
+			auto* op = new(AllocT<Operation>())Operation();
+			op->Buffer = std::move(buffer);
+			op->Handle = handle;
+			op->Offset = offset;
+			op->Length = length;
+			op->Done = 0;
+			op->IsWrite = isWrite;
+			op->OwnsHandle = ownsHandle;
+			auto lck = Lock<Mutex>(m_InFlightMutex);
+			++m_InFlight;
+			return op;
+		}
+
+		void Finish(Operation* op, bool succeeded)
+		{
+			if (op->OwnsHandle)
+				OSFile::Close(op->Handle);
+			if (succeeded)
+			{
+				op->Buffer.SetSize(op->Done);
+				op->Result.SetValue(std::move(op->Buffer));
+			}
+			// Destroying an unsatisfied promise breaks the future
+			Destroy<Operation>(op);
+			auto lck = Lock<Mutex>(m_InFlightMutex);
+			if (--m_InFlight == 0)
+				m_IdleSignal.notify_all();
+		}
+
+		void RunBlocking(Operation* op)
+		{
+			const auto res = op->IsWrite
+				? OSFile::WriteAt(op->Handle, op->Buffer.GetData(), op->Length, op->Offset)
+				: OSFile::ReadAt(op->Handle, op->Buffer.GetData(), op->Length, op->Offset);
+			if (res > 0)
+				op->Done = (sizet)res;
+			Finish(op, res >= 0);
+		}
+
+		void Submit(std::span<Operation*> ops)
+		{
+#if PLT_LINUX
+			if (m_CompletionThread != nullptr)
+			{
+				SubmitToRing(ops);
+				return;
+			}
+#endif
+			for (auto* op : ops)
+			{
+				if (op->Length == 0)
+					Finish(op, true);
+				else if (m_Config.FallbackPool != nullptr)
+					m_Config.FallbackPool->RunTask(Task([this, op]() { RunBlocking(op); }, "AsyncFileIO"sv));
+				else
+					RunBlocking(op);
+			}
+		}
+
+		TAsyncOp<IOBuffer> Start(OSFile::Handle handle, bool ownsHandle, int64 offset, IOBuffer buffer, sizet length, bool isWrite)
+		{
+			auto* op = CreateOperation(handle, ownsHandle, offset, std::move(buffer), length, isWrite);
+			auto future = op->Result.GetFuture();
+			Submit(std::span<Operation*>(&op, 1));
+			return future;
+		}
+
+#if PLT_LINUX
+		static INLINE AsyncFileIO*& GetCompletingService() noexcept
+		{
+			static thread_local AsyncFileIO* service = nullptr;
+			return service;
+		}
+
+		/**
+		 * Takes a ring slot for a new operation, waiting for a completion if
+		 * there's none. The completion thread can't wait for itself, it goes over
+		 * the limit instead, which the next released slot pays back.
+		 */
+		void AcquireRingSlot(UniqueLock<Mutex>& submitLock, Vector<Operation*>& failed)
+		{
+			if (m_RingSlots.try_wait())
+				return;
+			if (GetCompletingService() == this)
+			{
+				m_RingSlotDebt.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			// The entries prepared so far must reach the kernel to ever complete
+			SubmitPrepared(failed);
+			submitLock.unlock();
+			m_RingSlots.wait();
+			submitLock.lock();
+		}
+
+		/** Called once an operation will get no more completions */
+		void ReleaseRingSlot()
+		{
+			auto debt = m_RingSlotDebt.load(std::memory_order_relaxed);
+			while (debt > 0)
+			{
+				if (m_RingSlotDebt.compare_exchange_weak(debt, debt - 1, std::memory_order_relaxed))
+					return;
+			}
+			m_RingSlots.notify();
+		}
+
+		/**
+		 * Hands the prepared entries to the kernel, m_SubmitMutex must be held.
+		 * A busy ring is retried while the completion thread reaps, the entries
+		 * it still refuses are taken back and their operations added to failed,
+		 * to be finished once the mutex is released.
+		 */
+		void SubmitPrepared(Vector<Operation*>& failed)
+		{
+			for (uint32 retry = 0; ; ++retry)
+			{
+				const auto res = m_Ring.Submit();
+				if (m_Ring.GetUnsubmittedCount() == 0 || retry == SubmitRetries || (res < 0 && res != -EBUSY && res != -EAGAIN))
+					break;
+				THREAD_YIELD();
+			}
+			m_Ring.RetractUnsubmitted([this, &failed](uint64 userData)
+				{
+					// Wake up entry of the destructor
+					if (userData == 0)
+						return;
+					ReleaseRingSlot();
+					failed.push_back((Operation*)(ptruint)userData);
+				});
+		}
+
+		/** Fills a submission entry for the remaining part of op, m_SubmitMutex must be held */
+		bool Prepare(Operation* op, Vector<Operation*>& failed)
+		{
+			auto* sqe = m_Ring.GetSQE();
+			if (sqe == nullptr)
+			{
+				// The kernel consumes the entries while submitting them
+				SubmitPrepared(failed);
+				sqe = m_Ring.GetSQE();
+				if (sqe == nullptr)
+					return false;
+			}
+			const bool fixed = m_BuffersRegistered && op->Buffer.IsPooled();
+			if (op->IsWrite)
+				sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+			else
+				sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe->fd = op->Handle;
+			sqe->off = (uint64)(op->Offset + (int64)op->Done);
+			sqe->addr = (uint64)(ptruint)(op->Buffer.GetData() + op->Done);
+			sqe->len = (uint32)Min(op->Length - op->Done, MaxTransfer);
+			if (fixed)
+				sqe->buf_index = (uint16)op->Buffer.GetPoolIndex();
+			sqe->user_data = (uint64)(ptruint)op;
+			return true;
+		}
+
+		void SubmitToRing(std::span<Operation*> ops)
+		{
+			sizet empty = 0;
+			Vector<Operation*> failed;
+			{
+				UniqueLock<Mutex> lck(m_SubmitMutex);
+				for (auto* op : ops)
+				{
+					if (op->Length == 0)
+					{
+						ops[empty++] = op;
+						continue;
+					}
+					AcquireRingSlot(lck, failed);
+					if (!Prepare(op, failed))
+					{
+						ReleaseRingSlot();
+						failed.push_back(op);
+					}
+				}
+				SubmitPrepared(failed);
+			}
+			for (sizet i = 0; i < empty; ++i)
+				Finish(ops[i], true);
+			for (auto* op : failed)
+				Finish(op, false);
+		}
+
+		void FinishInRing(Operation* op, bool succeeded)
+		{
+			ReleaseRingSlot();
+			Finish(op, succeeded);
+		}
+
+		void OnCompletion(uint64 userData, int32 result)
+		{
+			// Wake up entry of the destructor
+			if (userData == 0)
+				return;
+
+			auto* op = (Operation*)(ptruint)userData;
+			if (result < 0 && result != -EAGAIN && result != -EINTR)
+			{
+				FinishInRing(op, false);
+				return;
+			}
+			if (result == 0)
+			{
+				// End of file on reads, nothing else would make progress
+				FinishInRing(op, !op->IsWrite);
+				return;
+			}
+			if (result > 0)
+				op->Done += (sizet)result;
+			if (op->Done >= op->Length)
+			{
+				FinishInRing(op, true);
+				return;
+			}
+			// The rest of the transfer keeps the slot of the operation
+			Vector<Operation*> failed;
+			{
+				auto lck = Lock<Mutex>(m_SubmitMutex);
+				if (!Prepare(op, failed))
+				{
+					ReleaseRingSlot();
+					failed.push_back(op);
+				}
+				SubmitPrepared(failed);
+			}
+			for (auto* failedOp : failed)
+				Finish(failedOp, false);
+		}
+
+		void CompletionLoop()
+		{
+			GetCompletingService() = this;
+			while (!m_Stopping.load(std::memory_order_acquire))
+			{
+				m_Ring.WaitCompletion();
+				m_Ring.ProcessCompletions([this](uint64 userData, int32 result) { OnCompletion(userData, result); });
+			}
+		}
+
+		bool StartRing()
+		{
+			if (!m_Config.UseIOUring || m_Config.ThreadManager == nullptr)
+				return false;
+			if (!m_Ring.Initialize(m_Config.QueueDepth))
+				return false;
+			m_RingSlots.notify(m_Ring.GetCQEntries() - 1);
+			if (m_BufferPool.GetBlockCount() > 0)
+				m_BuffersRegistered = m_Ring.RegisterBuffers(m_BufferPool.GetBlock(0), m_BufferPool.GetBlockSize(), m_BufferPool.GetBlockCount());
+
+			ThreadConfig config;
+			config.ThreadFN = [this]() { CompletionLoop(); };
+			config.Name = "AsyncFileIO"sv;
+			auto thread = m_Config.ThreadManager->CreateThread(config);
+			if (thread.HasFailed())
+			{
+				m_Ring.Shutdown();
+				return false;
+			}
+			m_CompletionThread = thread.GetValue();
+			return true;
+		}
+
+		void StopRing()
+		{
+			m_Stopping.store(true, std::memory_order_release);
+			{
+				auto lck = Lock<Mutex>(m_SubmitMutex);
+				auto* sqe = m_Ring.GetSQE();
+				if (sqe != nullptr)
+				{
+					sqe->opcode = IORING_OP_NOP;
+					sqe->user_data = 0;
+				}
+				Vector<Operation*> failed;
+				SubmitPrepared(failed);
+			}
+			m_CompletionThread->Join();
+			m_Config.ThreadManager->DestroyThread(m_CompletionThread);
+			m_CompletionThread = nullptr;
+			m_Ring.Shutdown();
+		}
+#endif
+
+	public:
+		explicit AsyncFileIO(const AsyncFileIOConfig& config = AsyncFileIOConfig{})
+			:m_Config(config)
+			,m_BufferPool(config.RegisteredBufferSize, config.RegisteredBufferCount)
+		{
+#if PLT_LINUX
+			StartRing();
+#endif
+		}
+
+		AsyncFileIO(const AsyncFileIO&) = delete;
+		AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+		/** Waits for the transfers in flight */
+		~AsyncFileIO()
+		{
+			{
+				UniqueLock<Mutex> lck(m_InFlightMutex);
+				m_IdleSignal.wait(lck, [this]() { return m_InFlight == 0; });
+			}
+#if PLT_LINUX
+			if (m_CompletionThread != nullptr)
+				StopRing();
+#endif
+		}
+
+		[[nodiscard]] bool IsUsingIOUring()const noexcept
+		{
+#if PLT_LINUX
+			return m_CompletionThread != nullptr;
+#else
+			return false;
+#endif
+		}
+
+		/** Returns a pooled buffer if size fits one and there's one free, otherwise a heap one */
+		[[nodiscard]] IOBuffer AcquireBuffer(sizet size)
+		{
+			auto buffer = m_BufferPool.TryAcquire(size);
+			if (buffer.GetData() == nullptr)
+				return IOBuffer(size);
+			return buffer;
+		}
+
+		/** The handle must stay open until the future completes, the result is shorter at the end of the file */
+		[[nodiscard]] TAsyncOp<IOBuffer> ReadAsync(OSFile::Handle handle, int64 offset, sizet length)
+		{
+			return Start(handle, false, offset, AcquireBuffer(length), length, false);
+		}
+
+		/** Opens the file for the duration of the read */
+		[[nodiscard]] TAsyncOp<IOBuffer> ReadAsync(StringView path, int64 offset, sizet length)
+		{
+			const auto handle = OSFile::Open(String(path).c_str(), true, false, FileOpenMode_t::OpenExisting, FileAccessPattern_t::Normal);
+			if (handle == OSFile::InvalidHandle)
+				return Promise<IOBuffer>().GetFuture();
+			return Start(handle, true, offset, AcquireBuffer(length), length, false);
+		}
+
+		/** Queues all the reads with a single submission */
+		[[nodiscard]] Vector<TAsyncOp<IOBuffer>> ReadAsync(std::span<const AsyncReadRequest> requests)
+		{
+			Vector<TAsyncOp<IOBuffer>> futures;
+			Vector<Operation*> ops;
+			futures.reserve(requests.size());
+			ops.reserve(requests.size());
+			for (const auto& request : requests)
+			{
+				auto* op = CreateOperation(request.Handle, false, request.Offset, AcquireBuffer(request.Length), request.Length, false);
+				futures.push_back(op->Result.GetFuture());
+				ops.push_back(op);
+			}
+			Submit(std::span<Operation*>(ops));
+			return futures;
+		}
+
+		/** Writes the whole buffer and hands it back, its size is the amount written */
+		[[nodiscard]] TAsyncOp<IOBuffer> WriteAsync(OSFile::Handle handle, int64 offset, IOBuffer data)
+		{
+			const auto length = data.GetSize();
+			return Start(handle, false, offset, std::move(data), length, true);
+		}
+
+		/** Opens, or creates, the file for the duration of the write */
+		[[nodiscard]] TAsyncOp<IOBuffer> WriteAsync(StringView path, int64 offset, IOBuffer data)
+		{
+			const auto handle = OSFile::Open(String(path).c_str(), false, true, FileOpenMode_t::OpenOrCreate, FileAccessPattern_t::Normal);
+			if (handle == OSFile::InvalidHandle)
+				return Promise<IOBuffer>().GetFuture();
+			const auto length = data.GetSize();
+			return Start(handle, true, offset, std::move(data), length, true);
+		}
+	};
+}
+
+#endif /* CORE_ASYNC_FILE_IO_H */
\ No newline at end of file
@@ -0,0 +1,87 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_ASYNC_FILE_STREAM_H
+#define CORE_ASYNC_FILE_STREAM_H 1
+
+#include "Stream.h"
+#include "AsyncFileIO.h"
+
+namespace greaper
+{
+	struct AsyncFileStreamConfig
+	{
+		sizet BlockSize = 256 * 1024; // Matching AsyncFileIOConfig::RegisteredBufferSize lets the reads use the pooled buffers
+		uint32 PrefetchBlocks = 4; // Blocks read ahead of the one under the cursor
+	};
+
+	/**
+	 * Read only file stream that keeps the next PrefetchBlocks blocks in flight
+	 * through an AsyncFileIO, so the file is read while the current block is
+	 * being deserialized. Seeking outside the prefetched range restarts the
+	 * read ahead from the new position. Must be closed before its AsyncFileIO
+	 * is destroyed.
+	 */
+	class AsyncFileStream : public IStream
+	{
+	protected:
+		AsyncFileIO* m_IO;
+		AsyncFileStreamConfig m_Config;
+		OSFile::Handle m_Handle;
+		mutable IOBuffer m_Block; // Block under the cursor
+		mutable int64 m_BlockOffset;
+		mutable int64 m_Position;
+		mutable Vector<TAsyncOp<IOBuffer>> m_Prefetched; // Blocks that follow m_Block, in order
+		mutable int64 m_PrefetchedOffset; // File offset of m_Prefetched[0]
+		mutable Vector<TAsyncOp<IOBuffer>> m_Discarded; // Read ahead dropped by a Seek, still using the handle
+
+		/** Queues reads until count blocks are in flight or the end of the file is reached */
+		void Prefetch(sizet count)const;
+
+		/** Waits for all the pending reads, the handle must not be closed while they use it */
+		void WaitPrefetched()const;
+
+		/** Makes m_Block the block that holds offset */
+		bool LoadBlock(int64 offset)const;
+
+	public:
+		AsyncFileStream(AsyncFileIO& io, StringView path, const AsyncFileStreamConfig& config = AsyncFileStreamConfig{});
+
+		AsyncFileStream(const AsyncFileStream&) = delete;
+		AsyncFileStream& operator=(const AsyncFileStream&) = delete;
+
+		~AsyncFileStream();
+
+		INLINE bool IsFile()const noexcept override { return true; }
+
+		[[nodiscard]] INLINE bool IsOpen()const noexcept { return m_Handle != OSFile::InvalidHandle; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		/** The stream is read only */
+		ssizet Write(const void* buf, ssizet count) override;
+
+		void Skip(ssizet count) override;
+
+		void Seek(ssizet pos) override;
+
+		ssizet Tell()const override { return (ssizet)m_Position; }
+
+		bool Eof()const override { return m_Position >= m_Size; }
+
+		/** Opens the same file again at the same position, data is never copied */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		[[nodiscard]] INLINE const AsyncFileStreamConfig& GetConfig()const noexcept { return m_Config; }
+	};
+}
+
+#include "Base/AsyncFileStream.inl"
+
+#endif /* CORE_ASYNC_FILE_STREAM_H */
\ No newline at end of file
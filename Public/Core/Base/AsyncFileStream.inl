@@ -0,0 +1,151 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../AsyncFileStream.h"
+
+namespace greaper
+{
+	void AsyncFileStream::Prefetch(const sizet count)const
+	{
+		const auto blockSize = (int64)m_Config.BlockSize;
+		Vector<AsyncReadRequest> requests;
+		for (auto next = m_PrefetchedOffset + (int64)m_Prefetched.size() * blockSize;
+			m_Prefetched.size() + requests.size() < count && next < m_Size; next += blockSize)
+		{
+			requests.push_back(AsyncReadRequest{ m_Handle, next, m_Config.BlockSize });
+		}
+		if (requests.empty())
+			return;
+		for (auto& future : m_IO->ReadAsync(std::span<const AsyncReadRequest>(requests)))
+			m_Prefetched.push_back(std::move(future));
+	}
+
+	void AsyncFileStream::WaitPrefetched()const
+	{
+		for (const auto& future : m_Prefetched)
+			future.BlockUntilComplete();
+		for (const auto& future : m_Discarded)
+			future.BlockUntilComplete();
+		m_Prefetched.clear();
+		m_Discarded.clear();
+	}
+
+	bool AsyncFileStream::LoadBlock(const int64 offset)const
+	{
+		const auto blockOffset = offset - offset % (int64)m_Config.BlockSize;
+		if (m_Prefetched.empty() || m_PrefetchedOffset != blockOffset)
+		{
+			// Outside of the read ahead, it is dropped without waiting for it
+			std::erase_if(m_Discarded, [](const TAsyncOp<IOBuffer>& future) { return future.HasCompleted(); });
+			for (auto& future : m_Prefetched)
+				m_Discarded.push_back(std::move(future));
+			m_Prefetched.clear();
+			m_PrefetchedOffset = blockOffset;
+		}
+		Prefetch((sizet)m_Config.PrefetchBlocks + 1);
+		m_Block.Reset();
+		if (m_Prefetched.empty())
+			return false;
+
+		auto future = std::move(m_Prefetched.front());
+		m_Prefetched.erase(m_Prefetched.begin());
+		m_PrefetchedOffset += (int64)m_Config.BlockSize;
+		future.BlockUntilComplete();
+		if (!future.HasValue())
+			return false;
+		m_Block = std::move(future.GetReturnValue());
+		m_BlockOffset = blockOffset;
+		return !m_Block.IsEmpty();
+	}
+
+	AsyncFileStream::AsyncFileStream(AsyncFileIO& io, StringView path, const AsyncFileStreamConfig& config)
+		:IStream(path, READ)
+		,m_IO(&io)
+		,m_Config(config)
+		,m_Handle(OSFile::InvalidHandle)
+		,m_BlockOffset(0)
+		,m_Position(0)
+		,m_PrefetchedOffset(0)
+	{
+		m_Size = 0;
+		VerifyGreater(m_Config.BlockSize, (sizet)0, "An AsyncFileStream needs a block size.");
+		m_Handle = OSFile::Open(m_Name.c_str(), true, false, FileOpenMode_t::OpenExisting, FileAccessPattern_t::Sequential);
+		if (!IsOpen())
+			return;
+		const auto size = OSFile::GetSize(m_Handle);
+		m_Size = size < 0 ? 0 : (ssizet)size;
+		Prefetch((sizet)m_Config.PrefetchBlocks + 1);
+	}
+
+	AsyncFileStream::~AsyncFileStream()
+	{
+		Close();
+	}
+
+	ssizet AsyncFileStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsOpen() || count <= 0)
+			return 0;
+
+		const auto total = Min((int64)count, (int64)m_Size - m_Position);
+		auto* dst = (uint8*)buf;
+		int64 done = 0;
+		while (done < total)
+		{
+			auto blockEnd = m_BlockOffset + (int64)m_Block.GetSize();
+			if (m_Block.IsEmpty() || m_Position < m_BlockOffset || m_Position >= blockEnd)
+			{
+				if (!LoadBlock(m_Position))
+					break;
+				blockEnd = m_BlockOffset + (int64)m_Block.GetSize();
+				// The file was truncated while reading it
+				if (m_Position >= blockEnd)
+					break;
+			}
+			const auto size = Min(total - done, blockEnd - m_Position);
+			memcpy(dst + done, m_Block.GetData() + (m_Position - m_BlockOffset), (sizet)size);
+			m_Position += size;
+			done += size;
+		}
+		return (ssizet)done;
+	}
+
+	ssizet AsyncFileStream::Write(const void* buf, ssizet count)
+	{
+		UNUSED(buf);
+		UNUSED(count);
+		return 0;
+	}
+
+	void AsyncFileStream::Skip(const ssizet count)
+	{
+		Seek(Tell() + count);
+	}
+
+	void AsyncFileStream::Seek(const ssizet pos)
+	{
+		VerifyLessEqual(pos, m_Size, "Trying to seek an AsyncFileStream outside of its bounds.");
+		VerifyGreaterEqual(pos, 0, "Trying to seek an AsyncFileStream outside of its bounds.");
+		m_Position = Clamp(pos, (ssizet)0, m_Size);
+	}
+
+	SPtr<IStream> AsyncFileStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		auto clone = std::make_shared<AsyncFileStream>(*m_IO, m_Name, m_Config);
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void AsyncFileStream::Close()
+	{
+		WaitPrefetched();
+		m_Block.Reset();
+		if (!IsOpen())
+			return;
+		OSFile::Close(m_Handle);
+		m_Handle = OSFile::InvalidHandle;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,358 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../BufferedStream.h"
+
+namespace greaper
+{
+	bool BufferedStream::MoveInnerOffset(const int64 offset)const
+	{
+		if (m_InnerOffset == offset)
+			return true;
+		m_Inner->Seek((ssizet)offset);
+		m_InnerOffset = (int64)m_Inner->Tell();
+		return m_InnerOffset == offset;
+	}
+
+	bool BufferedStream::FlushBuffer()const
+	{
+		if (m_Dirty)
+		{
+			// On failure the buffer is kept as is, the next flush writes it again from the start
+			if (!MoveInnerOffset(m_BufferOffset))
+				return false;
+			const auto written = m_Inner->Write(m_Buffer, (ssizet)m_BufferFill);
+			if (written > 0)
+				m_InnerOffset += written;
+			if (written != (ssizet)m_BufferFill)
+				return false;
+			m_Dirty = false;
+		}
+		m_BufferOffset += (int64)m_BufferPos;
+		m_BufferPos = 0;
+		m_BufferFill = 0;
+		return true;
+	}
+
+	ssizet BufferedStream::ReadFromInner(void* buffer, const sizet count)const
+	{
+		if (!MoveInnerOffset(m_BufferOffset))
+			return 0;
+		const auto read = m_Inner->Read(buffer, (ssizet)count);
+		if (read > 0)
+			m_InnerOffset += read;
+		return read;
+	}
+
+	BufferedStream::BufferedStream(SPtr<IStream> inner, const BufferedStreamConfig& config)
+		:IStream(inner != nullptr ? inner->GetName() : StringView{}, inner != nullptr ? inner->GetAccessMode() : (uint16)READ)
+		,m_Inner(std::move(inner))
+		,m_Config(config)
+		,m_Buffer(nullptr)
+		,m_BufferCapacity(config.BufferSize)
+		,m_BufferOffset(0)
+		,m_BufferPos(0)
+		,m_BufferFill(0)
+		,m_InnerOffset(0)
+		,m_Dirty(false)
+		,m_ReservedInPlace(false)
+	{
+		VerifyNotNull(m_Inner, "Trying to create a BufferedStream without a stream to wrap.");
+		m_Size = m_Inner->Size();
+		m_InnerOffset = (int64)m_Inner->Tell();
+		m_BufferOffset = m_InnerOffset;
+		if (m_BufferCapacity > 0)
+			m_Buffer = (uint8*)Alloc(m_BufferCapacity);
+	}
+
+	BufferedStream::~BufferedStream()
+	{
+		Close();
+	}
+
+	ssizet BufferedStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsReadable() || m_Inner == nullptr || count <= 0)
+			return 0;
+
+		if (m_Dirty && !FlushBuffer())
+			return 0;
+
+		auto* dst = (uint8*)buf;
+		sizet done = Min((sizet)count, m_BufferFill - m_BufferPos);
+		if (done > 0)
+		{
+			memcpy(dst, m_Buffer + m_BufferPos, done);
+			m_BufferPos += done;
+			if (done == (sizet)count)
+				return count;
+		}
+
+		m_BufferOffset += (int64)m_BufferPos;
+		m_BufferPos = 0;
+		m_BufferFill = 0;
+		const auto remaining = (sizet)count - done;
+		if (remaining >= m_BufferCapacity || !m_Config.ReadAhead)
+		{
+			const auto read = ReadFromInner(dst + done, remaining);
+			if (read > 0)
+			{
+				m_BufferOffset += read;
+				done += (sizet)read;
+			}
+			return (ssizet)done;
+		}
+
+		const auto read = ReadFromInner(m_Buffer, m_BufferCapacity);
+		if (read <= 0)
+			return (ssizet)done;
+		m_BufferFill = (sizet)read;
+		m_BufferPos = Min(remaining, m_BufferFill);
+		memcpy(dst + done, m_Buffer, m_BufferPos);
+		return (ssizet)(done + m_BufferPos);
+	}
+
+	ssizet BufferedStream::Write(const void* buf, ssizet count)
+	{
+		if (!IsWritable() || m_Inner == nullptr || count <= 0)
+			return 0;
+
+		if (!m_Dirty && m_BufferFill > 0)
+		{
+			// Drop the read-ahead, the buffer now holds writes
+			m_BufferOffset += (int64)m_BufferPos;
+			m_BufferPos = 0;
+			m_BufferFill = 0;
+		}
+
+		if ((sizet)count >= m_BufferCapacity)
+		{
+			if (!FlushBuffer() || !MoveInnerOffset(m_BufferOffset))
+				return 0;
+			const auto written = m_Inner->Write(buf, count);
+			if (written <= 0)
+				return 0;
+			m_InnerOffset += written;
+			m_BufferOffset += written;
+			m_Size = Max(m_Size, Tell());
+			return written;
+		}
+
+		// The pending writes didn't reach the inner stream, nothing more is taken
+		if (m_BufferPos + (sizet)count > m_BufferCapacity && !FlushBuffer())
+			return 0;
+		memcpy(m_Buffer + m_BufferPos, buf, (sizet)count);
+		m_BufferPos += (sizet)count;
+		m_BufferFill = Max(m_BufferFill, m_BufferPos);
+		m_Dirty = true;
+		m_Size = Max(m_Size, Tell());
+		return count;
+	}
+
+	ssizet BufferedStream::ReadV(const std::span<const IOVec> vecs)const
+	{
+		if (!IsReadable() || m_Inner == nullptr)
+			return 0;
+
+		sizet total = 0;
+		for (const auto& vec : vecs)
+			total += vec.Size;
+		if (total < m_BufferCapacity && m_Config.ReadAhead)
+			return IStream::ReadV(vecs);
+
+		// Whatever was read ahead is handed out first, the inner stream cursor is already past it
+		sizet done = 0;
+		sizet index = 0;
+		sizet offset = 0;
+		if (!m_Dirty)
+		{
+			for (; index < vecs.size() && m_BufferPos < m_BufferFill; ++index)
+			{
+				const auto piece = Min(vecs[index].Size, m_BufferFill - m_BufferPos);
+				memcpy(vecs[index].Data, m_Buffer + m_BufferPos, piece);
+				m_BufferPos += piece;
+				done += piece;
+				if (piece < vecs[index].Size)
+				{
+					offset = piece;
+					break;
+				}
+			}
+		}
+		if (index == vecs.size())
+			return (ssizet)done;
+		if (!FlushBuffer() || !MoveInnerOffset(m_BufferOffset))
+			return (ssizet)done;
+
+		Vector<IOVec> rest(vecs.begin() + (ptrdiff_t)index, vecs.end());
+		rest.front().Data = (uint8*)rest.front().Data + offset;
+		rest.front().Size -= offset;
+		const auto read = m_Inner->ReadV(rest);
+		if (read <= 0)
+			return (ssizet)done;
+		m_InnerOffset += read;
+		m_BufferOffset += read;
+		return (ssizet)done + read;
+	}
+
+	ssizet BufferedStream::WriteV(const std::span<const IOVec> vecs)
+	{
+		if (!IsWritable() || m_Inner == nullptr)
+			return 0;
+
+		sizet total = 0;
+		for (const auto& vec : vecs)
+			total += vec.Size;
+		if (total < m_BufferCapacity)
+			return IStream::WriteV(vecs);
+
+		if (!FlushBuffer() || !MoveInnerOffset(m_BufferOffset))
+			return 0;
+		const auto written = m_Inner->WriteV(vecs);
+		if (written <= 0)
+			return 0;
+		m_InnerOffset += written;
+		m_BufferOffset += written;
+		m_Size = Max(m_Size, Tell());
+		return written;
+	}
+
+	std::span<const uint8> BufferedStream::ReadView(const sizet count)const
+	{
+		if (!IsReadable() || m_Inner == nullptr || count == 0)
+			return {};
+		if (count > m_BufferCapacity || !m_Config.ReadAhead)
+			return IStream::ReadView(count);
+
+		if (m_Dirty && !FlushBuffer())
+			return {};
+
+		const auto available = m_BufferFill - m_BufferPos;
+		if (available < count)
+		{
+			// Keep the unread bytes and fill the rest of the buffer behind them
+			if (available > 0)
+				memmove(m_Buffer, m_Buffer + m_BufferPos, available);
+			m_BufferOffset += (int64)m_BufferPos;
+			m_BufferPos = 0;
+			m_BufferFill = available;
+			if (MoveInnerOffset(m_BufferOffset + (int64)available))
+			{
+				const auto read = m_Inner->Read(m_Buffer + available, (ssizet)(m_BufferCapacity - available));
+				if (read > 0)
+				{
+					m_InnerOffset += read;
+					m_BufferFill += (sizet)read;
+				}
+			}
+		}
+
+		const auto size = Min(count, m_BufferFill - m_BufferPos);
+		const auto view = std::span<const uint8>(m_Buffer + m_BufferPos, size);
+		m_BufferPos += size;
+		return view;
+	}
+
+	std::span<uint8> BufferedStream::WriteReserve(const sizet count)
+	{
+		m_ReservedInPlace = false;
+		if (!IsWritable() || m_Inner == nullptr || count == 0)
+			return {};
+		if (count > m_BufferCapacity)
+			return IStream::WriteReserve(count);
+
+		if (!m_Dirty && m_BufferFill > 0)
+		{
+			m_BufferOffset += (int64)m_BufferPos;
+			m_BufferPos = 0;
+			m_BufferFill = 0;
+		}
+		if (m_BufferPos + count > m_BufferCapacity && !FlushBuffer())
+			return {};
+		m_ReservedInPlace = true;
+		return { m_Buffer + m_BufferPos, count };
+	}
+
+	void BufferedStream::WriteCommit(const sizet count)
+	{
+		if (!m_ReservedInPlace)
+		{
+			IStream::WriteCommit(count);
+			return;
+		}
+		m_ReservedInPlace = false;
+		if (count == 0)
+			return;
+		m_BufferPos += count;
+		m_BufferFill = Max(m_BufferFill, m_BufferPos);
+		m_Dirty = true;
+		m_Size = Max(m_Size, Tell());
+	}
+
+	void BufferedStream::Skip(const ssizet count)
+	{
+		Seek(Tell() + count);
+	}
+
+	void BufferedStream::Seek(const ssizet pos)
+	{
+		VerifyGreaterEqual(pos, 0, "Trying to seek a BufferedStream before its start.");
+		const auto target = (int64)Max<ssizet>(pos, 0);
+		if (!m_Dirty && target >= m_BufferOffset && target <= m_BufferOffset + (int64)m_BufferFill)
+		{
+			m_BufferPos = (sizet)(target - m_BufferOffset);
+			return;
+		}
+		// The pending writes must reach the inner stream before the buffer moves, otherwise the cursor stays
+		if (!FlushBuffer())
+			return;
+		m_BufferOffset = target;
+	}
+
+	bool BufferedStream::Eof()const
+	{
+		if (m_Inner == nullptr)
+			return true;
+		if (m_BufferPos < m_BufferFill)
+			return false;
+		if (m_Size > 0)
+			return Tell() >= m_Size;
+		// Streams that don't know their size, like pipes, are asked once they are where this one is
+		return MoveInnerOffset((int64)Tell()) && m_Inner->Eof();
+	}
+
+	SPtr<IStream> BufferedStream::Clone(const bool copyData)const
+	{
+		if (m_Inner == nullptr || !FlushBuffer())
+			return SPtr<IStream>();
+		auto inner = m_Inner->Clone(copyData);
+		if (inner == nullptr)
+			return SPtr<IStream>();
+		auto clone = std::make_shared<BufferedStream>(std::move(inner), m_Config);
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void BufferedStream::Close()
+	{
+		if (m_Inner != nullptr)
+		{
+			FlushBuffer();
+			m_Inner.reset();
+		}
+		if (m_Buffer != nullptr)
+		{
+			Dealloc(m_Buffer);
+			m_Buffer = nullptr;
+		}
+	}
+
+	bool BufferedStream::Flush()
+	{
+		if (m_Inner == nullptr)
+			return false;
+		return FlushBuffer();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CPU_INFO_H
+#define CORE_CPU_INFO_H 1
+
+#include "../Memory.h"
+#include "../Enumeration.h"
+
+#ifndef GREAPER_MAX_LOGICAL_PROCESSORS
+#define GREAPER_MAX_LOGICAL_PROCESSORS 1024
+#endif
+
+namespace greaper
+{
+	ENUMERATION(ThreadPriority, Idle, Lowest, BelowNormal, Normal, AboveNormal, Highest, TimeCritical);
+
+	/**
+	 * Linux maps them to SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO and SCHED_RR,
+	 * Windows only has priorities, so the policy is ignored there.
+	 */
+	ENUMERATION(ThreadSchedulingPolicy, Default, Batch, Background, FIFO, RoundRobin);
+
+	/** Set of logical processors, used as thread affinity mask */
+	class CPUSet
+	{
+		static constexpr uint32 WordBits = 64;
+		static constexpr uint32 WordCount = GREAPER_MAX_LOGICAL_PROCESSORS / WordBits;
+		uint64 m_Words[WordCount] = {};
+
+	public:
+		static constexpr uint32 MaxProcessors = GREAPER_MAX_LOGICAL_PROCESSORS;
+
+		constexpr CPUSet() noexcept = default;
+
+		static CPUSet FromProcessor(uint32 processor) noexcept
+		{
+			CPUSet set;
+			set.Set(processor);
+			return set;
+		}
+
+		INLINE void Set(uint32 processor, bool value = true) noexcept
+		{
+			VerifyLess(processor, MaxProcessors, "Trying to set an out of bounds logical processor.");
+			const auto mask = uint64(1) << (processor % WordBits);
+			if (value)
+				m_Words[processor / WordBits] |= mask;
+			else
+				m_Words[processor / WordBits] &= ~mask;
+		}
+
+		[[nodiscard]] INLINE bool Test(uint32 processor)const noexcept
+		{
+			if (processor >= MaxProcessors)
+				return false;
+			return (m_Words[processor / WordBits] & (uint64(1) << (processor % WordBits))) != 0;
+		}
+
+		[[nodiscard]] INLINE uint32 Count()const noexcept
+		{
+			uint32 count = 0;
+			for (const auto word : m_Words)
+			{
+				auto w = word;
+				for (; w != 0; w &= w - 1)
+					++count;
+			}
+			return count;
+		}
+
+		[[nodiscard]] INLINE bool IsEmpty()const noexcept
+		{
+			for (const auto word : m_Words)
+			{
+				if (word != 0)
+					return false;
+			}
+			return true;
+		}
+
+		/** Returns the lowest logical processor in the set, or MaxProcessors if empty */
+		[[nodiscard]] INLINE uint32 First()const noexcept
+		{
+			for (uint32 i = 0; i < WordCount; ++i)
+			{
+				if (m_Words[i] == 0)
+					continue;
+				uint32 bit = 0;
+				while ((m_Words[i] & (uint64(1) << bit)) == 0)
+					++bit;
+				return i * WordBits + bit;
+			}
+			return MaxProcessors;
+		}
+
+		[[nodiscard]] INLINE uint64 GetWord(uint32 index)const noexcept { return m_Words[index]; }
+
+		[[nodiscard]] static constexpr uint32 GetWordCount() noexcept { return WordCount; }
+
+		CPUSet& operator|=(const CPUSet& other) noexcept
+		{
+			for (uint32 i = 0; i < WordCount; ++i)
+				m_Words[i] |= other.m_Words[i];
+			return *this;
+		}
+
+		CPUSet& operator&=(const CPUSet& other) noexcept
+		{
+			for (uint32 i = 0; i < WordCount; ++i)
+				m_Words[i] &= other.m_Words[i];
+			return *this;
+		}
+
+		bool operator==(const CPUSet& other)const noexcept
+		{
+			for (uint32 i = 0; i < WordCount; ++i)
+			{
+				if (m_Words[i] != other.m_Words[i])
+					return false;
+			}
+			return true;
+		}
+
+		bool operator!=(const CPUSet& other)const noexcept { return !(*this == other); }
+	};
+
+	struct CPUCacheInfo
+	{
+		uint8 Level = 0;
+		bool IsData = true;
+		bool IsInstruction = false;
+		uint32 SizeBytes = 0;
+		uint32 LineSize = 0;
+		CPUSet SharedBy;
+	};
+
+	struct CPUCoreInfo
+	{
+		uint32 PackageID = 0;
+		uint32 NUMANode = 0;
+		CPUSet LogicalProcessors; // SMT siblings of this physical core
+	};
+
+	struct NUMANodeInfo
+	{
+		uint32 ID = 0;
+		CPUSet LogicalProcessors;
+	};
+
+	struct CPUTopology
+	{
+		uint32 LogicalProcessorCount = 0;
+		uint32 PackageCount = 0;
+		Vector<CPUCoreInfo> Cores;
+		Vector<CPUCacheInfo> Caches;
+		Vector<NUMANodeInfo> NUMANodes;
+
+		[[nodiscard]] uint32 GetPhysicalCoreCount()const noexcept { return static_cast<uint32>(Cores.size()); }
+
+		[[nodiscard]] bool HasSMT()const noexcept { return LogicalProcessorCount > Cores.size(); }
+	};
+
+	/** Instruction set extensions that some code paths check for before using them */
+	struct CPUFeatures
+	{
+		bool SSE42 = false;
+		bool PCLMUL = false;
+		bool AVX2 = false;
+	};
+
+	/** Queried once, AVX2 is only reported if the OS also saves the YMM registers */
+	INLINE const CPUFeatures& GetCPUFeatures() noexcept
+	{
+		static const CPUFeatures features = []()
+		{
+			CPUFeatures f;
+#if COMPILER_MSVC
+			int info[4];
+			__cpuid(info, 0);
+			const auto maxLeaf = info[0];
+			__cpuid(info, 1);
+			f.SSE42 = (info[2] & (1 << 20)) != 0;
+			f.PCLMUL = (info[2] & (1 << 1)) != 0;
+			const bool osSavesYMM = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+			if (maxLeaf >= 7 && osSavesYMM)
+			{
+				__cpuidex(info, 7, 0);
+				f.AVX2 = (info[1] & (1 << 5)) != 0;
+			}
+#else
+			__builtin_cpu_init();
+			f.SSE42 = __builtin_cpu_supports("sse4.2") != 0;
+			f.PCLMUL = __builtin_cpu_supports("pclmul") != 0;
+			f.AVX2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+			return f;
+		}();
+		return features;
+	}
+}
+
+#endif /* CORE_CPU_INFO_H */
\ No newline at end of file
@@ -0,0 +1,538 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../Checksum.h"
+
+namespace greaper
+{
+	namespace Impl
+	{
+		/*** CRC32C ***/
+
+		static constexpr uint32 Crc32CPolynomial = 0x82F63B78; // Reflected 0x1EDC6F41
+
+		/** Slicing by 8, table k gives the CRC of a byte followed by k zero bytes */
+		static constexpr auto Crc32CTables = []()
+		{
+			std::array<std::array<uint32, 256>, 8> tables{};
+			for (uint32 i = 0; i < 256; ++i)
+			{
+				uint32 crc = i;
+				for (uint32 bit = 0; bit < 8; ++bit)
+					crc = (crc >> 1) ^ ((crc & 1) != 0 ? Crc32CPolynomial : 0);
+				tables[0][i] = crc;
+			}
+			for (uint32 i = 0; i < 256; ++i)
+			{
+				for (uint32 k = 1; k < 8; ++k)
+					tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+			}
+			return tables;
+		}();
+
+		/** x^exponent mod P in the reflected bit order the CRC uses */
+		constexpr uint32 Crc32CXPow(uint32 exponent) noexcept
+		{
+			uint32 value = 0x80000000; // x^0
+			for (uint32 i = 0; i < exponent; ++i)
+				value = (value >> 1) ^ ((value & 1) != 0 ? Crc32CPolynomial : 0);
+			return value;
+		}
+
+		INLINE uint32 Crc32CUpdatePortable(uint32 crc, const uint8* data, sizet size) noexcept
+		{
+			const auto& t = Crc32CTables;
+			for (; size >= 8; data += 8, size -= 8)
+			{
+				const auto lo = ReadUnaligned<uint32>(data) ^ crc;
+				const auto hi = ReadUnaligned<uint32>(data + 4);
+				crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+					^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+			}
+			for (; size > 0; ++data, --size)
+				crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+			return crc;
+		}
+
+#if ARCHITECTURE_X64
+		TARGET_ISA("sse4.2") uint32 Crc32CUpdateSSE42(uint32 crc, const uint8* data, sizet size) noexcept
+		{
+			uint64 crc64 = crc;
+			for (; size >= 8; data += 8, size -= 8)
+				crc64 = _mm_crc32_u64(crc64, ReadUnaligned<uint64>(data));
+			crc = (uint32)crc64;
+			for (; size > 0; ++data, --size)
+				crc = _mm_crc32_u8(crc, *data);
+			return crc;
+		}
+
+		static constexpr sizet Crc32CLaneSize = 1024;
+		// Moving a CRC over n bytes is a multiplication by x^(8n), the clmul and the final crc32 add 33 more
+		static constexpr uint32 Crc32CShiftOneLane = Crc32CXPow(8 * Crc32CLaneSize - 33);
+		static constexpr uint32 Crc32CShiftTwoLanes = Crc32CXPow(2 * 8 * Crc32CLaneSize - 33);
+
+		/**
+		 * crc32 has a latency of three cycles but a throughput of one, so three
+		 * consecutive lanes are run at once and merged by shifting the first two
+		 * past the ones after them with a carry-less multiply.
+		 */
+		TARGET_ISA("sse4.2,pclmul") uint32 Crc32CUpdateCLMUL(uint32 crc, const uint8* data, sizet size) noexcept
+		{
+			const auto shiftOne = _mm_cvtsi32_si128((int)Crc32CShiftOneLane);
+			const auto shiftTwo = _mm_cvtsi32_si128((int)Crc32CShiftTwoLanes);
+			for (; size >= 3 * Crc32CLaneSize; data += 3 * Crc32CLaneSize, size -= 3 * Crc32CLaneSize)
+			{
+				uint64 crcA = crc;
+				uint64 crcB = 0;
+				uint64 crcC = 0;
+				for (sizet i = 0; i < Crc32CLaneSize; i += 8)
+				{
+					crcA = _mm_crc32_u64(crcA, ReadUnaligned<uint64>(data + i));
+					crcB = _mm_crc32_u64(crcB, ReadUnaligned<uint64>(data + Crc32CLaneSize + i));
+					crcC = _mm_crc32_u64(crcC, ReadUnaligned<uint64>(data + 2 * Crc32CLaneSize + i));
+				}
+				const auto movedA = _mm_clmulepi64_si128(_mm_cvtsi64_si128((int64)crcA), shiftTwo, 0x00);
+				const auto movedB = _mm_clmulepi64_si128(_mm_cvtsi64_si128((int64)crcB), shiftOne, 0x00);
+				crc = (uint32)_mm_crc32_u64(0, (uint64)_mm_cvtsi128_si64(_mm_xor_si128(movedA, movedB))) ^ (uint32)crcC;
+			}
+			return Crc32CUpdateSSE42(crc, data, size);
+		}
+#endif
+
+		/*** XXH3 ***/
+
+		static constexpr uint32 XXH3Prime32_1 = 0x9E3779B1U;
+		static constexpr uint32 XXH3Prime32_2 = 0x85EBCA77U;
+		static constexpr uint32 XXH3Prime32_3 = 0xC2B2AE3DU;
+		static constexpr uint64 XXH3Prime64_1 = 0x9E3779B185EBCA87ULL;
+		static constexpr uint64 XXH3Prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+		static constexpr uint64 XXH3Prime64_3 = 0x165667B19E3779F9ULL;
+		static constexpr uint64 XXH3Prime64_4 = 0x85EBCA77C2B2AE63ULL;
+		static constexpr uint64 XXH3Prime64_5 = 0x27D4EB2F165667C5ULL;
+		static constexpr uint64 XXH3PrimeMX1 = 0x165667919E3779F9ULL;
+		static constexpr uint64 XXH3PrimeMX2 = 0x9FB21C651E98DF25ULL;
+
+		static constexpr sizet XXH3StripeSize = 64;
+		static constexpr sizet XXH3SecretSize = 192;
+		static constexpr sizet XXH3StripesPerBlock = (XXH3SecretSize - XXH3StripeSize) / 8;
+		static constexpr sizet XXH3BlockSize = XXH3StripeSize * XXH3StripesPerBlock;
+		static constexpr sizet XXH3MidSizeMax = 240;
+
+		alignas(64) static constexpr uint8 XXH3Secret[XXH3SecretSize] =
+		{
+			0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+			0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+			0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+			0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+			0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+			0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+			0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+			0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+			0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+			0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+			0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+			0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+		};
+
+		INLINE uint64 XXH3Rotl64(uint64 value, uint32 bits) noexcept
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		INLINE uint64 XXH3Swap64(uint64 value) noexcept
+		{
+			value = ((value & 0x00000000FFFFFFFFULL) << 32) | (value >> 32);
+			value = ((value & 0x0000FFFF0000FFFFULL) << 16) | ((value >> 16) & 0x0000FFFF0000FFFFULL);
+			return ((value & 0x00FF00FF00FF00FFULL) << 8) | ((value >> 8) & 0x00FF00FF00FF00FFULL);
+		}
+
+		/** 64x64 to 128 bit multiply, returns both halves xored */
+		INLINE uint64 XXH3MulFold64(uint64 lhs, uint64 rhs) noexcept
+		{
+#if COMPILER_MSVC
+			uint64 high;
+			const uint64 low = _umul128(lhs, rhs, &high);
+			return low ^ high;
+#else
+			const auto product = (unsigned __int128)lhs * rhs;
+			return (uint64)product ^ (uint64)(product >> 64);
+#endif
+		}
+
+		INLINE uint64 XXH64Avalanche(uint64 hash) noexcept
+		{
+			hash ^= hash >> 33;
+			hash *= XXH3Prime64_2;
+			hash ^= hash >> 29;
+			hash *= XXH3Prime64_3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		INLINE uint64 XXH3Avalanche(uint64 hash) noexcept
+		{
+			hash ^= hash >> 37;
+			hash *= XXH3PrimeMX1;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		INLINE uint64 XXH3Mix16B(const uint8* data, const uint8* secret) noexcept
+		{
+			return XXH3MulFold64(ReadUnaligned<uint64>(data) ^ ReadUnaligned<uint64>(secret), ReadUnaligned<uint64>(data + 8) ^ ReadUnaligned<uint64>(secret + 8));
+		}
+
+		INLINE uint64 XXH3Hash0To16(const uint8* data, sizet size) noexcept
+		{
+			const auto* secret = XXH3Secret;
+			if (size > 8)
+			{
+				const auto low = ReadUnaligned<uint64>(data) ^ (ReadUnaligned<uint64>(secret + 24) ^ ReadUnaligned<uint64>(secret + 32));
+				const auto high = ReadUnaligned<uint64>(data + size - 8) ^ (ReadUnaligned<uint64>(secret + 40) ^ ReadUnaligned<uint64>(secret + 48));
+				return XXH3Avalanche(size + XXH3Swap64(low) + high + XXH3MulFold64(low, high));
+			}
+			if (size >= 4)
+			{
+				const auto input = (uint64)ReadUnaligned<uint32>(data + size - 4) + ((uint64)ReadUnaligned<uint32>(data) << 32);
+				auto hash = input ^ (ReadUnaligned<uint64>(secret + 8) ^ ReadUnaligned<uint64>(secret + 16));
+				hash ^= XXH3Rotl64(hash, 49) ^ XXH3Rotl64(hash, 24);
+				hash *= XXH3PrimeMX2;
+				hash ^= (hash >> 35) + size;
+				hash *= XXH3PrimeMX2;
+				return hash ^ (hash >> 28);
+			}
+			if (size > 0)
+			{
+				const auto combined = ((uint32)data[0] << 16) | ((uint32)data[size >> 1] << 24) | (uint32)data[size - 1] | ((uint32)size << 8);
+				return XXH64Avalanche((uint64)combined ^ (uint64)(ReadUnaligned<uint32>(secret) ^ ReadUnaligned<uint32>(secret + 4)));
+			}
+			return XXH64Avalanche(ReadUnaligned<uint64>(secret + 56) ^ ReadUnaligned<uint64>(secret + 64));
+		}
+
+		INLINE uint64 XXH3Hash17To128(const uint8* data, sizet size) noexcept
+		{
+			const auto* secret = XXH3Secret;
+			uint64 acc = size * XXH3Prime64_1;
+			if (size > 32)
+			{
+				if (size > 64)
+				{
+					if (size > 96)
+					{
+						acc += XXH3Mix16B(data + 48, secret + 96);
+						acc += XXH3Mix16B(data + size - 64, secret + 112);
+					}
+					acc += XXH3Mix16B(data + 32, secret + 64);
+					acc += XXH3Mix16B(data + size - 48, secret + 80);
+				}
+				acc += XXH3Mix16B(data + 16, secret + 32);
+				acc += XXH3Mix16B(data + size - 32, secret + 48);
+			}
+			acc += XXH3Mix16B(data, secret);
+			acc += XXH3Mix16B(data + size - 16, secret + 16);
+			return XXH3Avalanche(acc);
+		}
+
+		INLINE uint64 XXH3Hash129To240(const uint8* data, sizet size) noexcept
+		{
+			const auto* secret = XXH3Secret;
+			uint64 acc = size * XXH3Prime64_1;
+			const auto rounds = size / 16;
+			for (sizet i = 0; i < 8; ++i)
+				acc += XXH3Mix16B(data + 16 * i, secret + 16 * i);
+			acc = XXH3Avalanche(acc);
+			for (sizet i = 8; i < rounds; ++i)
+				acc += XXH3Mix16B(data + 16 * i, secret + 16 * (i - 8) + 3);
+			acc += XXH3Mix16B(data + size - 16, secret + 136 - 17);
+			return XXH3Avalanche(acc);
+		}
+
+		INLINE void XXH3AccumulateStripeScalar(uint64* acc, const uint8* data, const uint8* secret) noexcept
+		{
+			for (sizet i = 0; i < 8; ++i)
+			{
+				const auto value = ReadUnaligned<uint64>(data + 8 * i);
+				const auto key = value ^ ReadUnaligned<uint64>(secret + 8 * i);
+				acc[i ^ 1] += value;
+				acc[i] += (uint64)(uint32)key * (key >> 32);
+			}
+		}
+
+		INLINE void XXH3AccumulateScalar(uint64* acc, const uint8* data, const uint8* secret, sizet stripes) noexcept
+		{
+			for (sizet s = 0; s < stripes; ++s)
+				XXH3AccumulateStripeScalar(acc, data + s * XXH3StripeSize, secret + s * 8);
+		}
+
+		INLINE void XXH3ScrambleScalar(uint64* acc, const uint8* secret) noexcept
+		{
+			for (sizet i = 0; i < 8; ++i)
+			{
+				auto value = acc[i];
+				value ^= value >> 47;
+				value ^= ReadUnaligned<uint64>(secret + 8 * i);
+				acc[i] = value * XXH3Prime32_1;
+			}
+		}
+
+#if ARCHITECTURE_X64
+		/** Same as the scalar version, each 256 bit lane holds four of the eight accumulators */
+		TARGET_ISA("avx2") void XXH3AccumulateAVX2(uint64* acc, const uint8* data, const uint8* secret, sizet stripes) noexcept
+		{
+			auto acc0 = _mm256_load_si256((const __m256i*)acc);
+			auto acc1 = _mm256_load_si256((const __m256i*)(acc + 4));
+			for (sizet s = 0; s < stripes; ++s)
+			{
+				const auto* stripe = data + s * XXH3StripeSize;
+				const auto* key = secret + s * 8;
+				const auto value0 = _mm256_loadu_si256((const __m256i*)stripe);
+				const auto value1 = _mm256_loadu_si256((const __m256i*)(stripe + 32));
+				const auto keyed0 = _mm256_xor_si256(value0, _mm256_loadu_si256((const __m256i*)key));
+				const auto keyed1 = _mm256_xor_si256(value1, _mm256_loadu_si256((const __m256i*)(key + 32)));
+				const auto product0 = _mm256_mul_epu32(keyed0, _mm256_srli_epi64(keyed0, 32));
+				const auto product1 = _mm256_mul_epu32(keyed1, _mm256_srli_epi64(keyed1, 32));
+				acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(product0, _mm256_shuffle_epi32(value0, _MM_SHUFFLE(1, 0, 3, 2))));
+				acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(product1, _mm256_shuffle_epi32(value1, _MM_SHUFFLE(1, 0, 3, 2))));
+			}
+			_mm256_store_si256((__m256i*)acc, acc0);
+			_mm256_store_si256((__m256i*)(acc + 4), acc1);
+		}
+
+		TARGET_ISA("avx2") void XXH3ScrambleAVX2(uint64* acc, const uint8* secret) noexcept
+		{
+			const auto prime = _mm256_set1_epi32((int)XXH3Prime32_1);
+			for (sizet i = 0; i < 2; ++i)
+			{
+				auto value = _mm256_load_si256((const __m256i*)(acc + 4 * i));
+				value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+				value = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i*)(secret + 32 * i)));
+				const auto low = _mm256_mul_epu32(value, prime);
+				const auto high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+				_mm256_store_si256((__m256i*)(acc + 4 * i), _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+			}
+		}
+#endif
+
+		/** Accumulates consecutive stripes, the secret moves 8 bytes per stripe, acc must be 32 byte aligned */
+		INLINE void XXH3Accumulate(uint64* acc, const uint8* data, const uint8* secret, sizet stripes) noexcept
+		{
+#if ARCHITECTURE_X64
+			if (GetCPUFeatures().AVX2)
+			{
+				XXH3AccumulateAVX2(acc, data, secret, stripes);
+				return;
+			}
+#endif
+			XXH3AccumulateScalar(acc, data, secret, stripes);
+		}
+
+		INLINE void XXH3Scramble(uint64* acc, const uint8* secret) noexcept
+		{
+#if ARCHITECTURE_X64
+			if (GetCPUFeatures().AVX2)
+			{
+				XXH3ScrambleAVX2(acc, secret);
+				return;
+			}
+#endif
+			XXH3ScrambleScalar(acc, secret);
+		}
+
+		INLINE void XXH3InitAcc(uint64* acc) noexcept
+		{
+			acc[0] = XXH3Prime32_3;
+			acc[1] = XXH3Prime64_1;
+			acc[2] = XXH3Prime64_2;
+			acc[3] = XXH3Prime64_3;
+			acc[4] = XXH3Prime64_4;
+			acc[5] = XXH3Prime32_2;
+			acc[6] = XXH3Prime64_5;
+			acc[7] = XXH3Prime32_1;
+		}
+
+		INLINE uint64 XXH3MergeAccs(const uint64* acc, uint64 totalSize) noexcept
+		{
+			const auto* secret = XXH3Secret + 11;
+			uint64 result = totalSize * XXH3Prime64_1;
+			for (sizet i = 0; i < 4; ++i)
+				result += XXH3MulFold64(acc[2 * i] ^ ReadUnaligned<uint64>(secret + 16 * i), acc[2 * i + 1] ^ ReadUnaligned<uint64>(secret + 16 * i + 8));
+			return XXH3Avalanche(result);
+		}
+
+		/** Accumulates the last stripe, which overlaps the previous ones unless the size is a multiple of a stripe */
+		INLINE void XXH3AccumulateLastStripe(uint64* acc, const uint8* stripe) noexcept
+		{
+			XXH3Accumulate(acc, stripe, XXH3Secret + XXH3SecretSize - XXH3StripeSize - 7, 1);
+		}
+
+		uint64 XXH3HashLong(const uint8* data, sizet size) noexcept
+		{
+			alignas(32) uint64 acc[8];
+			XXH3InitAcc(acc);
+			const auto blocks = (size - 1) / XXH3BlockSize;
+			for (sizet b = 0; b < blocks; ++b)
+			{
+				XXH3Accumulate(acc, data + b * XXH3BlockSize, XXH3Secret, XXH3StripesPerBlock);
+				XXH3Scramble(acc, XXH3Secret + XXH3SecretSize - XXH3StripeSize);
+			}
+			const auto stripes = ((size - 1) - XXH3BlockSize * blocks) / XXH3StripeSize;
+			XXH3Accumulate(acc, data + blocks * XXH3BlockSize, XXH3Secret, stripes);
+			XXH3AccumulateLastStripe(acc, data + size - XXH3StripeSize);
+			return XXH3MergeAccs(acc, (uint64)size);
+		}
+
+		uint64 XXH3Hash64(const uint8* data, sizet size) noexcept
+		{
+			if (size <= 16)
+				return XXH3Hash0To16(data, size);
+			if (size <= 128)
+				return XXH3Hash17To128(data, size);
+			if (size <= XXH3MidSizeMax)
+				return XXH3Hash129To240(data, size);
+			return XXH3HashLong(data, size);
+		}
+
+		/** Streaming counterpart of the block loop in XXH3HashLong, scrambling whenever a block gets full */
+		INLINE void XXH3ConsumeStripes(uint64* acc, sizet& stripesSoFar, const uint8* data, sizet stripes) noexcept
+		{
+			if (XXH3StripesPerBlock - stripesSoFar <= stripes)
+			{
+				const auto toBlockEnd = XXH3StripesPerBlock - stripesSoFar;
+				XXH3Accumulate(acc, data, XXH3Secret + stripesSoFar * 8, toBlockEnd);
+				XXH3Scramble(acc, XXH3Secret + XXH3SecretSize - XXH3StripeSize);
+				XXH3Accumulate(acc, data + toBlockEnd * XXH3StripeSize, XXH3Secret, stripes - toBlockEnd);
+				stripesSoFar = stripes - toBlockEnd;
+			}
+			else
+			{
+				XXH3Accumulate(acc, data, XXH3Secret + stripesSoFar * 8, stripes);
+				stripesSoFar += stripes;
+			}
+		}
+	}
+
+	void Crc32C::Update(const void* data, const sizet size) noexcept
+	{
+		const auto* bytes = (const uint8*)data;
+#if ARCHITECTURE_X64
+		const auto& features = GetCPUFeatures();
+		if (features.SSE42 && features.PCLMUL)
+		{
+			m_State = Impl::Crc32CUpdateCLMUL(m_State, bytes, size);
+			return;
+		}
+		if (features.SSE42)
+		{
+			m_State = Impl::Crc32CUpdateSSE42(m_State, bytes, size);
+			return;
+		}
+#endif
+		m_State = Impl::Crc32CUpdatePortable(m_State, bytes, size);
+	}
+
+	uint32 Crc32C::Compute(const std::span<const uint8> data) noexcept
+	{
+		Crc32C crc;
+		crc.Update(data);
+		return crc.GetValue();
+	}
+
+	XXH3Hash::XXH3Hash() noexcept
+	{
+		Reset();
+	}
+
+	void XXH3Hash::Reset() noexcept
+	{
+		Impl::XXH3InitAcc(m_Acc);
+		m_BufferedSize = 0;
+		m_StripesSoFar = 0;
+		m_TotalSize = 0;
+	}
+
+	void XXH3Hash::Update(const void* data, sizet size) noexcept
+	{
+		using namespace Impl;
+		constexpr auto bufferStripes = BufferSize / XXH3StripeSize;
+
+		const auto* bytes = (const uint8*)data;
+		m_TotalSize += size;
+		if (m_BufferedSize + size <= BufferSize)
+		{
+			memcpy(m_Buffer + m_BufferedSize, bytes, size);
+			m_BufferedSize += size;
+			return;
+		}
+
+		// At least one byte is always left buffered, the digest needs a last stripe to finish with
+		if (m_BufferedSize > 0)
+		{
+			const auto fill = BufferSize - m_BufferedSize;
+			memcpy(m_Buffer + m_BufferedSize, bytes, fill);
+			bytes += fill;
+			size -= fill;
+			XXH3ConsumeStripes(m_Acc, m_StripesSoFar, m_Buffer, bufferStripes);
+			m_BufferedSize = 0;
+		}
+
+		if (size > BufferSize)
+		{
+			// Goes straight from the input, consuming at most a block at a time so it wraps once at most
+			const auto stripes = (size - 1) / XXH3StripeSize;
+			for (sizet done = 0; done < stripes;)
+			{
+				const auto count = Min(stripes - done, XXH3StripesPerBlock);
+				XXH3ConsumeStripes(m_Acc, m_StripesSoFar, bytes + done * XXH3StripeSize, count);
+				done += count;
+			}
+			const auto consumed = stripes * XXH3StripeSize;
+			// Keeps the stripe before the remaining bytes, the digest may need part of it
+			memcpy(m_Buffer + BufferSize - XXH3StripeSize, bytes + consumed - XXH3StripeSize, XXH3StripeSize);
+			bytes += consumed;
+			size -= consumed;
+		}
+
+		memcpy(m_Buffer, bytes, size);
+		m_BufferedSize = size;
+	}
+
+	uint64 XXH3Hash::GetValue()const noexcept
+	{
+		using namespace Impl;
+		if (m_TotalSize <= XXH3MidSizeMax)
+			return XXH3Hash64(m_Buffer, (sizet)m_TotalSize);
+
+		alignas(32) uint64 acc[8];
+		memcpy(acc, m_Acc, sizeof(acc));
+		if (m_BufferedSize >= XXH3StripeSize)
+		{
+			auto stripesSoFar = m_StripesSoFar;
+			XXH3ConsumeStripes(acc, stripesSoFar, m_Buffer, (m_BufferedSize - 1) / XXH3StripeSize);
+			XXH3AccumulateLastStripe(acc, m_Buffer + m_BufferedSize - XXH3StripeSize);
+		}
+		else
+		{
+			// The last stripe starts in the previous buffer contents
+			uint8 lastStripe[XXH3StripeSize];
+			const auto fromPrevious = XXH3StripeSize - m_BufferedSize;
+			memcpy(lastStripe, m_Buffer + BufferSize - fromPrevious, fromPrevious);
+			memcpy(lastStripe + fromPrevious, m_Buffer, m_BufferedSize);
+			XXH3AccumulateLastStripe(acc, lastStripe);
+		}
+		return XXH3MergeAccs(acc, m_TotalSize);
+	}
+
+	uint64 XXH3Hash::Compute(const std::span<const uint8> data) noexcept
+	{
+		return Impl::XXH3Hash64(data.data(), data.size());
+	}
+
+	uint64 Checksum(const std::span<const uint8> data, const ChecksumAlgorithm_t algorithm) noexcept
+	{
+		if (algorithm == ChecksumAlgorithm_t::CRC32C)
+			return (uint64)Crc32C::Compute(data);
+		return XXH3Hash::Compute(data);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../ChecksumStream.h"
+
+namespace greaper
+{
+	sizet ChecksumStream::GetReadable(const sizet count)const
+	{
+		if (m_Config.Trailer != ChecksumTrailer_t::Check)
+			return count;
+		return Min(count, (sizet)Max<ssizet>(m_Size - m_Position, 0));
+	}
+
+	void ChecksumStream::Hash(const std::span<const uint8> data)const
+	{
+		m_Checksum.Update(data);
+		m_Position += (ssizet)data.size();
+	}
+
+	void ChecksumStream::HashVecs(const std::span<const IOVec> vecs, sizet size)const
+	{
+		for (const auto& vec : vecs)
+		{
+			if (size == 0)
+				break;
+			const auto piece = Min(size, vec.Size);
+			Hash({ (const uint8*)vec.Data, piece });
+			size -= piece;
+		}
+	}
+
+	ChecksumStream::ChecksumStream(SPtr<IStream> inner, const ChecksumStreamConfig& config)
+		:IStream(inner != nullptr ? inner->GetName() : StringView{}, inner != nullptr ? inner->GetAccessMode() : (uint16)READ)
+		,m_Inner(std::move(inner))
+		,m_Config(config)
+		,m_Checksum(config.Algorithm)
+		,m_Position(0)
+	{
+		VerifyNotNull(m_Inner, "Trying to create a ChecksumStream without a stream to wrap.");
+		m_Size = 0;
+		if (m_Config.Trailer == ChecksumTrailer_t::Check)
+		{
+			Verify(IsReadable(), "Trying to verify the checksum trailer of a stream that can't be read.");
+			const auto trailerSize = (ssizet)RunningChecksum::GetDigestSize(m_Config.Algorithm);
+			m_Size = Max<ssizet>(m_Inner->Size() - m_Inner->Tell() - trailerSize, 0);
+		}
+		else if (m_Config.Trailer == ChecksumTrailer_t::Append)
+		{
+			Verify(IsWritable(), "Trying to append a checksum trailer to a stream that can't be written.");
+		}
+	}
+
+	ChecksumStream::~ChecksumStream()
+	{
+		Close();
+	}
+
+	ssizet ChecksumStream::Read(void* buf, ssizet count)const
+	{
+		if (m_Inner == nullptr || count <= 0)
+			return 0;
+		const auto read = m_Inner->Read(buf, (ssizet)GetReadable((sizet)count));
+		if (read > 0)
+			Hash({ (const uint8*)buf, (sizet)read });
+		return read;
+	}
+
+	ssizet ChecksumStream::Write(const void* buf, ssizet count)
+	{
+		if (m_Inner == nullptr || count <= 0)
+			return 0;
+		const auto written = m_Inner->Write(buf, count);
+		if (written > 0)
+		{
+			Hash({ (const uint8*)buf, (sizet)written });
+			m_Size = Max(m_Size, m_Position);
+		}
+		return written;
+	}
+
+	ssizet ChecksumStream::ReadV(const std::span<const IOVec> vecs)const
+	{
+		if (m_Inner == nullptr)
+			return 0;
+		// The pieces would have to be cut at the trailer, Read already clamps
+		if (m_Config.Trailer == ChecksumTrailer_t::Check)
+			return IStream::ReadV(vecs);
+		const auto read = m_Inner->ReadV(vecs);
+		if (read > 0)
+			HashVecs(vecs, (sizet)read);
+		return read;
+	}
+
+	ssizet ChecksumStream::WriteV(const std::span<const IOVec> vecs)
+	{
+		if (m_Inner == nullptr)
+			return 0;
+		const auto written = m_Inner->WriteV(vecs);
+		if (written > 0)
+		{
+			HashVecs(vecs, (sizet)written);
+			m_Size = Max(m_Size, m_Position);
+		}
+		return written;
+	}
+
+	std::span<const uint8> ChecksumStream::ReadView(const sizet count)const
+	{
+		if (m_Inner == nullptr || count == 0)
+			return {};
+		const auto size = GetReadable(count);
+		if (size == 0)
+			return {};
+		const auto view = m_Inner->ReadView(size);
+		Hash(view);
+		return view;
+	}
+
+	std::span<uint8> ChecksumStream::WriteReserve(const sizet count)
+	{
+		m_Reserved = m_Inner != nullptr ? m_Inner->WriteReserve(count) : std::span<uint8>{};
+		return m_Reserved;
+	}
+
+	void ChecksumStream::WriteCommit(const sizet count)
+	{
+		VerifyLessEqual(count, m_Reserved.size(), "Trying to commit more bytes than reserved.");
+		if (m_Inner == nullptr)
+			return;
+		// Falling back to Write the inner stream may commit less, only what it took is hashed.
+		// The reserved bytes belong to the inner stream, they are still there after the commit
+		const auto before = m_Inner->Tell();
+		m_Inner->WriteCommit(count);
+		const auto committed = (sizet)Clamp<ssizet>(m_Inner->Tell() - before, 0, (ssizet)count);
+		Hash(m_Reserved.first(committed));
+		m_Size = Max(m_Size, m_Position);
+		m_Reserved = {};
+	}
+
+	void ChecksumStream::Skip(const ssizet count)
+	{
+		VerifyGreaterEqual(count, 0, "Trying to skip backwards on a ChecksumStream.");
+		constexpr sizet chunkSize = 64 * 1024;
+		auto left = (sizet)Max<ssizet>(count, 0);
+		while (left > 0 && m_Inner != nullptr)
+		{
+			const auto chunk = Min(left, chunkSize);
+			sizet done = IsReadable() ? ReadView(chunk).size() : 0;
+			if (done == 0 && IsWritable())
+			{
+				auto room = WriteReserve(chunk);
+				done = room.size();
+				if (done > 0)
+				{
+					memset(room.data(), 0, done);
+					WriteCommit(done);
+				}
+			}
+			if (done == 0)
+				break;
+			left -= done;
+		}
+	}
+
+	void ChecksumStream::Seek(const ssizet pos)
+	{
+		Skip(pos - Tell());
+	}
+
+	bool ChecksumStream::Eof()const
+	{
+		if (m_Inner == nullptr)
+			return true;
+		if (m_Config.Trailer == ChecksumTrailer_t::Check)
+			return m_Position >= m_Size;
+		return m_Inner->Eof();
+	}
+
+	SPtr<IStream> ChecksumStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		return SPtr<IStream>();
+	}
+
+	void ChecksumStream::Close()
+	{
+		if (m_Inner == nullptr)
+			return;
+		if (m_Config.Trailer == ChecksumTrailer_t::Append)
+		{
+			const auto value = m_Checksum.GetValue();
+			const auto trailerSize = (ssizet)RunningChecksum::GetDigestSize(m_Config.Algorithm);
+			// Little endian whatever the host is
+			uint8 trailer[sizeof(value)];
+			for (sizet i = 0; i < sizeof(trailer); ++i)
+				trailer[i] = (uint8)(value >> (i * 8));
+			const auto written = m_Inner->Write(trailer, trailerSize);
+			VerifyEqual(written, trailerSize, "Couldn't write the checksum trailer, Size:%d Written:%d.", trailerSize, written);
+		}
+		m_Inner.reset();
+	}
+
+	bool ChecksumStream::VerifyTrailer()
+	{
+		if (m_Inner == nullptr || m_Config.Trailer != ChecksumTrailer_t::Check)
+			return false;
+		Skip(m_Size - m_Position);
+		if (m_Position < m_Size)
+			return false;
+		uint8 trailer[sizeof(uint64)];
+		const auto trailerSize = (ssizet)RunningChecksum::GetDigestSize(m_Config.Algorithm);
+		if (m_Inner->Read(trailer, trailerSize) != trailerSize)
+			return false;
+		uint64 stored = 0;
+		for (ssizet i = 0; i < trailerSize; ++i)
+			stored |= (uint64)trailer[i] << (i * 8);
+		return stored == m_Checksum.GetValue();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,218 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../ChunkedMemoryStream.h"
+
+namespace greaper
+{
+	uint8* ChunkedMemoryStream::AcquireChunk()
+	{
+		if (m_Pool != nullptr)
+			return m_Pool->Acquire();
+		return (uint8*)Alloc(m_ChunkSize);
+	}
+
+	void ChunkedMemoryStream::ReleaseChunks()
+	{
+		for (auto* chunk : m_Chunks)
+		{
+			if (m_Pool != nullptr)
+				m_Pool->Release(chunk);
+			else
+				Dealloc(chunk);
+		}
+		m_Chunks.clear();
+	}
+
+	ChunkedMemoryStream::ChunkedMemoryStream(const sizet chunkSize)
+		:IStream(READ | WRITE)
+		,m_Pool(nullptr)
+		,m_ChunkSize(chunkSize)
+		,m_Position(0)
+		,m_ReservedInPlace(false)
+	{
+		VerifyGreater(m_ChunkSize, (sizet)0, "A ChunkedMemoryStream needs a chunk size.");
+		m_Size = 0;
+	}
+
+	ChunkedMemoryStream::ChunkedMemoryStream(MemoryChunkPool& pool)
+		:IStream(READ | WRITE)
+		,m_Pool(&pool)
+		,m_ChunkSize(pool.GetChunkSize())
+		,m_Position(0)
+		,m_ReservedInPlace(false)
+	{
+		m_Size = 0;
+	}
+
+	ChunkedMemoryStream::ChunkedMemoryStream(ChunkedMemoryStream&& other) noexcept
+		:IStream(READ | WRITE)
+		,m_Pool(other.m_Pool)
+		,m_ChunkSize(other.m_ChunkSize)
+		,m_Chunks(std::move(other.m_Chunks))
+		,m_Position(std::exchange(other.m_Position, 0))
+		,m_ReservedInPlace(false)
+	{
+		m_Size = std::exchange(other.m_Size, 0);
+		m_Name = std::move(other.m_Name);
+		m_Access = other.m_Access;
+		other.m_Chunks.clear();
+	}
+
+	ChunkedMemoryStream& ChunkedMemoryStream::operator=(ChunkedMemoryStream&& other) noexcept
+	{
+		if (this != &other)
+		{
+			ReleaseChunks();
+			m_Pool = other.m_Pool;
+			m_ChunkSize = other.m_ChunkSize;
+			m_Chunks = std::move(other.m_Chunks);
+			other.m_Chunks.clear();
+			m_Position = std::exchange(other.m_Position, 0);
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Name = std::move(other.m_Name);
+			m_Access = other.m_Access;
+		}
+		return *this;
+	}
+
+	ChunkedMemoryStream::~ChunkedMemoryStream()
+	{
+		Close();
+	}
+
+	ssizet ChunkedMemoryStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsReadable() || count <= 0)
+			return 0;
+
+		count = Min(count, m_Size - m_Position);
+		auto* dst = (uint8*)buf;
+		ssizet done = 0;
+		while (done < count)
+		{
+			const auto chunk = (sizet)m_Position / m_ChunkSize;
+			const auto offset = (sizet)m_Position % m_ChunkSize;
+			const auto size = Min((sizet)(count - done), m_ChunkSize - offset);
+			memcpy(dst + done, m_Chunks[chunk] + offset, size);
+			m_Position += (ssizet)size;
+			done += (ssizet)size;
+		}
+		return done;
+	}
+
+	ssizet ChunkedMemoryStream::Write(const void* buf, ssizet count)
+	{
+		if (!IsWritable() || count <= 0)
+			return 0;
+
+		const auto end = (sizet)(m_Position + count);
+		while (m_Chunks.size() * m_ChunkSize < end)
+			m_Chunks.push_back(AcquireChunk());
+
+		const auto* src = (const uint8*)buf;
+		ssizet done = 0;
+		while (done < count)
+		{
+			const auto chunk = (sizet)m_Position / m_ChunkSize;
+			const auto offset = (sizet)m_Position % m_ChunkSize;
+			const auto size = Min((sizet)(count - done), m_ChunkSize - offset);
+			memcpy(m_Chunks[chunk] + offset, src + done, size);
+			m_Position += (ssizet)size;
+			done += (ssizet)size;
+		}
+		m_Size = Max(m_Size, m_Position);
+		return done;
+	}
+
+	std::span<const uint8> ChunkedMemoryStream::ReadView(sizet count)const
+	{
+		if (!IsReadable())
+			return {};
+
+		count = Min(count, (sizet)(m_Size - m_Position));
+		if (count == 0)
+			return {};
+		const auto offset = (sizet)m_Position % m_ChunkSize;
+		if (offset + count > m_ChunkSize)
+			return IStream::ReadView(count);
+
+		const auto view = std::span<const uint8>(m_Chunks[(sizet)m_Position / m_ChunkSize] + offset, count);
+		m_Position += (ssizet)count;
+		return view;
+	}
+
+	std::span<uint8> ChunkedMemoryStream::WriteReserve(const sizet count)
+	{
+		m_ReservedInPlace = false;
+		if (!IsWritable() || count == 0)
+			return {};
+
+		const auto offset = (sizet)m_Position % m_ChunkSize;
+		if (offset + count > m_ChunkSize)
+			return IStream::WriteReserve(count);
+
+		const auto chunk = (sizet)m_Position / m_ChunkSize;
+		while (m_Chunks.size() <= chunk)
+			m_Chunks.push_back(AcquireChunk());
+		m_ReservedInPlace = true;
+		return { m_Chunks[chunk] + offset, count };
+	}
+
+	void ChunkedMemoryStream::WriteCommit(const sizet count)
+	{
+		if (!m_ReservedInPlace)
+		{
+			IStream::WriteCommit(count);
+			return;
+		}
+		m_ReservedInPlace = false;
+		m_Position += (ssizet)count;
+		m_Size = Max(m_Size, m_Position);
+	}
+
+	void ChunkedMemoryStream::Skip(const ssizet count)
+	{
+		Seek(Tell() + count);
+	}
+
+	void ChunkedMemoryStream::Seek(const ssizet pos)
+	{
+		VerifyLessEqual(pos, m_Size, "Trying to seek a ChunkedMemoryStream outside of its bounds.");
+		VerifyGreaterEqual(pos, 0, "Trying to seek a ChunkedMemoryStream outside of its bounds.");
+		m_Position = Clamp(pos, (ssizet)0, m_Size);
+	}
+
+	SPtr<IStream> ChunkedMemoryStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		auto clone = m_Pool != nullptr ? std::make_shared<ChunkedMemoryStream>(*m_Pool) : std::make_shared<ChunkedMemoryStream>(m_ChunkSize);
+		for (const auto& segment : GetSegments())
+			clone->Write(segment.Data, (ssizet)segment.Size);
+		clone->m_Access = m_Access;
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void ChunkedMemoryStream::Close()
+	{
+		ReleaseChunks();
+		m_Position = 0;
+		m_Size = 0;
+	}
+
+	Vector<IOVec> ChunkedMemoryStream::GetSegments()const
+	{
+		Vector<IOVec> segments;
+		segments.reserve(m_Chunks.size());
+		for (sizet i = 0, remaining = (sizet)m_Size; remaining > 0; ++i)
+		{
+			const auto size = Min(remaining, m_ChunkSize);
+			segments.push_back(IOVec{ m_Chunks[i], size });
+			remaining -= size;
+		}
+		return segments;
+	}
+}
\ No newline at end of file
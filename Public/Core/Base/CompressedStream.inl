@@ -0,0 +1,424 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../CompressedStream.h"
+
+namespace greaper
+{
+	bool CompressedWriterStream::WriteBlock(const uint8* data, const sizet size)
+	{
+		const auto packedSize = m_Compressor.Compress({ data, size }, m_Packed, m_Config.Level);
+		Impl::CompressedBlockHeader header{ (uint32)size, (uint32)packedSize };
+		const uint8* payload = m_Packed.data();
+		if (packedSize >= size)
+		{
+			header.PackedSize = (uint32)size | Impl::CompressedBlockStored;
+			payload = data;
+		}
+		const auto payloadSize = Min(packedSize, size);
+		uint8 headerBytes[Impl::CompressedHeaderSize];
+		Impl::StoreCompressedHeader(headerBytes, header.RawSize, header.PackedSize);
+		const IOVec vecs[] = { { headerBytes, sizeof(headerBytes) }, { (void*)payload, payloadSize } };
+		if (m_Inner->WriteV(vecs) != (ssizet)(sizeof(headerBytes) + payloadSize))
+			m_Failed = true;
+		return !m_Failed;
+	}
+
+	bool CompressedWriterStream::FlushBlock()
+	{
+		if (m_Failed)
+			return false;
+		if (m_Fill == 0)
+			return true;
+		const auto written = WriteBlock(m_Block.data(), m_Fill);
+		m_Fill = 0;
+		return written;
+	}
+
+	CompressedWriterStream::CompressedWriterStream(SPtr<IStream> inner, const CompressedStreamConfig& config)
+		:IStream(inner != nullptr ? inner->GetName() : StringView{}, WRITE)
+		,m_Inner(std::move(inner))
+		,m_Config(config)
+		,m_Fill(0)
+		,m_ReservedInPlace(false)
+		,m_Failed(false)
+	{
+		VerifyNotNull(m_Inner, "Trying to create a CompressedWriterStream without a stream to write to.");
+		m_Size = 0;
+		m_Config.BlockSize = Clamp(m_Config.BlockSize, Impl::CompressedStreamMinBlockSize, Impl::CompressedStreamMaxBlockSize);
+		m_Block.resize(m_Config.BlockSize);
+		m_Packed.resize(LZCompressBound(m_Config.BlockSize));
+
+		uint8 header[Impl::CompressedHeaderSize];
+		Impl::StoreCompressedHeader(header, Impl::CompressedStreamMagic, m_Config.BlockSize);
+		const auto written = m_Inner->Write(header, sizeof(header));
+		m_Failed = written != (ssizet)sizeof(header);
+		VerifyEqual(written, (ssizet)sizeof(header), "Couldn't write the CompressedWriterStream header, Written:%d.", written);
+	}
+
+	CompressedWriterStream::~CompressedWriterStream()
+	{
+		Close();
+	}
+
+	ssizet CompressedWriterStream::Read(void* buf, ssizet count)const
+	{
+		UNUSED(buf);
+		UNUSED(count);
+		return 0;
+	}
+
+	ssizet CompressedWriterStream::Write(const void* buf, ssizet count)
+	{
+		if (m_Inner == nullptr || m_Failed || count <= 0)
+			return 0;
+
+		const auto* src = (const uint8*)buf;
+		const sizet blockSize = m_Config.BlockSize;
+		sizet done = 0;
+		while (done < (sizet)count)
+		{
+			const auto left = (sizet)count - done;
+			if (m_Fill == 0 && left >= blockSize)
+			{
+				// Whole blocks are compressed straight from the caller's buffer
+				if (!WriteBlock(src + done, blockSize))
+					break;
+				done += blockSize;
+				continue;
+			}
+			const auto size = Min(left, blockSize - m_Fill);
+			memcpy(m_Block.data() + m_Fill, src + done, size);
+			m_Fill += size;
+			// Lost with the block, these bytes are not reported as written
+			if (m_Fill == blockSize && !FlushBlock())
+				break;
+			done += size;
+		}
+		m_Size += (ssizet)done;
+		return (ssizet)done;
+	}
+
+	std::span<uint8> CompressedWriterStream::WriteReserve(const sizet count)
+	{
+		m_ReservedInPlace = false;
+		if (m_Inner == nullptr || m_Failed || count == 0)
+			return {};
+		if (count > m_Config.BlockSize)
+			return IStream::WriteReserve(count);
+		if (m_Fill + count > m_Config.BlockSize && !FlushBlock())
+			return {};
+		m_ReservedInPlace = true;
+		return { m_Block.data() + m_Fill, count };
+	}
+
+	void CompressedWriterStream::WriteCommit(const sizet count)
+	{
+		if (!m_ReservedInPlace)
+		{
+			IStream::WriteCommit(count);
+			return;
+		}
+		m_ReservedInPlace = false;
+		m_Fill += count;
+		if (m_Fill == m_Config.BlockSize && !FlushBlock())
+			return;
+		m_Size += (ssizet)count;
+	}
+
+	void CompressedWriterStream::Skip(const ssizet count)
+	{
+		VerifyGreaterEqual(count, 0, "Trying to skip backwards on a CompressedWriterStream.");
+		auto left = (sizet)Max<ssizet>(count, 0);
+		while (left > 0)
+		{
+			auto room = WriteReserve(Min(left, (sizet)m_Config.BlockSize));
+			if (room.empty())
+				break;
+			memset(room.data(), 0, room.size());
+			WriteCommit(room.size());
+			left -= room.size();
+		}
+	}
+
+	void CompressedWriterStream::Seek(const ssizet pos)
+	{
+		Skip(pos - Tell());
+	}
+
+	SPtr<IStream> CompressedWriterStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		return SPtr<IStream>();
+	}
+
+	void CompressedWriterStream::Close()
+	{
+		if (m_Inner == nullptr)
+			return;
+		// Without the end mark readers flag the data as cut
+		if (FlushBlock())
+		{
+			uint8 end[Impl::CompressedHeaderSize];
+			Impl::StoreCompressedHeader(end, 0, 0);
+			const auto written = m_Inner->Write(end, sizeof(end));
+			VerifyEqual(written, (ssizet)sizeof(end), "Couldn't write the end of a CompressedWriterStream, Written:%d.", written);
+		}
+		m_Inner.reset();
+	}
+
+	bool CompressedWriterStream::Flush()
+	{
+		return m_Inner != nullptr && FlushBlock();
+	}
+
+	bool CompressedReaderStream::ReadBlockHeader(Impl::CompressedBlockHeader& header)const
+	{
+		uint8 bytes[Impl::CompressedHeaderSize];
+		if (m_Inner->Read(bytes, sizeof(bytes)) != (ssizet)sizeof(bytes))
+		{
+			// The end mark is missing, the data was cut
+			m_Corrupted = true;
+			return false;
+		}
+		Impl::LoadCompressedHeader(bytes, header.RawSize, header.PackedSize);
+		if (header.RawSize == 0)
+			return false;
+
+		const auto stored = (header.PackedSize & Impl::CompressedBlockStored) != 0;
+		const auto packedSize = header.PackedSize & ~Impl::CompressedBlockStored;
+		if (header.RawSize > m_BlockSize || packedSize > LZCompressBound(m_BlockSize) || (stored && packedSize != header.RawSize))
+		{
+			m_Corrupted = true;
+			return false;
+		}
+		return true;
+	}
+
+	void CompressedReaderStream::DecompressBlock(Block& block)
+	{
+		if (block.Stored)
+		{
+			block.Valid = true;
+			return;
+		}
+		const auto size = LZDecompress({ block.Packed.data(), block.PackedSize }, { block.Data.data(), block.Size });
+		block.Valid = size == (ssizet)block.Size;
+	}
+
+	bool CompressedReaderStream::LoadBatch()const
+	{
+		m_BlockCount = 0;
+		m_Current = 0;
+		m_Offset = 0;
+		if (m_Ended)
+			return false;
+
+		const bool parallel = m_Blocks.size() > 1;
+		for (auto& block : m_Blocks)
+		{
+			Impl::CompressedBlockHeader header = m_NextHeader;
+			if (!m_HasNextHeader && !ReadBlockHeader(header))
+			{
+				m_Ended = true;
+				break;
+			}
+			m_HasNextHeader = false;
+			if (block.Data.empty())
+				block.Data.resize(m_BlockSize);
+			block.Size = header.RawSize;
+			block.Stored = (header.PackedSize & Impl::CompressedBlockStored) != 0;
+			block.PackedSize = header.PackedSize & ~Impl::CompressedBlockStored;
+			block.Valid = false;
+
+			if (block.Stored)
+			{
+				block.Valid = m_Inner->Read(block.Data.data(), (ssizet)block.Size) == (ssizet)block.Size;
+			}
+			else if (parallel)
+			{
+				if (block.Packed.size() < block.PackedSize)
+					block.Packed.resize(LZCompressBound(m_BlockSize));
+				block.Valid = m_Inner->Read(block.Packed.data(), (ssizet)block.PackedSize) == (ssizet)block.PackedSize;
+			}
+			else
+			{
+				// Alone it can be decompressed straight from the inner stream
+				const auto view = m_Inner->ReadView(block.PackedSize);
+				block.Valid = view.size() == block.PackedSize
+					&& LZDecompress(view, { block.Data.data(), block.Size }) == (ssizet)block.Size;
+			}
+			if (!block.Valid)
+			{
+				m_Corrupted = true;
+				m_Ended = true;
+				break;
+			}
+			++m_BlockCount;
+		}
+
+		// The header after a full batch is read now, so Eof knows about the end mark once the last block is loaded
+		if (!m_Ended && m_BlockCount == m_Blocks.size())
+		{
+			m_HasNextHeader = ReadBlockHeader(m_NextHeader);
+			m_Ended = !m_HasNextHeader;
+		}
+
+		if (parallel && m_BlockCount > 0)
+		{
+			{
+				TaskGroup group;
+				for (sizet i = 1; i < m_BlockCount; ++i)
+					group.Run(*m_Config.Pool, [block = &m_Blocks[i]]() { DecompressBlock(*block); }, "CompressedReaderStream"sv);
+				DecompressBlock(m_Blocks[0]);
+			}
+			for (sizet i = 0; i < m_BlockCount; ++i)
+			{
+				if (!m_Blocks[i].Valid)
+				{
+					// Whatever decoded before it can still be read
+					m_BlockCount = i;
+					m_Corrupted = true;
+					m_Ended = true;
+					break;
+				}
+			}
+		}
+		return m_BlockCount > 0;
+	}
+
+	bool CompressedReaderStream::NextBlock()const
+	{
+		if (m_Current + 1 < m_BlockCount)
+		{
+			++m_Current;
+			m_Offset = 0;
+			return true;
+		}
+		return LoadBatch();
+	}
+
+	sizet CompressedReaderStream::Consume(uint8* dst, const sizet count)const
+	{
+		sizet done = 0;
+		while (done < count && m_Inner != nullptr)
+		{
+			const auto available = m_Current < m_BlockCount ? m_Blocks[m_Current].Size - m_Offset : 0;
+			if (available == 0)
+			{
+				if (!NextBlock())
+					break;
+				continue;
+			}
+			const auto size = Min(available, count - done);
+			if (dst != nullptr)
+				memcpy(dst + done, m_Blocks[m_Current].Data.data() + m_Offset, size);
+			m_Offset += size;
+			done += size;
+		}
+		m_Position += (ssizet)done;
+		return done;
+	}
+
+	CompressedReaderStream::CompressedReaderStream(SPtr<IStream> inner, const CompressedStreamConfig& config)
+		:IStream(inner != nullptr ? inner->GetName() : StringView{}, READ)
+		,m_Inner(std::move(inner))
+		,m_Config(config)
+		,m_BlockSize(0)
+		,m_BlockCount(0)
+		,m_Current(0)
+		,m_Offset(0)
+		,m_Position(0)
+		,m_NextHeader{ 0, 0 }
+		,m_Ended(false)
+		,m_HasNextHeader(false)
+		,m_Corrupted(false)
+	{
+		VerifyNotNull(m_Inner, "Trying to create a CompressedReaderStream without a stream to read from.");
+		m_Size = 0;
+		m_Blocks.resize(m_Config.Pool != nullptr ? Max(m_Config.ParallelBlocks, 1u) : 1u);
+
+		uint8 bytes[Impl::CompressedHeaderSize] = {};
+		Impl::CompressedStreamHeader header{};
+		const auto read = m_Inner->Read(bytes, sizeof(bytes));
+		Impl::LoadCompressedHeader(bytes, header.Magic, header.BlockSize);
+		if (read != (ssizet)sizeof(bytes) || header.Magic != Impl::CompressedStreamMagic
+			|| header.BlockSize < Impl::CompressedStreamMinBlockSize || header.BlockSize > Impl::CompressedStreamMaxBlockSize)
+		{
+			m_Corrupted = true;
+			m_Ended = true;
+			return;
+		}
+		m_BlockSize = header.BlockSize;
+		m_HasNextHeader = ReadBlockHeader(m_NextHeader);
+		m_Ended = !m_HasNextHeader;
+	}
+
+	CompressedReaderStream::~CompressedReaderStream()
+	{
+		Close();
+	}
+
+	ssizet CompressedReaderStream::Read(void* buf, ssizet count)const
+	{
+		if (count <= 0)
+			return 0;
+		return (ssizet)Consume((uint8*)buf, (sizet)count);
+	}
+
+	ssizet CompressedReaderStream::Write(const void* buf, ssizet count)
+	{
+		UNUSED(buf);
+		UNUSED(count);
+		return 0;
+	}
+
+	std::span<const uint8> CompressedReaderStream::ReadView(const sizet count)const
+	{
+		if (m_Inner == nullptr || count == 0)
+			return {};
+		auto available = m_Current < m_BlockCount ? m_Blocks[m_Current].Size - m_Offset : 0;
+		if (available == 0 && NextBlock())
+			available = m_Blocks[m_Current].Size;
+		if (available < count)
+			return IStream::ReadView(count);
+
+		const auto view = std::span<const uint8>(m_Blocks[m_Current].Data.data() + m_Offset, count);
+		m_Offset += count;
+		m_Position += (ssizet)count;
+		return view;
+	}
+
+	void CompressedReaderStream::Skip(const ssizet count)
+	{
+		VerifyGreaterEqual(count, 0, "Trying to skip backwards on a CompressedReaderStream.");
+		if (count > 0)
+			Consume(nullptr, (sizet)count);
+	}
+
+	void CompressedReaderStream::Seek(const ssizet pos)
+	{
+		Skip(pos - Tell());
+	}
+
+	bool CompressedReaderStream::Eof()const
+	{
+		if (m_Inner == nullptr)
+			return true;
+		const auto available = m_Current < m_BlockCount ? m_Blocks[m_Current].Size - m_Offset : 0;
+		return available == 0 && m_Current + 1 >= m_BlockCount && m_Ended;
+	}
+
+	SPtr<IStream> CompressedReaderStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		return SPtr<IStream>();
+	}
+
+	void CompressedReaderStream::Close()
+	{
+		m_Inner.reset();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,354 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_DEFERRED_CALL_SCHEDULER_H
+#define CORE_DEFERRED_CALL_SCHEDULER_H 1
+
+#include "../TimerWheel.h"
+#include "ThreadBufferRegistry.h"
+#include <span>
+
+namespace greaper
+{
+	ENUMERATION(DeferredUpdate, PreUpdate, Update, PostUpdate, Fixed);
+
+	using DeferredCall_t = TimerCallback;
+
+	struct DeferredCallHandle
+	{
+		TimerHandle Timer;
+		DeferredUpdate_t Phase = DeferredUpdate_t::Update;
+
+		[[nodiscard]] constexpr bool IsValid()const noexcept { return Timer.IsValid(); }
+	};
+
+	struct DeferredCallRequest
+	{
+		DeferredCall_t Call;
+		uint32 UpdatesToWait = 0;
+		Duration_t TimeToWait = Duration_t{ 0 }; // Used instead of UpdatesToWait when positive
+	};
+
+	namespace Impl
+	{
+		struct PostedDeferredCall
+		{
+			DeferredCall_t Call;
+			uint64 Delay = 0; // Updates to wait for Frames, expiry tick for Time
+			TimerDomain_t Domain = TimerDomain_t::Frames;
+		};
+
+		struct DeferredCallPoster;
+
+		struct DeferredCallBatch
+		{
+			DeferredCallBatch* Next = nullptr;
+			DeferredCallPoster* Owner = nullptr; // Gets the batch back once spliced, nullptr frees it
+			Vector<PostedDeferredCall> Calls;
+		};
+
+		/**
+		 * Multiple producer single consumer inbox of batches, producers push a whole
+		 * batch with one CAS and the consumer takes every batch with one exchange,
+		 * so there is no ABA and no lock on either side.
+		 */
+		class DeferredCallInbox
+		{
+			std::atomic<DeferredCallBatch*> m_Head;
+
+		public:
+			DeferredCallInbox() noexcept
+				:m_Head(nullptr)
+			{
+
+			}
+			DeferredCallInbox(const DeferredCallInbox&) = delete;
+			DeferredCallInbox& operator=(const DeferredCallInbox&) = delete;
+
+			~DeferredCallInbox()
+			{
+				auto* batch = TakeAll();
+				while (batch != nullptr)
+				{
+					auto* next = batch->Next;
+					Destroy<DeferredCallBatch>(batch);
+					batch = next;
+				}
+			}
+
+			INLINE void Push(DeferredCallBatch* batch) noexcept
+			{
+				auto* head = m_Head.load(std::memory_order_relaxed);
+				do
+				{
+					batch->Next = head;
+				} while (!m_Head.compare_exchange_weak(head, batch, std::memory_order_release, std::memory_order_relaxed));
+			}
+
+			/** Returns the pushed batches in submission order */
+			[[nodiscard]] INLINE DeferredCallBatch* TakeAll() noexcept
+			{
+				if (m_Head.load(std::memory_order_relaxed) == nullptr)
+					return nullptr;
+				auto* batch = m_Head.exchange(nullptr, std::memory_order_acquire);
+				DeferredCallBatch* ordered = nullptr;
+				while (batch != nullptr)
+				{
+					auto* next = batch->Next;
+					batch->Next = ordered;
+					ordered = batch;
+					batch = next;
+				}
+				return ordered;
+			}
+		};
+
+		/**
+		 * Batches a thread is filling for one scheduler, one per phase. The owner
+		 * thread takes the pending batch out of its slot, appends and puts it back,
+		 * and RunPhase takes it out of the slot to splice it, so a call is either
+		 * in this update or in the next one. Spliced batches come back emptied
+		 * through the spare slot, keeping their capacity. Shared between the
+		 * scheduler and the owner thread, the last one to let it go frees it.
+		 */
+		struct alignas(CACHE_LINE_SIZE) DeferredCallPoster : public SharedThreadBuffer<DeferredCallPoster>
+		{
+			std::atomic<DeferredCallBatch*> Pending[DeferredUpdate_t::COUNT] = {};
+			std::atomic<DeferredCallBatch*> Spare[DeferredUpdate_t::COUNT] = {};
+
+			/** Frees the batches, only once no thread can post through it */
+			INLINE void DestroyBatches() noexcept
+			{
+				for (sizet phase = 0; phase < DeferredUpdate_t::COUNT; ++phase)
+				{
+					if (auto* batch = Pending[phase].exchange(nullptr, std::memory_order_acquire))
+						Destroy<DeferredCallBatch>(batch);
+					if (auto* batch = Spare[phase].exchange(nullptr, std::memory_order_acquire))
+						Destroy<DeferredCallBatch>(batch);
+				}
+			}
+
+			static INLINE void Delete(DeferredCallPoster* poster) noexcept
+			{
+				poster->DestroyBatches();
+				poster->~DeferredCallPoster();
+				MemoryAllocator<GenericAllocator>::DeallocateAligned(poster);
+			}
+		};
+	}
+
+	/**
+	 * Scheduling backend of IDeferredCallManager implementations, one TimerWheel
+	 * per phase where update delays use the Frames hand and time delays the Time
+	 * hand. RunPhase must be called once per phase update and only drains the
+	 * slots that expired since its previous call. The DelayCall family belongs
+	 * to the thread that runs the phases, other threads use the PostCall family.
+	 * Each posting thread appends to its own batch per phase without locks or
+	 * allocations, a batch is handed to the lock-free inbox of the phase when it
+	 * fills up, and RunPhase takes the partial ones and splices all of them into
+	 * the wheel before advancing it.
+	 */
+	class DeferredCallScheduler
+	{
+		static constexpr sizet PostBatchSize = 64;
+
+		TimerWheel m_Wheels[DeferredUpdate_t::COUNT];
+		Impl::DeferredCallInbox m_Inboxes[DeferredUpdate_t::COUNT];
+		Impl::ThreadBufferRegistry<Impl::DeferredCallPoster> m_Posters;
+		Timepoint_t m_Start;
+		Duration_t m_TickDuration;
+
+		[[nodiscard]] INLINE uint64 ToTick(Timepoint_t time)const noexcept
+		{
+			if (time <= m_Start)
+				return 0;
+			return static_cast<uint64>((time - m_Start) / m_TickDuration);
+		}
+
+		/** Only reads immutable state, so producers compute their expiry on their own thread */
+		[[nodiscard]] INLINE uint64 ToExpiryTick(Duration_t timeToWait, Timepoint_t now)const noexcept
+		{
+			const auto waitTicks = (Max(timeToWait, Duration_t{ 0 }) + m_TickDuration - Duration_t{ 1 }) / m_TickDuration;
+			return ToTick(now) + static_cast<uint64>(waitTicks);
+		}
+
+		[[nodiscard]] INLINE Impl::PostedDeferredCall ToPosted(DeferredCallRequest& request, Timepoint_t now)const noexcept
+		{
+			if (request.TimeToWait > Duration_t{ 0 })
+				return Impl::PostedDeferredCall{ std::move(request.Call), ToExpiryTick(request.TimeToWait, now), TimerDomain_t::Time };
+			return Impl::PostedDeferredCall{ std::move(request.Call), request.UpdatesToWait, TimerDomain_t::Frames };
+		}
+
+		INLINE Impl::DeferredCallPoster* GetThreadPoster()
+		{
+			return m_Posters.GetThreadBuffer();
+		}
+
+		/** Takes the pending batch of the poster, or its spare one, or a new one */
+		static INLINE Impl::DeferredCallBatch* TakeBatch(Impl::DeferredCallPoster* poster, DeferredUpdate_t phase)
+		{
+			auto* batch = poster->Pending[phase].exchange(nullptr, std::memory_order_acquire);
+			if (batch != nullptr)
+				return batch;
+			batch = poster->Spare[phase].exchange(nullptr, std::memory_order_acquire);
+			if (batch != nullptr)
+				return batch;
+			batch = new(AllocT<Impl::DeferredCallBatch>())Impl::DeferredCallBatch();
+			batch->Owner = poster;
+			batch->Calls.reserve(PostBatchSize);
+			return batch;
+		}
+
+		INLINE void Post(Impl::PostedDeferredCall call, DeferredUpdate_t phase)
+		{
+			auto* poster = GetThreadPoster();
+			auto* batch = TakeBatch(poster, phase);
+			batch->Calls.push_back(std::move(call));
+			if (batch->Calls.size() >= PostBatchSize)
+				m_Inboxes[phase].Push(batch);
+			else
+				poster->Pending[phase].store(batch, std::memory_order_release);
+		}
+
+		/** Emptied batches go back to the thread that filled them */
+		INLINE void Recycle(Impl::DeferredCallBatch* batch, DeferredUpdate_t phase) noexcept
+		{
+			batch->Calls.clear();
+			Impl::DeferredCallBatch* expected = nullptr;
+			if (batch->Owner == nullptr || !batch->Owner->Spare[phase].compare_exchange_strong(expected, batch, std::memory_order_release, std::memory_order_relaxed))
+				Destroy<Impl::DeferredCallBatch>(batch);
+		}
+
+		INLINE void SpliceBatch(Impl::DeferredCallBatch* batch, DeferredUpdate_t phase)
+		{
+			auto& wheel = m_Wheels[phase];
+			for (auto& posted : batch->Calls)
+			{
+				if (posted.Domain == TimerDomain_t::Time)
+					wheel.ScheduleAt(TimerDomain_t::Time, posted.Delay, std::move(posted.Call));
+				else
+					wheel.Schedule(TimerDomain_t::Frames, posted.Delay + 1, std::move(posted.Call));
+			}
+			Recycle(batch, phase);
+		}
+
+		INLINE void Splice(DeferredUpdate_t phase)
+		{
+			auto* batch = m_Inboxes[phase].TakeAll();
+			while (batch != nullptr)
+			{
+				auto* next = batch->Next;
+				SpliceBatch(batch, phase);
+				batch = next;
+			}
+			for (auto* poster = m_Posters.GetFirst(); poster != nullptr; poster = poster->Next)
+			{
+				if (poster->Pending[phase].load(std::memory_order_relaxed) == nullptr)
+					continue;
+				batch = poster->Pending[phase].exchange(nullptr, std::memory_order_acquire);
+				if (batch != nullptr)
+					SpliceBatch(batch, phase);
+			}
+		}
+
+	public:
+		explicit DeferredCallScheduler(Duration_t tickDuration = std::chrono::milliseconds(1), Timepoint_t start = Clock_t::now())
+			:m_Start(start)
+			,m_TickDuration(tickDuration)
+		{
+			VerifyGreater(m_TickDuration.count(), 0, "Trying to create a DeferredCallScheduler with an empty tick duration.");
+		}
+		DeferredCallScheduler(const DeferredCallScheduler&) = delete;
+		DeferredCallScheduler& operator=(const DeferredCallScheduler&) = delete;
+
+		/** No thread may be posting, the posters of live threads are emptied now and freed by them later */
+		~DeferredCallScheduler()
+		{
+			m_Posters.ReleaseAll([](Impl::DeferredCallPoster* poster) { poster->DestroyBatches(); });
+		}
+
+		/** updatesToWait = 0 runs the call on the next update of the phase */
+		INLINE DeferredCallHandle DelayCall(DeferredCall_t call, uint32 updatesToWait, DeferredUpdate_t phase)
+		{
+			auto& wheel = m_Wheels[phase];
+			const auto timer = wheel.Schedule(TimerDomain_t::Frames, static_cast<uint64>(updatesToWait) + 1, std::move(call));
+			return DeferredCallHandle{ timer, phase };
+		}
+
+		/** Time delays are rounded up to the tick duration, the call runs on the first update after they expire */
+		INLINE DeferredCallHandle DelayCallTime(DeferredCall_t call, Duration_t timeToWait, DeferredUpdate_t phase, Timepoint_t now = Clock_t::now())
+		{
+			auto& wheel = m_Wheels[phase];
+			const auto timer = wheel.ScheduleAt(TimerDomain_t::Time, ToExpiryTick(timeToWait, now), std::move(call));
+			return DeferredCallHandle{ timer, phase };
+		}
+
+		/** Bulk DelayCall, the calls are moved out of the requests */
+		INLINE void DelayCalls(std::span<DeferredCallRequest> requests, DeferredUpdate_t phase, Timepoint_t now = Clock_t::now())
+		{
+			for (auto& request : requests)
+			{
+				if (request.TimeToWait > Duration_t{ 0 })
+					DelayCallTime(std::move(request.Call), request.TimeToWait, phase, now);
+				else
+					DelayCall(std::move(request.Call), request.UpdatesToWait, phase);
+			}
+		}
+
+		/**
+		 * Thread-safe DelayCall, the call is spliced into the phase on its next
+		 * RunPhase, so updatesToWait = 0 runs it on that same update. Posted calls
+		 * have no handle, use a CancellationToken to cancel them.
+		 */
+		INLINE void PostCall(DeferredCall_t call, uint32 updatesToWait, DeferredUpdate_t phase)
+		{
+			Post(Impl::PostedDeferredCall{ std::move(call), updatesToWait, TimerDomain_t::Frames }, phase);
+		}
+
+		/** Thread-safe DelayCallTime, the delay starts counting on submission */
+		INLINE void PostCallTime(DeferredCall_t call, Duration_t timeToWait, DeferredUpdate_t phase, Timepoint_t now = Clock_t::now())
+		{
+			Post(Impl::PostedDeferredCall{ std::move(call), ToExpiryTick(timeToWait, now), TimerDomain_t::Time }, phase);
+		}
+
+		/** Thread-safe DelayCalls, all the requests are published as a single batch */
+		INLINE void PostCalls(std::span<DeferredCallRequest> requests, DeferredUpdate_t phase, Timepoint_t now = Clock_t::now())
+		{
+			if (requests.empty())
+				return;
+			auto* batch = new(AllocT<Impl::DeferredCallBatch>())Impl::DeferredCallBatch();
+			batch->Calls.reserve(requests.size());
+			for (auto& request : requests)
+				batch->Calls.push_back(ToPosted(request, now));
+			m_Inboxes[phase].Push(batch);
+		}
+
+		/** Returns false if the call already ran or was cancelled */
+		INLINE bool CancelCall(const DeferredCallHandle& handle) noexcept
+		{
+			if (!handle.IsValid())
+				return false;
+			return m_Wheels[handle.Phase].Cancel(handle.Timer);
+		}
+
+		/** Runs the expired calls of the phase, returns the amount of calls run */
+		INLINE sizet RunPhase(DeferredUpdate_t phase, Timepoint_t now = Clock_t::now())
+		{
+			Splice(phase);
+			auto& wheel = m_Wheels[phase];
+			auto ran = wheel.Advance(TimerDomain_t::Frames, wheel.GetCurrentTick(TimerDomain_t::Frames) + 1);
+			ran += wheel.Advance(TimerDomain_t::Time, ToTick(now));
+			return ran;
+		}
+
+		[[nodiscard]] INLINE sizet GetPendingCount(DeferredUpdate_t phase)const noexcept { return m_Wheels[phase].GetPendingCount(); }
+
+		[[nodiscard]] INLINE Duration_t GetTickDuration()const noexcept { return m_TickDuration; }
+	};
+}
+
+#endif /* CORE_DEFERRED_CALL_SCHEDULER_H */
\ No newline at end of file
@@ -0,0 +1,145 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_EVENT_STATISTICS_H
+#define CORE_EVENT_STATISTICS_H 1
+
+#include "NamedStatistics.h"
+
+namespace greaper
+{
+	struct EventStatisticsSnapshot
+	{
+		String Name;
+		uint64 TriggerCount = 0;
+		uint32 HandlerCount = 0; // On the last trigger
+		uint64 TotalNanoseconds = 0;
+		uint64 MaxNanoseconds = 0;
+		uint64 SlowestHandlerNanoseconds = 0;
+		StringView SlowestHandlerName;
+
+		[[nodiscard]] double GetAverageNanoseconds()const noexcept
+		{
+			return TriggerCount == 0 ? 0.0 : static_cast<double>(TotalNanoseconds) / static_cast<double>(TriggerCount);
+		}
+	};
+
+	/**
+	 * Lock-free per event name dispatch statistics, events that share a name are
+	 * accumulated together in a NamedStatisticsTable. Handler names are views,
+	 * like task names they must outlive the sink.
+	 */
+	class EventStatistics
+	{
+	public:
+		static constexpr uint32 MaxEventNames = 256;
+
+	private:
+		struct Entry : Impl::NamedStatisticsEntry<String>
+		{
+			std::atomic<uint64> TriggerCount{ 0 };
+			std::atomic<uint32> HandlerCount{ 0 };
+			std::atomic<uint64> TotalNanoseconds{ 0 };
+			std::atomic<uint64> MaxNanoseconds{ 0 };
+			std::atomic<uint64> SlowestHandlerNanoseconds{ 0 };
+			mutable SpinLock SlowestHandlerLock;
+			StringView SlowestHandlerName;
+
+			void Record(uint32 handlerCount, uint64 nanos, uint64 slowestHandlerNanos, const StringView& slowestHandlerName) noexcept
+			{
+				TriggerCount.fetch_add(1, std::memory_order_relaxed);
+				HandlerCount.store(handlerCount, std::memory_order_relaxed);
+				TotalNanoseconds.fetch_add(nanos, std::memory_order_relaxed);
+				auto cur = MaxNanoseconds.load(std::memory_order_relaxed);
+				while (nanos > cur && !MaxNanoseconds.compare_exchange_weak(cur, nanos, std::memory_order_relaxed));
+				// A new slowest handler is rare, the name and its time change together
+				if (slowestHandlerNanos <= SlowestHandlerNanoseconds.load(std::memory_order_relaxed))
+					return;
+				auto lck = Lock<SpinLock>(SlowestHandlerLock);
+				if (slowestHandlerNanos <= SlowestHandlerNanoseconds.load(std::memory_order_relaxed))
+					return;
+				SlowestHandlerNanoseconds.store(slowestHandlerNanos, std::memory_order_relaxed);
+				SlowestHandlerName = slowestHandlerName;
+			}
+
+			void Snapshot(EventStatisticsSnapshot& snapshot)const
+			{
+				snapshot.Name = Name;
+				snapshot.TriggerCount = TriggerCount.load(std::memory_order_relaxed);
+				snapshot.HandlerCount = HandlerCount.load(std::memory_order_relaxed);
+				snapshot.TotalNanoseconds = TotalNanoseconds.load(std::memory_order_relaxed);
+				snapshot.MaxNanoseconds = MaxNanoseconds.load(std::memory_order_relaxed);
+				auto lck = Lock<SpinLock>(SlowestHandlerLock);
+				snapshot.SlowestHandlerNanoseconds = SlowestHandlerNanoseconds.load(std::memory_order_relaxed);
+				snapshot.SlowestHandlerName = SlowestHandlerName;
+			}
+
+			void Reset() noexcept
+			{
+				TriggerCount.store(0, std::memory_order_relaxed);
+				HandlerCount.store(0, std::memory_order_relaxed);
+				TotalNanoseconds.store(0, std::memory_order_relaxed);
+				MaxNanoseconds.store(0, std::memory_order_relaxed);
+				auto lck = Lock<SpinLock>(SlowestHandlerLock);
+				SlowestHandlerNanoseconds.store(0, std::memory_order_relaxed);
+				SlowestHandlerName = StringView{};
+			}
+		};
+
+		Impl::NamedStatisticsTable<Entry, MaxEventNames> m_Table;
+
+	public:
+		EventStatistics() = default;
+		EventStatistics(const EventStatistics&) = delete;
+		EventStatistics& operator=(const EventStatistics&) = delete;
+		~EventStatistics() = default;
+
+		INLINE void Record(const StringView& eventName, uint32 handlerCount, Duration_t duration, Duration_t slowestHandler, const StringView& slowestHandlerName)
+		{
+			const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+			const auto slowestNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(slowestHandler).count();
+			m_Table.FindOrCreate(eventName).Record(handlerCount,
+				nanos < 0 ? 0 : static_cast<uint64>(nanos), slowestNanos < 0 ? 0 : static_cast<uint64>(slowestNanos), slowestHandlerName);
+		}
+
+		/** Returns false if no event with that name has been recorded */
+		INLINE bool GetStatistics(const StringView& eventName, EventStatisticsSnapshot& snapshot)const
+		{
+			return m_Table.GetSnapshot(eventName, snapshot);
+		}
+
+		[[nodiscard]] INLINE Vector<EventStatisticsSnapshot> GetAllStatistics()const
+		{
+			return m_Table.GetAllSnapshots<EventStatisticsSnapshot>();
+		}
+
+		/** Clears the counters, the known names are kept */
+		INLINE void Reset() noexcept
+		{
+			m_Table.Reset();
+		}
+
+		static EventStatistics& GetDefault() noexcept
+		{
+			static EventStatistics statistics;
+			return statistics;
+		}
+	};
+
+	/** Event dispatches are only timed while a sink is set, nullptr disables the timing */
+	INLINE void SetEventStatisticsSink(EventStatistics* sink) noexcept
+	{
+		Impl::GetStatisticsSinkRef<EventStatistics>().store(sink, std::memory_order_release);
+	}
+
+	[[nodiscard]] INLINE EventStatistics* GetEventStatisticsSink() noexcept
+	{
+		return Impl::GetStatisticsSinkRef<EventStatistics>().load(std::memory_order_acquire);
+	}
+}
+
+#endif /* CORE_EVENT_STATISTICS_H */
\ No newline at end of file
@@ -0,0 +1,75 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_EVENT_STATISTICS_COMMAND_H
+#define CORE_EVENT_STATISTICS_COMMAND_H 1
+
+#include "ICommand.h"
+#include "EventStatistics.h"
+#include "../ILogManager.h"
+#include <algorithm>
+
+namespace greaper
+{
+	/**
+	 * Console command to inspect the event dispatch statistics.
+	 * "eventstats" logs every event sorted by total dispatch time,
+	 * "eventstats on|off" sets or clears the default sink,
+	 * "eventstats reset" clears the counters.
+	 */
+	class EventStatisticsCommand : public ICommand
+	{
+		ILogManager* m_LogManager;
+
+	public:
+		explicit EventStatisticsCommand(ILogManager* logManager)
+			:ICommand("eventstats", "Dumps the event dispatch statistics, 'on', 'off' and 'reset' control the recording.")
+			,m_LogManager(logManager)
+		{
+
+		}
+
+		bool DoCommand(const StringVec& args) override
+		{
+			if (!args.empty())
+			{
+				if (args[0] == "on")
+					SetEventStatisticsSink(&EventStatistics::GetDefault());
+				else if (args[0] == "off")
+					SetEventStatisticsSink(nullptr);
+				else if (args[0] == "reset")
+					EventStatistics::GetDefault().Reset();
+				else
+					return false;
+				return true;
+			}
+
+			auto* sink = GetEventStatisticsSink();
+			if (sink == nullptr)
+			{
+				m_LogManager->Log(ELogLevel::INFORMATIVE, "Event statistics are disabled, use 'eventstats on' to record them.");
+				return true;
+			}
+			auto statistics = sink->GetAllStatistics();
+			std::sort(statistics.begin(), statistics.end(), [](const EventStatisticsSnapshot& left, const EventStatisticsSnapshot& right)
+				{
+					return left.TotalNanoseconds > right.TotalNanoseconds;
+				});
+			for (const auto& stats : statistics)
+			{
+				const auto slowestName = String(stats.SlowestHandlerName);
+				m_LogManager->Log(ELogLevel::INFORMATIVE, Format("Event '%s': %llu triggers, %u handlers, avg %.3fus, max %.3fus, total %.3fms, slowest handler '%s' %.3fus.",
+					stats.Name.c_str(), (unsigned long long)stats.TriggerCount, stats.HandlerCount,
+					stats.GetAverageNanoseconds() / 1000.0, (double)stats.MaxNanoseconds / 1000.0, (double)stats.TotalNanoseconds / 1000000.0,
+					slowestName.c_str(), (double)stats.SlowestHandlerNanoseconds / 1000.0));
+			}
+			return true;
+		}
+	};
+}
+
+#endif /* CORE_EVENT_STATISTICS_COMMAND_H */
\ No newline at end of file
@@ -0,0 +1,25 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_FILE_INFO_H
+#define CORE_FILE_INFO_H 1
+
+#include "../Memory.h"
+#include "../Enumeration.h"
+
+namespace greaper
+{
+	/**
+	 * Hint of how a file is going to be accessed, Linux forwards it to
+	 * posix_fadvise and Windows to the FILE_FLAG_*_SCAN/ACCESS open flags.
+	 */
+	ENUMERATION(FileAccessPattern, Normal, Sequential, Random);
+
+	ENUMERATION(FileOpenMode, OpenExisting, OpenOrCreate, CreateOrTruncate);
+}
+
+#endif /* CORE_FILE_INFO_H */
\ No newline at end of file
@@ -0,0 +1,184 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../FileStream.h"
+
+namespace greaper
+{
+	bool OSFileStream::MoveFileOffset()const
+	{
+		if (m_FileOffset == m_Offset)
+			return true;
+		const auto res = OSFile::Seek(m_Handle, m_Offset);
+		if (res < 0)
+			return false;
+		m_FileOffset = res;
+		return m_FileOffset == m_Offset;
+	}
+
+	OSFileStream::OSFileStream(StringView path, const uint16 accessMode, const FileStreamConfig& config)
+		:IStream(path, accessMode)
+		,m_Config(config)
+		,m_Handle(OSFile::InvalidHandle)
+		,m_Offset(0)
+		,m_FileOffset(0)
+	{
+		m_Size = 0;
+		const auto mode = IsWritable() ? config.OpenMode : FileOpenMode_t::OpenExisting;
+		m_Handle = OSFile::Open(m_Name.c_str(), IsReadable(), IsWritable(), mode, config.AccessPattern);
+		if (!IsOpen())
+			return;
+
+		const auto size = OSFile::GetSize(m_Handle);
+		m_Size = size < 0 ? 0 : (ssizet)size;
+	}
+
+	OSFileStream::~OSFileStream()
+	{
+		Close();
+	}
+
+	ssizet OSFileStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsReadable() || !IsOpen() || count <= 0 || !MoveFileOffset())
+			return 0;
+		const auto read = OSFile::Read(m_Handle, buf, (sizet)count);
+		if (read <= 0)
+			return 0;
+		m_FileOffset += read;
+		m_Offset += read;
+		return read;
+	}
+
+	ssizet OSFileStream::Write(const void* buf, ssizet count)
+	{
+		if (!IsWritable() || !IsOpen() || count <= 0 || !MoveFileOffset())
+			return 0;
+		const auto written = OSFile::Write(m_Handle, buf, (sizet)count);
+		if (written <= 0)
+			return 0;
+		m_FileOffset += written;
+		m_Offset += written;
+		m_Size = Max(m_Size, (ssizet)m_Offset);
+		return written;
+	}
+
+	ssizet OSFileStream::ReadV(const std::span<const IOVec> vecs)const
+	{
+		if (!IsReadable() || !IsOpen() || !MoveFileOffset())
+			return 0;
+		const auto read = OSFile::ReadV(m_Handle, vecs.data(), vecs.size());
+		if (read <= 0)
+			return 0;
+		m_FileOffset += read;
+		m_Offset += read;
+		return read;
+	}
+
+	ssizet OSFileStream::WriteV(const std::span<const IOVec> vecs)
+	{
+		if (!IsWritable() || !IsOpen() || !MoveFileOffset())
+			return 0;
+		const auto written = OSFile::WriteV(m_Handle, vecs.data(), vecs.size());
+		if (written <= 0)
+			return 0;
+		m_FileOffset += written;
+		m_Offset += written;
+		m_Size = Max(m_Size, (ssizet)m_Offset);
+		return written;
+	}
+
+	void OSFileStream::Skip(const ssizet count)
+	{
+		Seek(Tell() + count);
+	}
+
+	void OSFileStream::Seek(const ssizet pos)
+	{
+		VerifyGreaterEqual(pos, 0, "Trying to seek a FileStream before its start.");
+		m_Offset = (int64)Max<ssizet>(pos, 0);
+	}
+
+	SPtr<IStream> OSFileStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		auto config = m_Config;
+		config.OpenMode = FileOpenMode_t::OpenExisting;
+		auto clone = std::make_shared<OSFileStream>(m_Name, m_Access, config);
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void OSFileStream::Close()
+	{
+		if (IsOpen())
+		{
+			OSFile::Close(m_Handle);
+			m_Handle = OSFile::InvalidHandle;
+		}
+	}
+
+	bool OSFileStream::Sync()
+	{
+		return IsOpen() && OSFile::Sync(m_Handle);
+	}
+
+	void OSFileStream::SetAccessPattern(const FileAccessPattern_t pattern)
+	{
+		m_Config.AccessPattern = pattern;
+		if (IsOpen())
+			OSFile::Advise(m_Handle, pattern);
+	}
+
+	FileStream::FileStream(StringView path, const uint16 accessMode, const FileStreamConfig& config)
+		:BufferedStream(std::make_shared<OSFileStream>(path, accessMode, config), BufferedStreamConfig{ config.BufferSize, true })
+		,m_FileConfig(config)
+	{
+
+	}
+
+	FileStream::~FileStream()
+	{
+		Close();
+	}
+
+	SPtr<IStream> FileStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		if (!FlushBuffer())
+			return SPtr<IStream>();
+		auto config = m_FileConfig;
+		config.OpenMode = FileOpenMode_t::OpenExisting;
+		auto clone = std::make_shared<FileStream>(m_Name, m_Access, config);
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void FileStream::Close()
+	{
+		// The OS file belongs to this stream, it is closed even if someone else holds it
+		const auto file = m_Inner;
+		BufferedStream::Close();
+		if (file != nullptr)
+			file->Close();
+	}
+
+	bool FileStream::Flush(const bool syncDevice)
+	{
+		if (!IsOpen())
+			return false;
+		const auto flushed = BufferedStream::Flush();
+		if (!syncDevice || !flushed)
+			return flushed;
+		return GetFile()->Sync();
+	}
+
+	void FileStream::SetAccessPattern(const FileAccessPattern_t pattern)
+	{
+		m_FileConfig.AccessPattern = pattern;
+		if (m_Inner != nullptr)
+			GetFile()->SetAccessPattern(pattern);
+	}
+}
\ No newline at end of file
@@ -9,7 +9,7 @@
 #define CORE_I_CONSOLE_H 1
 
 #include "../Memory.h"
-#include "../Concurrency.h"
+#include "../Future.h"
 #include "../Enumeration.h"
 #include "../Event.h"
 
@@ -0,0 +1,202 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_IO_BUFFER_H
+#define CORE_IO_BUFFER_H 1
+
+#include "../Memory.h"
+#include "../Concurrency.h"
+
+namespace greaper
+{
+	class IOBuffer;
+
+	namespace Impl
+	{
+		/**
+		 * Fixed set of equally sized blocks carved from one page aligned allocation,
+		 * the asynchronous file backends register them with the kernel once so
+		 * transfers into them skip the per request page pinning.
+		 */
+		class IOBufferPool
+		{
+			uint8* m_Memory;
+			sizet m_BlockSize;
+			uint32 m_BlockCount;
+			Vector<uint32> m_FreeBlocks;
+			SpinLock m_Lock;
+
+		public:
+			static constexpr sizet BlockAlignment = 4096;
+
+			IOBufferPool(sizet blockSize, uint32 blockCount);
+
+			IOBufferPool(const IOBufferPool&) = delete;
+			IOBufferPool& operator=(const IOBufferPool&) = delete;
+
+			~IOBufferPool();
+
+			/** Returns an empty IOBuffer if size doesn't fit a block or all blocks are in use */
+			IOBuffer TryAcquire(sizet size);
+
+			void Release(uint32 index) noexcept;
+
+			[[nodiscard]] INLINE uint8* GetBlock(uint32 index)const noexcept { return m_Memory + index * m_BlockSize; }
+
+			[[nodiscard]] INLINE sizet GetBlockSize()const noexcept { return m_BlockSize; }
+
+			[[nodiscard]] INLINE uint32 GetBlockCount()const noexcept { return m_BlockCount; }
+		};
+	}
+
+	/**
+	 * Move-only byte buffer used by the asynchronous file operations. It either
+	 * owns a heap allocation or a block of an IOBufferPool, which it gives back
+	 * when destroyed, so pooled buffers must not outlive the service they came from.
+	 */
+	class IOBuffer
+	{
+		uint8* m_Data = nullptr;
+		sizet m_Size = 0;
+		sizet m_Capacity = 0;
+		Impl::IOBufferPool* m_Pool = nullptr;
+		uint32 m_Index = 0;
+
+		IOBuffer(Impl::IOBufferPool* pool, uint32 index, sizet size) noexcept
+			:m_Data(pool->GetBlock(index))
+			,m_Size(size)
+			,m_Capacity(pool->GetBlockSize())
+			,m_Pool(pool)
+			,m_Index(index)
+		{
+
+		}
+
+		friend class Impl::IOBufferPool;
+
+	public:
+		IOBuffer() noexcept = default;
+
+		explicit IOBuffer(sizet size)
+			:m_Data(size > 0 ? (uint8*)Alloc(size) : nullptr)
+			,m_Size(size)
+			,m_Capacity(size)
+		{
+
+		}
+
+		IOBuffer(const IOBuffer&) = delete;
+		IOBuffer& operator=(const IOBuffer&) = delete;
+
+		IOBuffer(IOBuffer&& other) noexcept
+			:m_Data(std::exchange(other.m_Data, nullptr))
+			,m_Size(std::exchange(other.m_Size, 0))
+			,m_Capacity(std::exchange(other.m_Capacity, 0))
+			,m_Pool(std::exchange(other.m_Pool, nullptr))
+			,m_Index(std::exchange(other.m_Index, 0))
+		{
+
+		}
+
+		IOBuffer& operator=(IOBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				m_Data = std::exchange(other.m_Data, nullptr);
+				m_Size = std::exchange(other.m_Size, 0);
+				m_Capacity = std::exchange(other.m_Capacity, 0);
+				m_Pool = std::exchange(other.m_Pool, nullptr);
+				m_Index = std::exchange(other.m_Index, 0);
+			}
+			return *this;
+		}
+
+		~IOBuffer()
+		{
+			Reset();
+		}
+
+		INLINE void Reset() noexcept
+		{
+			if (m_Pool != nullptr)
+				m_Pool->Release(m_Index);
+			else if (m_Data != nullptr)
+				Dealloc(m_Data);
+			m_Data = nullptr;
+			m_Size = 0;
+			m_Capacity = 0;
+			m_Pool = nullptr;
+			m_Index = 0;
+		}
+
+		[[nodiscard]] INLINE uint8* GetData()const noexcept { return m_Data; }
+
+		[[nodiscard]] INLINE sizet GetSize()const noexcept { return m_Size; }
+
+		[[nodiscard]] INLINE sizet GetCapacity()const noexcept { return m_Capacity; }
+
+		[[nodiscard]] INLINE bool IsEmpty()const noexcept { return m_Size == 0; }
+
+		INLINE void SetSize(sizet size) noexcept
+		{
+			VerifyLessEqual(size, m_Capacity, "Trying to grow an IOBuffer past its capacity.");
+			m_Size = Min(size, m_Capacity);
+		}
+
+		/** True if the buffer is a block of a pool, its index is the one registered with the kernel */
+		[[nodiscard]] INLINE bool IsPooled()const noexcept { return m_Pool != nullptr; }
+
+		[[nodiscard]] INLINE uint32 GetPoolIndex()const noexcept { return m_Index; }
+	};
+
+	namespace Impl
+	{
+		INLINE IOBufferPool::IOBufferPool(sizet blockSize, uint32 blockCount)
+			:m_Memory(nullptr)
+			,m_BlockSize((blockSize + BlockAlignment - 1) & ~(BlockAlignment - 1))
+			,m_BlockCount(blockCount)
+		{
+			if (m_BlockSize == 0 || m_BlockCount == 0)
+			{
+				m_BlockCount = 0;
+				return;
+			}
+			m_Memory = (uint8*)MemoryAllocator<GenericAllocator>::AllocateAligned(m_BlockSize * m_BlockCount, BlockAlignment);
+			m_FreeBlocks.reserve(m_BlockCount);
+			for (uint32 i = m_BlockCount; i > 0; --i)
+				m_FreeBlocks.push_back(i - 1);
+		}
+
+		INLINE IOBufferPool::~IOBufferPool()
+		{
+			VerifyEqual(m_FreeBlocks.size(), (sizet)m_BlockCount, "Destroying an IOBufferPool while some of its buffers are alive.");
+			if (m_Memory != nullptr)
+				MemoryAllocator<GenericAllocator>::DeallocateAligned(m_Memory);
+		}
+
+		INLINE IOBuffer IOBufferPool::TryAcquire(sizet size)
+		{
+			if (size > m_BlockSize)
+				return IOBuffer{};
+			auto lck = Lock<SpinLock>(m_Lock);
+			if (m_FreeBlocks.empty())
+				return IOBuffer{};
+			const auto index = m_FreeBlocks.back();
+			m_FreeBlocks.pop_back();
+			return IOBuffer(this, index, size);
+		}
+
+		INLINE void IOBufferPool::Release(uint32 index) noexcept
+		{
+			auto lck = Lock<SpinLock>(m_Lock);
+			m_FreeBlocks.push_back(index);
+		}
+	}
+}
+
+#endif /* CORE_IO_BUFFER_H */
\ No newline at end of file
@@ -0,0 +1,38 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_IO_VEC_H
+#define CORE_IO_VEC_H 1
+
+#include "../Memory.h"
+
+#if !PLT_WINDOWS
+#include <sys/uio.h>
+#endif
+
+namespace greaper
+{
+	/** One (pointer, length) piece of a scatter/gather transfer */
+	struct IOVec
+	{
+		void* Data;
+		sizet Size;
+	};
+
+#if !PLT_WINDOWS
+	// Arrays of IOVec can be given straight to readv/writev
+	static_assert(sizeof(IOVec) == sizeof(iovec) && offsetof(IOVec, Data) == offsetof(iovec, iov_base)
+		&& offsetof(IOVec, Size) == offsetof(iovec, iov_len), "IOVec must have the layout of iovec.");
+
+	[[nodiscard]] INLINE const iovec* ToOSIOVec(const IOVec* vecs) noexcept
+	{
+		return reinterpret_cast<const iovec*>(vecs);
+	}
+#endif
+}
+
+#endif /* CORE_IO_VEC_H */
\ No newline at end of file
@@ -17,6 +17,8 @@
 #endif
 #include <functional>
 #include "../Enumeration.h"
+#include "../Reclamation.h"
+#include "../CPUTopology.h"
 
 namespace greaper
 {
@@ -27,8 +29,43 @@ namespace greaper
 		bool StartSuspended = false;
 		bool JoinAtDestruction = true;
 		StringView Name = "Unnamed"sv;
+		bool RegisterReclamation = true; // Registers the thread to the default Epoch and HazardPointer domains
+		CPUSet Affinity; // Empty means any logical processor
+		int32 NUMANode = -1; // Restricts the thread to the node processors when no Affinity is given, memory follows by first touch
+		ThreadPriority_t Priority = ThreadPriority_t::Normal;
+		ThreadSchedulingPolicy_t SchedulingPolicy = ThreadSchedulingPolicy_t::Default;
 	};
 
+	/**
+	 * Runs the ThreadFN wrapped by the thread lifecycle, IThreadManager implementations
+	 * must use it as the entry point of the threads created by CreateThread.
+	 */
+	INLINE void RunThreadEntry(const ThreadConfig& config)
+	{
+		if (!config.Affinity.IsEmpty())
+			SetCurrentThreadAffinity(config.Affinity);
+		else if (config.NUMANode >= 0)
+			SetCurrentThreadAffinity(GetNUMANodeProcessors((uint32)config.NUMANode));
+
+		if (config.Priority != ThreadPriority_t::Normal || config.SchedulingPolicy != ThreadSchedulingPolicy_t::Default)
+			SetCurrentThreadPriority(config.Priority, config.SchedulingPolicy);
+
+		if (config.RegisterReclamation)
+		{
+			EpochDomain::GetDefault().RegisterThread();
+			HazardPointerDomain::GetDefault().RegisterThread();
+		}
+
+		if (config.ThreadFN != nullptr)
+			config.ThreadFN();
+
+		if (config.RegisterReclamation)
+		{
+			HazardPointerDomain::GetDefault().UnregisterThread();
+			EpochDomain::GetDefault().UnregisterThread();
+		}
+	}
+
 	ENUMERATION(ThreadState, STOPPED, SUSPENDED, RUNNING);
 
 	class IThread
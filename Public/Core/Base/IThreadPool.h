@@ -8,7 +8,8 @@
 #ifndef CORE_I_THREAD_POOL_H
 #define CORE_I_THREAD_POOL_H 1
 
-#include "Task.h"
+#include "TaskQueue.h"
+#include "CPUInfo.h"
 
 namespace greaper
 {
@@ -53,6 +54,11 @@ namespace greaper
 		uint32 DefaultCapacity = 1;
 		uint32 MaxCapacity = 1;
 		uint32 IdleTimeoutSeconds = 60;
+		bool PinWorkersToPhysicalCores = false; // Each worker gets the affinity of a different physical core, see ComputePhysicalCoreAffinities
+		int32 NUMANode = -1; // Keeps the workers, and the memory they first touch, on one node
+		ThreadPriority_t Priority = ThreadPriority_t::Normal;
+		ThreadSchedulingPolicy_t SchedulingPolicy = ThreadSchedulingPolicy_t::Default;
+		uint32 StarvationLimit = 8; // Times a lane with pending work can be skipped before it is served, see PriorityTaskQueue
 	};
 
 	class IThreadPool
@@ -60,7 +66,8 @@ namespace greaper
 	public:
 		virtual ~IThreadPool() = default;
 		
-		virtual HPooledTask RunTask(Task task) = 0;
+		/** Tasks are scheduled by priority lane and, inside a lane, earliest deadline first */
+		virtual HPooledTask RunTask(Task task, const TaskOptions& options = TaskOptions{}) = 0;
 
 		virtual void StopAll() = 0;
 
@@ -73,6 +80,9 @@ namespace greaper
 		virtual uint32 GetAllocatedThreadNum()const noexcept = 0;
 
 		virtual const StringView& GetName()const noexcept = 0;
+
+		/** Amount of tasks that finished after their deadline */
+		virtual uint64 GetDeadlineMisses()const noexcept = 0;
 	};
 
 
@@ -0,0 +1,297 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../LZCodec.h"
+
+#include <bit>
+
+namespace greaper
+{
+	namespace Impl
+	{
+		static constexpr sizet LZMinMatch = 4;
+		static constexpr sizet LZLastLiterals = 5; // The block always ends with literals
+		static constexpr sizet LZMatchFindLimit = 12; // No match starts this close to the end
+		static constexpr sizet LZMaxOffset = 65535;
+		static constexpr sizet LZWindowSize = 65536;
+
+		INLINE uint32 LZHash(const uint8* data, uint32 hashLog) noexcept
+		{
+			return (ReadUnaligned<uint32>(data) * 2654435761U) >> (32 - hashLog);
+		}
+
+		/** Length of the common prefix of a and b, without reading past limit */
+		INLINE sizet LZCount(const uint8* a, const uint8* b, const uint8* limit) noexcept
+		{
+			const auto* start = a;
+			while (a + 8 <= limit)
+			{
+				const auto diff = ReadUnaligned<uint64>(a) ^ ReadUnaligned<uint64>(b);
+				if (diff != 0)
+					return (sizet)(a - start) + (sizet)(std::countr_zero(diff) >> 3);
+				a += 8;
+				b += 8;
+			}
+			while (a < limit && *a == *b)
+			{
+				++a;
+				++b;
+			}
+			return (sizet)(a - start);
+		}
+
+		INLINE uint8* LZWriteLength(uint8* dst, sizet length) noexcept
+		{
+			for (; length >= 255; length -= 255)
+				*dst++ = 255;
+			*dst++ = (uint8)length;
+			return dst;
+		}
+
+		/** Writes the literals since the anchor followed by a match, matchLength 0 ends the block */
+		INLINE uint8* LZWriteSequence(uint8* dst, const uint8* literals, sizet literalLength, sizet offset, sizet matchLength) noexcept
+		{
+			auto* token = dst++;
+			*token = (uint8)(Min<sizet>(literalLength, 15) << 4);
+			if (literalLength >= 15)
+				dst = LZWriteLength(dst, literalLength - 15);
+			if (literalLength > 0)
+				memcpy(dst, literals, literalLength);
+			dst += literalLength;
+			if (matchLength == 0)
+				return dst;
+
+			WriteUnaligned<uint16>(dst, (uint16)offset);
+			dst += 2;
+			const auto extra = matchLength - LZMinMatch;
+			*token |= (uint8)Min<sizet>(extra, 15);
+			if (extra >= 15)
+				dst = LZWriteLength(dst, extra - 15);
+			return dst;
+		}
+	}
+
+	sizet LZCompressor::CompressFast(const uint8* src, const sizet size, uint8* dst)
+	{
+		using namespace Impl;
+		constexpr uint32 hashLog = FastHashLog;
+		m_Table.assign((sizet)1 << hashLog, 0);
+
+		auto* op = dst;
+		const auto* anchor = src;
+		if (size >= LZMatchFindLimit + 1)
+		{
+			const auto* ip = src;
+			const auto* findLimit = src + size - LZMatchFindLimit;
+			const auto* matchLimit = src + size - LZLastLiterals;
+			auto* table = m_Table.data();
+			table[LZHash(ip, hashLog)] = 1;
+			++ip;
+			while (ip <= findLimit)
+			{
+				// Each miss moves a little further, incompressible data is skipped quickly
+				const uint8* match = nullptr;
+				uint32 misses = 1 << 6;
+				while (ip <= findLimit)
+				{
+					const auto hash = LZHash(ip, hashLog);
+					const auto stored = (sizet)table[hash];
+					table[hash] = (uint32)(ip - src) + 1;
+					if (stored != 0)
+					{
+						const auto* candidate = src + stored - 1;
+						if ((sizet)(ip - candidate) <= LZMaxOffset && ReadUnaligned<uint32>(candidate) == ReadUnaligned<uint32>(ip))
+						{
+							match = candidate;
+							break;
+						}
+					}
+					ip += misses++ >> 6;
+				}
+				if (match == nullptr)
+					break;
+
+				while (ip > anchor && match > src && ip[-1] == match[-1])
+				{
+					--ip;
+					--match;
+				}
+				const auto length = LZMinMatch + LZCount(ip + LZMinMatch, match + LZMinMatch, matchLimit);
+				op = LZWriteSequence(op, anchor, (sizet)(ip - anchor), (sizet)(ip - match), length);
+				ip += length;
+				anchor = ip;
+				if (ip <= findLimit)
+					table[LZHash(ip - 2, hashLog)] = (uint32)(ip - 2 - src) + 1;
+			}
+		}
+		return (sizet)(LZWriteSequence(op, anchor, (sizet)(src + size - anchor), 0, 0) - dst);
+	}
+
+	sizet LZCompressor::CompressHigh(const uint8* src, const sizet size, uint8* dst)
+	{
+		using namespace Impl;
+		constexpr uint32 hashLog = HighHashLog;
+		m_Table.assign((sizet)1 << hashLog, 0);
+		m_Chain.assign(LZWindowSize, 0);
+
+		auto* op = dst;
+		const auto* anchor = src;
+		if (size >= LZMatchFindLimit + 1)
+		{
+			const auto* findLimit = src + size - LZMatchFindLimit;
+			const auto* matchLimit = src + size - LZLastLiterals;
+			auto* table = m_Table.data();
+			auto* chain = m_Chain.data();
+			const uint8* nextToInsert = src;
+
+			// Longest match for ip among the previous positions with its hash, returns its length or 0
+			const auto findBest = [&](const uint8* ip, const uint8*& best) -> sizet
+			{
+				for (; nextToInsert < ip; ++nextToInsert)
+				{
+					const auto hash = LZHash(nextToInsert, hashLog);
+					const auto position = (sizet)(nextToInsert - src);
+					const auto previous = (sizet)table[hash];
+					chain[position & (LZWindowSize - 1)] = previous == 0 ? 0 : (uint16)Min(position + 1 - previous, LZMaxOffset);
+					table[hash] = (uint32)position + 1;
+				}
+
+				sizet bestLength = 0;
+				const auto head = (sizet)table[LZHash(ip, hashLog)];
+				if (head == 0)
+					return 0;
+				const auto* candidate = src + head - 1;
+				for (uint32 attempt = 0; attempt < HighMaxAttempts && (sizet)(ip - candidate) <= LZMaxOffset; ++attempt)
+				{
+					// Checking the byte that would make it longer first rules most candidates out
+					if (ip + bestLength < matchLimit && candidate[bestLength] == ip[bestLength]
+						&& ReadUnaligned<uint32>(candidate) == ReadUnaligned<uint32>(ip))
+					{
+						const auto length = LZMinMatch + LZCount(ip + LZMinMatch, candidate + LZMinMatch, matchLimit);
+						if (length > bestLength)
+						{
+							bestLength = length;
+							best = candidate;
+						}
+					}
+					const auto position = (sizet)(candidate - src);
+					const auto delta = (sizet)chain[position & (LZWindowSize - 1)];
+					if (delta == 0 || delta > position)
+						break;
+					candidate -= delta;
+				}
+				return bestLength;
+			};
+
+			const auto* ip = src;
+			while (ip <= findLimit)
+			{
+				const uint8* match = nullptr;
+				auto length = findBest(ip, match);
+				if (length < LZMinMatch)
+				{
+					++ip;
+					continue;
+				}
+				// Lazy matching, a longer match one byte later is worth a literal
+				while (ip + 1 <= findLimit)
+				{
+					const uint8* nextMatch = nullptr;
+					const auto nextLength = findBest(ip + 1, nextMatch);
+					if (nextLength <= length)
+						break;
+					++ip;
+					match = nextMatch;
+					length = nextLength;
+				}
+				op = LZWriteSequence(op, anchor, (sizet)(ip - anchor), (sizet)(ip - match), length);
+				ip += length;
+				anchor = ip;
+			}
+		}
+		return (sizet)(LZWriteSequence(op, anchor, (sizet)(src + size - anchor), 0, 0) - dst);
+	}
+
+	sizet LZCompressor::Compress(const std::span<const uint8> src, const std::span<uint8> dst, const CompressionLevel_t level)
+	{
+		VerifyGreaterEqual(dst.size(), LZCompressBound(src.size()), "Trying to compress into a buffer smaller than LZCompressBound.");
+		if (level == CompressionLevel_t::High)
+			return CompressHigh(src.data(), src.size(), dst.data());
+		return CompressFast(src.data(), src.size(), dst.data());
+	}
+
+	ssizet LZDecompress(const std::span<const uint8> src, const std::span<uint8> dst) noexcept
+	{
+		using namespace Impl;
+		const auto* ip = src.data();
+		const auto* srcEnd = ip + src.size();
+		auto* op = dst.data();
+		auto* dstEnd = op + dst.size();
+
+		const auto readLength = [&](sizet& length) -> bool
+		{
+			uint8 byte;
+			do
+			{
+				if (ip >= srcEnd)
+					return false;
+				byte = *ip++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		};
+
+		while (ip < srcEnd)
+		{
+			const auto token = *ip++;
+			sizet literalLength = token >> 4;
+			if (literalLength == 15 && !readLength(literalLength))
+				return -1;
+			if (literalLength > (sizet)(srcEnd - ip) || literalLength > (sizet)(dstEnd - op))
+				return -1;
+			if (literalLength > 0)
+				memcpy(op, ip, literalLength);
+			ip += literalLength;
+			op += literalLength;
+			if (ip == srcEnd)
+				return (ssizet)(op - dst.data());
+
+			if (srcEnd - ip < 2)
+				return -1;
+			const auto offset = (sizet)ReadUnaligned<uint16>(ip);
+			ip += 2;
+			if (offset == 0 || offset > (sizet)(op - dst.data()))
+				return -1;
+			sizet matchLength = token & 15;
+			if (matchLength == 15 && !readLength(matchLength))
+				return -1;
+			matchLength += LZMinMatch;
+			if (matchLength > (sizet)(dstEnd - op))
+				return -1;
+
+			const auto* match = op - offset;
+			if (offset >= 8)
+			{
+				// Eight bytes at a time stay behind op as long as the offset is at least eight
+				auto* end = op + matchLength;
+				while (op + 8 <= end)
+				{
+					memcpy(op, match, 8);
+					op += 8;
+					match += 8;
+				}
+				while (op < end)
+					*op++ = *match++;
+			}
+			else
+			{
+				for (sizet i = 0; i < matchLength; ++i)
+					*op++ = *match++;
+			}
+		}
+		// A block always ends with a literal run, even an empty one
+		return -1;
+	}
+}
\ No newline at end of file
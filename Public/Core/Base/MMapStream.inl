@@ -0,0 +1,244 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../MMapStream.h"
+
+namespace greaper
+{
+	bool MMapStream::MapOffset(const int64 offset)const
+	{
+		if (m_View != nullptr && offset >= m_ViewOffset && offset < m_ViewOffset + (int64)m_ViewSize)
+			return true;
+		if (offset < 0 || offset >= m_FileSize)
+			return false;
+
+		Unmap();
+		int64 start = 0;
+		auto size = (sizet)m_FileSize;
+		if (m_WindowSize > 0)
+		{
+			// The window size is a multiple of the map granularity, so is the start
+			start = offset - offset % (int64)m_WindowSize;
+			size = (sizet)Min((int64)m_WindowSize, m_FileSize - start);
+		}
+		m_View = (uint8*)OSFile::Map(m_Handle, start, size, IsWritable(), m_Config.Populate);
+		if (m_View == nullptr)
+			return false;
+		m_ViewOffset = start;
+		m_ViewSize = size;
+		OSFile::AdviseMap(m_View, m_ViewSize, m_Config.AccessPattern, m_Config.WillNeed);
+		return true;
+	}
+
+	void MMapStream::Unmap()const
+	{
+		if (m_View == nullptr)
+			return;
+		OSFile::Unmap(m_View, m_ViewSize);
+		m_View = nullptr;
+		m_ViewSize = 0;
+		m_ViewOffset = 0;
+	}
+
+	bool MMapStream::Grow(const int64 size)
+	{
+		const auto newSize = Max(size, m_FileSize + Max((int64)m_Config.GrowthSize, m_FileSize / 2));
+		// Windows cannot resize a file with mapped views
+		Unmap();
+		if (!OSFile::Resize(m_Handle, newSize))
+			return false;
+		m_FileSize = newSize;
+		m_Grown = true;
+		return true;
+	}
+
+	MMapStream::MMapStream(StringView path, const uint16 accessMode, const MMapStreamConfig& config)
+		:IStream(path, accessMode)
+		,m_Config(config)
+		,m_Handle(OSFile::InvalidHandle)
+		,m_View(nullptr)
+		,m_ViewSize(0)
+		,m_ViewOffset(0)
+		,m_Position(0)
+		,m_FileSize(0)
+		,m_WindowSize(0)
+		,m_Grown(false)
+		,m_ReservedInPlace(false)
+	{
+		m_Size = 0;
+		const auto mode = IsWritable() ? config.OpenMode : FileOpenMode_t::OpenExisting;
+		// Writable mappings need read access too
+		m_Handle = OSFile::Open(m_Name.c_str(), true, IsWritable(), mode, config.AccessPattern);
+		if (!IsOpen())
+			return;
+
+		const auto size = OSFile::GetSize(m_Handle);
+		m_FileSize = size < 0 ? 0 : size;
+		m_Size = (ssizet)m_FileSize;
+		if (config.WindowSize > 0)
+		{
+			const auto granularity = OSFile::GetMapGranularity();
+			m_WindowSize = (config.WindowSize + granularity - 1) / granularity * granularity;
+		}
+		MapOffset(0);
+	}
+
+	MMapStream::~MMapStream()
+	{
+		Close();
+	}
+
+	uint8* MMapStream::GetCursor()const
+	{
+		if (MapOffset(m_Position))
+			return m_View + (m_Position - m_ViewOffset);
+		if (m_View != nullptr && m_Position == m_ViewOffset + (int64)m_ViewSize)
+			return m_View + m_ViewSize;
+		return nullptr;
+	}
+
+	sizet MMapStream::GetContiguousSize()const
+	{
+		if (m_Position >= m_Size || !MapOffset(m_Position))
+			return 0;
+		return (sizet)(Min(m_ViewOffset + (int64)m_ViewSize, (int64)m_Size) - m_Position);
+	}
+
+	ssizet MMapStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsReadable() || count <= 0)
+			return 0;
+
+		const auto total = Min((int64)count, (int64)m_Size - m_Position);
+		auto* dst = (uint8*)buf;
+		int64 done = 0;
+		while (done < total && MapOffset(m_Position))
+		{
+			const auto size = Min(total - done, m_ViewOffset + (int64)m_ViewSize - m_Position);
+			memcpy(dst + done, m_View + (m_Position - m_ViewOffset), (sizet)size);
+			m_Position += size;
+			done += size;
+		}
+		return (ssizet)done;
+	}
+
+	ssizet MMapStream::Write(const void* buf, ssizet count)
+	{
+		if (!IsWritable() || !IsOpen() || count <= 0)
+			return 0;
+
+		if (m_Position + count > m_FileSize && !Grow(m_Position + count))
+			return 0;
+
+		const auto* src = (const uint8*)buf;
+		int64 done = 0;
+		while (done < count && MapOffset(m_Position))
+		{
+			const auto size = Min((int64)count - done, m_ViewOffset + (int64)m_ViewSize - m_Position);
+			memcpy(m_View + (m_Position - m_ViewOffset), src + done, (sizet)size);
+			m_Position += size;
+			done += size;
+		}
+		m_Size = Max(m_Size, (ssizet)m_Position);
+		return (ssizet)done;
+	}
+
+	std::span<const uint8> MMapStream::ReadView(sizet count)const
+	{
+		if (!IsReadable())
+			return {};
+
+		count = (sizet)Min((int64)count, (int64)m_Size - m_Position);
+		if (count == 0)
+			return {};
+		if (GetContiguousSize() < count)
+			return IStream::ReadView(count);
+
+		const auto view = std::span<const uint8>(m_View + (m_Position - m_ViewOffset), count);
+		m_Position += (int64)count;
+		return view;
+	}
+
+	std::span<uint8> MMapStream::WriteReserve(const sizet count)
+	{
+		m_ReservedInPlace = false;
+		if (!IsWritable() || !IsOpen() || count == 0)
+			return {};
+
+		if (m_Position + (int64)count > m_FileSize && !Grow(m_Position + (int64)count))
+			return {};
+		if (!MapOffset(m_Position) || m_ViewOffset + (int64)m_ViewSize - m_Position < (int64)count)
+			return IStream::WriteReserve(count);
+
+		m_ReservedInPlace = true;
+		return { m_View + (m_Position - m_ViewOffset), count };
+	}
+
+	void MMapStream::WriteCommit(const sizet count)
+	{
+		if (!m_ReservedInPlace)
+		{
+			IStream::WriteCommit(count);
+			return;
+		}
+		m_ReservedInPlace = false;
+		m_Position += (int64)count;
+		m_Size = Max(m_Size, (ssizet)m_Position);
+	}
+
+	void MMapStream::Skip(const ssizet count)
+	{
+		Seek(Tell() + count);
+	}
+
+	void MMapStream::Seek(const ssizet pos)
+	{
+		VerifyLessEqual(pos, m_Size, "Trying to seek a MMapStream outside of its bounds.");
+		VerifyGreaterEqual(pos, 0, "Trying to seek a MMapStream outside of its bounds.");
+		m_Position = Clamp(pos, (ssizet)0, m_Size);
+	}
+
+	SPtr<IStream> MMapStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		auto config = m_Config;
+		config.OpenMode = FileOpenMode_t::OpenExisting;
+		auto clone = std::make_shared<MMapStream>(m_Name, (uint16)READ, config);
+		// The file may still have the growth slack at its end, this stream trims it
+		clone->m_Size = Min(clone->m_Size, m_Size);
+		clone->Seek(Tell());
+		return clone;
+	}
+
+	void MMapStream::Close()
+	{
+		Unmap();
+		if (!IsOpen())
+			return;
+		if (IsWritable() && m_Grown && m_FileSize != (int64)m_Size)
+			OSFile::Resize(m_Handle, m_Size);
+		OSFile::Close(m_Handle);
+		m_Handle = OSFile::InvalidHandle;
+		m_FileSize = m_Size;
+		m_Grown = false;
+	}
+
+	bool MMapStream::Flush(const bool syncDevice)
+	{
+		if (!IsOpen())
+			return false;
+		const auto flushed = m_View == nullptr || !IsWritable() || OSFile::FlushMap(m_View, m_ViewSize);
+		if (!syncDevice || !flushed)
+			return flushed;
+		return OSFile::Sync(m_Handle);
+	}
+
+	void MMapStream::SetAccessPattern(const FileAccessPattern_t pattern)
+	{
+		m_Config.AccessPattern = pattern;
+		if (m_View != nullptr)
+			OSFile::AdviseMap(m_View, m_ViewSize, pattern, false);
+	}
+}
\ No newline at end of file
@@ -9,19 +9,21 @@ namespace greaper
 {
 	void MemoryStream::Realloc(const sizet bytes)
 	{
-		if (bytes == m_Size)
+		if (bytes == m_Capacity)
 			return;
 
-		VerifyGreater(bytes, m_Size, "Realloc should always increase the size of the MemoryStream.");
+		const auto size = (sizet)(m_End - m_Data);
+		VerifyGreaterEqual(bytes, size, "Realloc cannot drop the data of the MemoryStream.");
 
-		auto* buffer = (uint8*)Alloc(bytes);
+		auto* buffer = bytes > 0 ? (uint8*)m_Allocate(bytes) : nullptr;
 		if (m_Data != nullptr)
 		{
 			m_Cursor = buffer + (m_Cursor - m_Data);
-			m_End = buffer + (m_End - m_Data);
+			m_End = buffer + size;
 
-			memcpy(buffer, m_Data, m_Size);
-			Dealloc(m_Data);
+			if (size > 0)
+				memcpy(buffer, m_Data, size);
+			m_Deallocate(m_Data);
 		}
 		else
 		{
@@ -30,7 +32,19 @@ namespace greaper
 		}
 
 		m_Data = buffer;
-		m_Size = bytes;
+		m_Capacity = bytes;
+	}
+
+	sizet MemoryStream::PrepareWrite(const sizet count)
+	{
+		const auto currentSize = (sizet)(m_Cursor - m_Data);
+		const auto newSize = currentSize + count;
+		if (newSize <= m_Capacity)
+			return count;
+		if (!m_OwnsMemory)
+			return m_Capacity - currentSize;
+		Realloc(Max(newSize, Max(m_Capacity * 2, MinimumCapacity)));
+		return count;
 	}
 
 	MemoryStream::MemoryStream()
@@ -38,20 +52,18 @@ namespace greaper
 		,m_Data(nullptr)
 		,m_Cursor(nullptr)
 		,m_End(nullptr)
+		,m_Capacity(0)
 		,m_OwnsMemory(true)
+		,m_Allocate(&MemoryAllocator<GenericAllocator>::Allocate)
+		,m_Deallocate(&MemoryAllocator<GenericAllocator>::Deallocate)
 	{
-
+		m_Size = 0;
 	}
 
 	MemoryStream::MemoryStream(const sizet capacity)
-		:IStream(READ | WRITE)
-		, m_Data(nullptr)
-		, m_Cursor(nullptr)
-		, m_End(nullptr)
-		, m_OwnsMemory(true)
+		:MemoryStream(capacity, GenericAllocator{})
 	{
-		Realloc(capacity);
-		m_End = m_Cursor + capacity;
+
 	}
 
 	MemoryStream::MemoryStream(void* memory, const sizet size)
@@ -59,7 +71,10 @@ namespace greaper
 		, m_Data((uint8*)memory)
 		, m_Cursor((uint8*)memory)
 		, m_End((uint8*)memory + size)
+		, m_Capacity(size)
 		, m_OwnsMemory(false)
+		, m_Allocate(&MemoryAllocator<GenericAllocator>::Allocate)
+		, m_Deallocate(&MemoryAllocator<GenericAllocator>::Deallocate)
 	{
 		m_Size = size;
 	}
@@ -69,13 +84,19 @@ namespace greaper
 		, m_Data(nullptr)
 		, m_Cursor(nullptr)
 		, m_End(nullptr)
+		, m_Capacity(0)
 		, m_OwnsMemory(true)
+		, m_Allocate(other.m_Allocate)
+		, m_Deallocate(other.m_Deallocate)
 	{
-		m_Size = other.Size();
-		m_Data = m_Cursor = (uint8*)Alloc(m_Size);
-		m_End = m_Data + (other.m_End - other.m_Data);
+		m_Size = 0;
 		m_Access = other.m_Access;
-		VerifyGreater(m_End, m_Cursor, "Cursor outside of bounds.");
+		Realloc(other.Size());
+		if (other.Size() > 0)
+			memcpy(m_Data, other.m_Data, other.Size());
+		m_End = m_Data + other.Size();
+		m_Cursor = m_Data + (other.m_Cursor - other.m_Data);
+		m_Size = other.Size();
 	}
 
 	MemoryStream& MemoryStream::operator=(const MemoryStream& other)
@@ -85,23 +106,27 @@ namespace greaper
 			m_Name = other.m_Name;
 			m_Access = other.m_Access;
 			if (m_Data && m_OwnsMemory)
-				Dealloc(m_Data);
+				m_Deallocate(m_Data);
+			m_Allocate = other.m_Allocate;
+			m_Deallocate = other.m_Deallocate;
 			if (other.m_OwnsMemory)
 			{
 				m_Size = 0;
+				m_Capacity = 0;
 				m_Data = m_Cursor = m_End = nullptr;
 				m_OwnsMemory = true;
 
 				Realloc(other.m_Size);
-				m_End = m_Data + m_Size;
+				if (other.m_Size > 0)
+					memcpy(m_Data, other.m_Data, other.m_Size);
+				m_End = m_Data + other.m_Size;
 				m_Cursor = m_Data + (other.m_Cursor - other.m_Data);
-
-				if (m_Size > 0)
-					memcpy(m_Data, other.m_Data, m_Size);
+				m_Size = other.m_Size;
 			}
 			else
 			{
 				m_Size = other.m_Size;
+				m_Capacity = other.m_Capacity;
 				m_Data = other.m_Data;
 				m_Cursor = other.m_Cursor;
 				m_End = other.m_End;
@@ -116,7 +141,10 @@ namespace greaper
 		,m_Data(std::exchange(other.m_Data, nullptr))
 		,m_Cursor(std::exchange(other.m_Cursor, nullptr))
 		,m_End(std::exchange(other.m_End, nullptr))
+		,m_Capacity(std::exchange(other.m_Capacity, 0))
 		,m_OwnsMemory(std::exchange(other.m_OwnsMemory, false))
+		,m_Allocate(other.m_Allocate)
+		,m_Deallocate(other.m_Deallocate)
 	{
 		m_Size = std::exchange(other.m_Size, 0);
 		m_Name = std::move(other.m_Name);
@@ -128,7 +156,7 @@ namespace greaper
 		if (this != &other)
 		{
 			if (m_Data && m_OwnsMemory)
-				Dealloc(m_Data);
+				m_Deallocate(m_Data);
 
 			m_Name = std::move(other.m_Name);
 			m_Size = std::exchange(other.m_Size, 0);
@@ -136,7 +164,10 @@ namespace greaper
 			m_Data = std::exchange(other.m_Data, nullptr);
 			m_Cursor = std::exchange(other.m_Cursor, nullptr);
 			m_End = std::exchange(other.m_End, nullptr);
+			m_Capacity = std::exchange(other.m_Capacity, 0);
 			m_OwnsMemory = std::exchange(other.m_OwnsMemory, false);
+			m_Allocate = other.m_Allocate;
+			m_Deallocate = other.m_Deallocate;
 		}
 		return *this;
 	}
@@ -146,6 +177,22 @@ namespace greaper
 		Close();
 	}
 
+	void MemoryStream::Reserve(const sizet bytes)
+	{
+		if (bytes <= m_Capacity)
+			return;
+		Verify(m_OwnsMemory, "Trying to reserve memory on a MemoryStream that doesn't own its buffer.");
+		if (m_OwnsMemory)
+			Realloc(bytes);
+	}
+
+	void MemoryStream::ShrinkToFit()
+	{
+		if (!m_OwnsMemory || m_Capacity == (sizet)m_Size)
+			return;
+		Realloc((sizet)m_Size);
+	}
+
 	ssizet MemoryStream::Read(void* buf, ssizet count) const
 	{
 		if(!IsReadable() || count <= 0)
@@ -168,25 +215,96 @@ namespace greaper
 		if (!IsWritable() || count <= 0)
 			return 0;
 
-		const auto currentSize = (m_Cursor - m_Data);
-		const auto newSize = currentSize + count;
-		if (newSize > m_Size)
-		{
-			if (m_OwnsMemory)
-				Realloc(newSize);
-			else
-				count = m_Size - currentSize;
-		}
-
+		count = (ssizet)PrepareWrite((sizet)count);
 		if (count <= 0)
 			return 0;
 
 		memcpy(m_Cursor, buf, count);
 		m_Cursor += count;
 		m_End = Max(m_Cursor, m_End);
+		m_Size = m_End - m_Data;
 		return count;
 	}
 
+	ssizet MemoryStream::ReadV(const std::span<const IOVec> vecs)const
+	{
+		if (!IsReadable() || m_Cursor == nullptr)
+			return 0;
+
+		const auto* start = m_Cursor;
+		for (const auto& vec : vecs)
+		{
+			const auto size = Min(vec.Size, (sizet)(m_End - m_Cursor));
+			if (size > 0)
+				memcpy(vec.Data, m_Cursor, size);
+			m_Cursor += size;
+			if (size < vec.Size)
+				break;
+		}
+		return m_Cursor - start;
+	}
+
+	ssizet MemoryStream::WriteV(const std::span<const IOVec> vecs)
+	{
+		if (!IsWritable())
+			return 0;
+
+		sizet total = 0;
+		for (const auto& vec : vecs)
+			total += vec.Size;
+		auto room = PrepareWrite(total);
+		if (room == 0)
+			return 0;
+
+		const auto* start = m_Cursor;
+		for (const auto& vec : vecs)
+		{
+			const auto size = Min(vec.Size, room);
+			if (size > 0)
+				memcpy(m_Cursor, vec.Data, size);
+			m_Cursor += size;
+			room -= size;
+			if (room == 0)
+				break;
+		}
+		m_End = Max(m_Cursor, m_End);
+		m_Size = m_End - m_Data;
+		return m_Cursor - start;
+	}
+
+	std::span<const uint8> MemoryStream::ReadView(sizet count)const
+	{
+		if (!IsReadable() || m_Cursor == nullptr)
+			return {};
+
+		count = Min(count, (sizet)(m_End - m_Cursor));
+		const auto view = std::span<const uint8>(m_Cursor, count);
+		m_Cursor += count;
+		return view;
+	}
+
+	std::span<uint8> MemoryStream::WriteReserve(const sizet count)
+	{
+		if (!IsWritable())
+			return {};
+
+		const auto size = PrepareWrite(count);
+		if (size == 0)
+			return {};
+		return { m_Cursor, size };
+	}
+
+	void MemoryStream::WriteCommit(const sizet count)
+	{
+		if (count == 0)
+			return;
+
+		VerifyLessEqual(m_Cursor + count, m_Data + m_Capacity, "Trying to commit more bytes than reserved on a MemoryStream.");
+		m_Cursor += count;
+		m_End = Max(m_Cursor, m_End);
+		m_Size = m_End - m_Data;
+	}
+
 	void MemoryStream::Skip(const ssizet count)
 	{
 		VerifyLessEqual(m_Cursor + count, m_End, "Trying to skip a MemoryStream outside of its bounds.");
@@ -211,9 +329,14 @@ namespace greaper
 		if (m_Data != nullptr)
 		{
 			if (m_OwnsMemory)
-				Dealloc(m_Data);
+				m_Deallocate(m_Data);
 			m_Data = nullptr;
 		}
+		// The inlined ReadArray and WriteArray only check the cursor against these
+		m_Cursor = nullptr;
+		m_End = nullptr;
+		m_Capacity = 0;
+		m_Size = 0;
 	}
 
 	uint8* MemoryStream::DisownMemory()
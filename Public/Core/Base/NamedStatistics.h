@@ -0,0 +1,140 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_NAMED_STATISTICS_H
+#define CORE_NAMED_STATISTICS_H 1
+
+#include "../Concurrency.h"
+
+namespace greaper::Impl
+{
+	/** Key part of a NamedStatisticsTable entry, TName is either a view or an owned String */
+	template<class TName>
+	struct NamedStatisticsEntry
+	{
+		std::atomic<uint64> Hash{ 0 };
+		std::atomic<uint32> Ready{ 0 };
+		TName Name;
+	};
+
+	/**
+	 * Lock-free open-addressing table of statistics by name, entries are never
+	 * removed so a name keeps its entry once recorded. Once Capacity different
+	 * names are recorded, new names are accumulated in a shared "<overflow>"
+	 * entry. TEntry derives from NamedStatisticsEntry and provides
+	 * Snapshot(TSnapshot&) and Reset().
+	 */
+	template<class TEntry, uint32 Capacity>
+	class NamedStatisticsTable
+	{
+		mutable TEntry m_Entries[Capacity];
+		mutable TEntry m_Overflow;
+
+		static uint64 HashName(const StringView& name) noexcept
+		{
+			uint64 hash = 14695981039346656037ull;
+			for (const auto c : name)
+			{
+				hash ^= static_cast<uint8>(c);
+				hash *= 1099511628211ull;
+			}
+			return hash == 0 ? 1 : hash; // 0 marks a free entry
+		}
+
+		TEntry* FindEntry(const StringView& name, bool create)const
+		{
+			const auto hash = HashName(name);
+			for (uint32 probe = 0; probe < Capacity; ++probe)
+			{
+				auto& entry = m_Entries[(hash + probe) % Capacity];
+				auto entryHash = entry.Hash.load(std::memory_order_acquire);
+				if (entryHash == 0)
+				{
+					if (!create)
+						return nullptr;
+					if (entry.Hash.compare_exchange_strong(entryHash, hash, std::memory_order_acq_rel))
+					{
+						entry.Name = decltype(entry.Name)(name);
+						entry.Ready.store(1, std::memory_order_release);
+						return &entry;
+					}
+				}
+				if (entryHash != hash)
+					continue;
+				// Another thread may still be publishing the name
+				while (entry.Ready.load(std::memory_order_acquire) == 0)
+					CPU_PAUSE();
+				if (entry.Name == name)
+					return &entry;
+			}
+			if (!create)
+				return nullptr;
+			if (m_Overflow.Ready.load(std::memory_order_relaxed) == 0)
+				m_Overflow.Ready.store(1, std::memory_order_release);
+			return &m_Overflow;
+		}
+
+	public:
+		NamedStatisticsTable()
+		{
+			m_Overflow.Name = decltype(m_Overflow.Name)("<overflow>"sv);
+		}
+		NamedStatisticsTable(const NamedStatisticsTable&) = delete;
+		NamedStatisticsTable& operator=(const NamedStatisticsTable&) = delete;
+		~NamedStatisticsTable() = default;
+
+		/** Never fails, names past the capacity share the overflow entry */
+		INLINE TEntry& FindOrCreate(const StringView& name)const
+		{
+			return *FindEntry(name, true);
+		}
+
+		/** Returns false if nothing with that name has been recorded */
+		template<class TSnapshot>
+		INLINE bool GetSnapshot(const StringView& name, TSnapshot& snapshot)const
+		{
+			const auto* entry = FindEntry(name, false);
+			if (entry == nullptr)
+				return false;
+			entry->Snapshot(snapshot);
+			return true;
+		}
+
+		template<class TSnapshot>
+		[[nodiscard]] INLINE Vector<TSnapshot> GetAllSnapshots()const
+		{
+			Vector<TSnapshot> snapshots;
+			for (const auto& entry : m_Entries)
+			{
+				if (entry.Ready.load(std::memory_order_acquire) == 0)
+					continue;
+				entry.Snapshot(snapshots.emplace_back());
+			}
+			if (m_Overflow.Ready.load(std::memory_order_acquire) != 0)
+				m_Overflow.Snapshot(snapshots.emplace_back());
+			return snapshots;
+		}
+
+		/** Clears the counters, the known names are kept */
+		INLINE void Reset() noexcept
+		{
+			for (auto& entry : m_Entries)
+				entry.Reset();
+			m_Overflow.Reset();
+		}
+	};
+
+	/** Global sink of a statistics type, timing is only done while it is set */
+	template<class TStatistics>
+	INLINE std::atomic<TStatistics*>& GetStatisticsSinkRef() noexcept
+	{
+		static std::atomic<TStatistics*> sink{ nullptr };
+		return sink;
+	}
+}
+
+#endif /* CORE_NAMED_STATISTICS_H */
\ No newline at end of file
@@ -0,0 +1,350 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+//#include "../PipeStream.h"
+
+#include <bit>
+
+namespace greaper
+{
+	Impl::PipeRing::PipeRing(const PipeStreamConfig& config)
+		:Head(0)
+		,ReaderNeed(0)
+		,ReaderSeq(0)
+		,ReaderClosed(false)
+		,Tail(0)
+		,WriterNeed(0)
+		,WriterSeq(0)
+		,WriterClosed(false)
+		,Data(nullptr)
+		,Capacity(std::bit_ceil(Max(config.Capacity, (sizet)2)))
+		,WakeThreshold(config.WakeThreshold)
+	{
+		if (WakeThreshold == 0)
+			WakeThreshold = Capacity / 4;
+		// Both ends parked would need more than the capacity between them, so they can't deadlock
+		WakeThreshold = Clamp(WakeThreshold, (sizet)1, Capacity / 2);
+		Data = (uint8*)Alloc(Capacity);
+	}
+
+	Impl::PipeRing::~PipeRing()
+	{
+		Dealloc(Data);
+	}
+
+	void Impl::PipeRing::WaitForData(const uint64 head, const sizet need)
+	{
+		for (uint32 i = 0; i < SpinCount; ++i)
+		{
+			if (Tail.load(std::memory_order_acquire) - head >= need || WriterClosed.load(std::memory_order_acquire))
+				return;
+			CPU_PAUSE();
+		}
+
+		const auto seq = ReaderSeq.load(std::memory_order_acquire);
+		ReaderNeed.store(need, std::memory_order_relaxed);
+		// Pairs with the fence in WakeReader, either we see the new Tail or the writer sees ReaderNeed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (Tail.load(std::memory_order_acquire) - head < need && !WriterClosed.load(std::memory_order_acquire))
+			WaitOnAddress(ReaderSeq, seq);
+		ReaderNeed.store(0, std::memory_order_relaxed);
+	}
+
+	void Impl::PipeRing::WaitForSpace(const uint64 tail, const sizet need)
+	{
+		for (uint32 i = 0; i < SpinCount; ++i)
+		{
+			if (Capacity - (tail - Head.load(std::memory_order_acquire)) >= need || ReaderClosed.load(std::memory_order_acquire))
+				return;
+			CPU_PAUSE();
+		}
+
+		const auto seq = WriterSeq.load(std::memory_order_acquire);
+		WriterNeed.store(need, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (Capacity - (tail - Head.load(std::memory_order_acquire)) < need && !ReaderClosed.load(std::memory_order_acquire))
+			WaitOnAddress(WriterSeq, seq);
+		WriterNeed.store(0, std::memory_order_relaxed);
+	}
+
+	void Impl::PipeRing::WakeReader(const uint64 tail, const bool force)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto need = ReaderNeed.load(std::memory_order_relaxed);
+		if (need == 0)
+			return;
+		const auto available = tail - Head.load(std::memory_order_relaxed);
+		if (available < need && !(force && available > 0))
+			return;
+		ReaderSeq.fetch_add(1, std::memory_order_release);
+		WakeByAddressSingle(ReaderSeq);
+	}
+
+	void Impl::PipeRing::WakeWriter(const uint64 head)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto need = WriterNeed.load(std::memory_order_relaxed);
+		if (need == 0)
+			return;
+		if (Capacity - (Tail.load(std::memory_order_relaxed) - head) < need)
+			return;
+		WriterSeq.fetch_add(1, std::memory_order_release);
+		WakeByAddressSingle(WriterSeq);
+	}
+
+	void Impl::PipeRing::CopyIn(const uint64 position, const uint8* src, const sizet size)
+	{
+		const auto offset = (sizet)position & (Capacity - 1);
+		const auto first = Min(size, Capacity - offset);
+		memcpy(Data + offset, src, first);
+		if (first < size)
+			memcpy(Data, src + first, size - first);
+	}
+
+	void Impl::PipeRing::CopyOut(const uint64 position, uint8* dst, const sizet size)const
+	{
+		const auto offset = (sizet)position & (Capacity - 1);
+		const auto first = Min(size, Capacity - offset);
+		memcpy(dst, Data + offset, first);
+		if (first < size)
+			memcpy(dst + first, Data, size - first);
+	}
+
+	PipeWriterStream::PipeWriterStream(SPtr<Impl::PipeRing> ring)
+		:IStream(WRITE)
+		,m_Ring(std::move(ring))
+	{
+		m_Size = 0;
+	}
+
+	PipeWriterStream::~PipeWriterStream()
+	{
+		Close();
+	}
+
+	ssizet PipeWriterStream::Read(void* buf, ssizet count)const
+	{
+		UNUSED(buf);
+		UNUSED(count);
+		return 0;
+	}
+
+	ssizet PipeWriterStream::Write(const void* buf, ssizet count)
+	{
+		if (!IsWritable() || m_Ring == nullptr || count <= 0)
+			return 0;
+
+		auto& ring = *m_Ring;
+		const auto* src = (const uint8*)buf;
+		auto tail = ring.Tail.load(std::memory_order_relaxed);
+		sizet done = 0;
+		while (done < (sizet)count && !ring.ReaderClosed.load(std::memory_order_acquire))
+		{
+			const auto space = ring.Capacity - (sizet)(tail - ring.Head.load(std::memory_order_acquire));
+			if (space == 0)
+			{
+				ring.WaitForSpace(tail, Min((sizet)count - done, ring.WakeThreshold));
+				continue;
+			}
+			const auto size = Min(space, (sizet)count - done);
+			ring.CopyIn(tail, src + done, size);
+			tail += size;
+			done += size;
+			ring.Tail.store(tail, std::memory_order_release);
+			ring.WakeReader(tail, false);
+		}
+		m_Size += (ssizet)done;
+		return (ssizet)done;
+	}
+
+	void PipeWriterStream::Skip(const ssizet count)
+	{
+		Verify(count == 0, "Trying to skip on the writing end of a pipe.");
+	}
+
+	void PipeWriterStream::Seek(const ssizet pos)
+	{
+		Verify(pos == Tell(), "Trying to seek on the writing end of a pipe.");
+	}
+
+	bool PipeWriterStream::Eof()const
+	{
+		return m_Ring == nullptr || m_Ring->ReaderClosed.load(std::memory_order_acquire);
+	}
+
+	SPtr<IStream> PipeWriterStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		return SPtr<IStream>();
+	}
+
+	void PipeWriterStream::Close()
+	{
+		if (m_Ring == nullptr)
+			return;
+		auto& ring = *m_Ring;
+		ring.WriterClosed.store(true, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		ring.ReaderSeq.fetch_add(1, std::memory_order_release);
+		WakeByAddressSingle(ring.ReaderSeq);
+		m_Ring.reset();
+	}
+
+	void PipeWriterStream::Flush()
+	{
+		if (m_Ring != nullptr)
+			m_Ring->WakeReader(m_Ring->Tail.load(std::memory_order_relaxed), true);
+	}
+
+	sizet PipeReaderStream::Consume(uint8* dst, const sizet count)const
+	{
+		ReleaseView();
+		auto& ring = *m_Ring;
+		auto head = ring.Head.load(std::memory_order_relaxed);
+		sizet done = 0;
+		while (done < count)
+		{
+			const auto available = (sizet)(ring.Tail.load(std::memory_order_acquire) - head);
+			if (available == 0)
+			{
+				// Tail is loaded again after seeing the close, it may have moved just before it
+				if (ring.WriterClosed.load(std::memory_order_acquire) && ring.Tail.load(std::memory_order_acquire) == head)
+					break;
+				ring.WaitForData(head, Min(count - done, ring.WakeThreshold));
+				continue;
+			}
+			const auto size = Min(available, count - done);
+			if (dst != nullptr)
+				ring.CopyOut(head, dst + done, size);
+			head += size;
+			done += size;
+			ring.Head.store(head, std::memory_order_release);
+			ring.WakeWriter(head);
+		}
+		m_Position += (ssizet)done;
+		return done;
+	}
+
+	void PipeReaderStream::ReleaseView()const
+	{
+		if (m_Held == 0)
+			return;
+		auto& ring = *m_Ring;
+		const auto head = ring.Head.load(std::memory_order_relaxed) + m_Held;
+		m_Held = 0;
+		ring.Head.store(head, std::memory_order_release);
+		ring.WakeWriter(head);
+	}
+
+	PipeReaderStream::PipeReaderStream(SPtr<Impl::PipeRing> ring)
+		:IStream(READ)
+		,m_Ring(std::move(ring))
+		,m_Position(0)
+		,m_Held(0)
+	{
+		m_Size = 0;
+	}
+
+	PipeReaderStream::~PipeReaderStream()
+	{
+		Close();
+	}
+
+	ssizet PipeReaderStream::Read(void* buf, ssizet count)const
+	{
+		if (!IsReadable() || m_Ring == nullptr || count <= 0)
+			return 0;
+		return (ssizet)Consume((uint8*)buf, (sizet)count);
+	}
+
+	ssizet PipeReaderStream::Write(const void* buf, ssizet count)
+	{
+		UNUSED(buf);
+		UNUSED(count);
+		return 0;
+	}
+
+	std::span<const uint8> PipeReaderStream::ReadView(sizet count)const
+	{
+		if (!IsReadable() || m_Ring == nullptr || count == 0)
+			return {};
+		auto& ring = *m_Ring;
+		// Waiting for more would let the reader and a parked writer need more than the capacity
+		if (count > ring.Capacity - ring.WakeThreshold)
+			return IStream::ReadView(count);
+
+		ReleaseView();
+		const auto head = ring.Head.load(std::memory_order_relaxed);
+		auto available = (sizet)(ring.Tail.load(std::memory_order_acquire) - head);
+		while (available < count)
+		{
+			if (ring.WriterClosed.load(std::memory_order_acquire))
+			{
+				available = (sizet)(ring.Tail.load(std::memory_order_acquire) - head);
+				count = Min(count, available);
+				break;
+			}
+			ring.WaitForData(head, count);
+			available = (sizet)(ring.Tail.load(std::memory_order_acquire) - head);
+		}
+		if (count == 0)
+			return {};
+
+		const auto offset = (sizet)head & (ring.Capacity - 1);
+		if (offset + count > ring.Capacity)
+			return IStream::ReadView(count);
+
+		// Head is only moved on the next call, so the writer can't reuse the bytes while they are viewed
+		m_Held = count;
+		m_Position += (ssizet)count;
+		return { ring.Data + offset, count };
+	}
+
+	void PipeReaderStream::Skip(const ssizet count)
+	{
+		VerifyGreaterEqual(count, 0, "Trying to skip backwards on the reading end of a pipe.");
+		if (m_Ring != nullptr && count > 0)
+			Consume(nullptr, (sizet)count);
+	}
+
+	void PipeReaderStream::Seek(const ssizet pos)
+	{
+		Skip(pos - Tell());
+	}
+
+	bool PipeReaderStream::Eof()const
+	{
+		if (m_Ring == nullptr)
+			return true;
+		const auto& ring = *m_Ring;
+		return ring.WriterClosed.load(std::memory_order_acquire)
+			&& ring.Tail.load(std::memory_order_acquire) == ring.Head.load(std::memory_order_relaxed) + m_Held;
+	}
+
+	SPtr<IStream> PipeReaderStream::Clone(const bool copyData)const
+	{
+		UNUSED(copyData);
+		return SPtr<IStream>();
+	}
+
+	void PipeReaderStream::Close()
+	{
+		if (m_Ring == nullptr)
+			return;
+		ReleaseView();
+		auto& ring = *m_Ring;
+		ring.ReaderClosed.store(true, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		ring.WriterSeq.fetch_add(1, std::memory_order_release);
+		WakeByAddressSingle(ring.WriterSeq);
+		m_Ring.reset();
+	}
+
+	PipeStreamPair CreatePipeStream(const PipeStreamConfig& config)
+	{
+		auto ring = std::make_shared<Impl::PipeRing>(config);
+		return PipeStreamPair{ std::make_shared<PipeWriterStream>(ring), std::make_shared<PipeReaderStream>(ring) };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_POOLED_BLOCK_CACHE_H
+#define CORE_POOLED_BLOCK_CACHE_H 1
+
+#include "../Memory.h"
+#include <atomic>
+#include <new>
+
+namespace greaper::Impl
+{
+	/**
+	 * Per-thread free list of equally sized blocks. Every block remembers the
+	 * thread cache it came from and always goes back to it: the owner thread
+	 * frees into its list directly, other threads push onto the owner's
+	 * lock-free return list, which the owner takes whole once its list runs
+	 * dry. So a thread that only produces operations which are completed and
+	 * released elsewhere still reuses its blocks. A cache outlives its thread
+	 * until the last of its blocks comes back.
+	 */
+	template<sizet BlockSize, sizet BlockAlign>
+	class PooledBlockCache
+	{
+		static constexpr uint32 MaxCachedBlocks = 128;
+		static constexpr sizet HeaderSize = BlockAlign; // Keeps the block itself aligned
+
+		struct Owner;
+
+		struct BlockHeader
+		{
+			Owner* BlockOwner; // nullptr when the block bypasses the caches
+		};
+		static_assert(sizeof(BlockHeader) <= HeaderSize, "PooledBlockCache alignment is too small for the block header.");
+
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		struct Owner
+		{
+			FreeBlock* Head = nullptr;
+			uint32 Count = 0;
+			int64 Outstanding = 0; // Allocated minus freed by the owner thread, only touched by it
+			alignas(64) std::atomic<FreeBlock*> Returned{ nullptr };
+			std::atomic<int64> RemoteFreed{ 0 }; // Negated count of blocks freed by other threads, the owner adds Outstanding on exit
+
+			void TakeReturned() noexcept
+			{
+				auto* block = Returned.exchange(nullptr, std::memory_order_acquire);
+				while (block != nullptr)
+				{
+					auto* next = block->Next;
+					if (Count < MaxCachedBlocks)
+					{
+						block->Next = Head;
+						Head = block;
+						++Count;
+					}
+					else
+					{
+						FreeBase(block);
+					}
+					block = next;
+				}
+			}
+
+			void ReleaseAll() noexcept
+			{
+				while (Head != nullptr)
+				{
+					auto* block = Head;
+					Head = block->Next;
+					FreeBase(block);
+				}
+				Count = 0;
+				auto* block = Returned.exchange(nullptr, std::memory_order_acquire);
+				while (block != nullptr)
+				{
+					auto* next = block->Next;
+					FreeBase(block);
+					block = next;
+				}
+			}
+		};
+
+		// Trivially destructible, so it is still usable while other thread-locals are destroyed
+		struct Local
+		{
+			Owner* Current;
+			bool Closed;
+		};
+
+		struct CacheCleaner
+		{
+			~CacheCleaner()
+			{
+				auto& local = GetLocal();
+				auto* owner = local.Current;
+				local.Current = nullptr;
+				local.Closed = true;
+				if (owner == nullptr)
+					return;
+				owner->ReleaseAll();
+				// Whoever brings the live count to zero, this thread or the last remote free, destroys the owner
+				if (owner->RemoteFreed.fetch_add(owner->Outstanding, std::memory_order_acq_rel) + owner->Outstanding == 0)
+					DestroyOwner(owner);
+			}
+		};
+
+		static Local& GetLocal() noexcept
+		{
+			static thread_local Local local{ nullptr, false };
+			return local;
+		}
+
+		INLINE static BlockHeader* GetHeader(void* block) noexcept
+		{
+			return reinterpret_cast<BlockHeader*>(static_cast<uint8*>(block) - HeaderSize);
+		}
+
+		INLINE static void FreeBase(void* block) noexcept
+		{
+			MemoryAllocator<GenericAllocator>::DeallocateAligned(GetHeader(block));
+		}
+
+		static void* AllocateBlock(Owner* owner) noexcept
+		{
+			auto* base = static_cast<uint8*>(MemoryAllocator<GenericAllocator>::AllocateAligned(HeaderSize + BlockSize, BlockAlign));
+			reinterpret_cast<BlockHeader*>(base)->BlockOwner = owner;
+			return base + HeaderSize;
+		}
+
+		static void DestroyOwner(Owner* owner) noexcept
+		{
+			owner->ReleaseAll();
+			owner->~Owner();
+			MemoryAllocator<GenericAllocator>::DeallocateAligned(owner);
+		}
+
+		static Owner* CreateOwner(Local& local) noexcept
+		{
+			static thread_local CacheCleaner cleaner;
+			void* mem = MemoryAllocator<GenericAllocator>::AllocateAligned(sizeof(Owner), alignof(Owner));
+			local.Current = new(mem)Owner();
+			return local.Current;
+		}
+
+	public:
+		static void* Allocate() noexcept
+		{
+			auto& local = GetLocal();
+			if (local.Closed)
+				return AllocateBlock(nullptr);
+			auto* owner = local.Current != nullptr ? local.Current : CreateOwner(local);
+			++owner->Outstanding;
+			if (owner->Head == nullptr)
+				owner->TakeReturned();
+			if (owner->Head != nullptr)
+			{
+				auto* block = owner->Head;
+				owner->Head = block->Next;
+				--owner->Count;
+				return block;
+			}
+			return AllocateBlock(owner);
+		}
+
+		static void Deallocate(void* mem) noexcept
+		{
+			auto* owner = GetHeader(mem)->BlockOwner;
+			if (owner == nullptr)
+			{
+				FreeBase(mem);
+				return;
+			}
+			auto* block = static_cast<FreeBlock*>(mem);
+			if (owner == GetLocal().Current)
+			{
+				--owner->Outstanding;
+				if (owner->Count >= MaxCachedBlocks)
+				{
+					FreeBase(mem);
+					return;
+				}
+				block->Next = owner->Head;
+				owner->Head = block;
+				++owner->Count;
+				return;
+			}
+
+			block->Next = owner->Returned.load(std::memory_order_relaxed);
+			while (!owner->Returned.compare_exchange_weak(block->Next, block, std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+			// Only reaches zero once the owner thread is gone and this was its last block out
+			if (owner->RemoteFreed.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				DestroyOwner(owner);
+		}
+	};
+}
+
+#endif /* CORE_POOLED_BLOCK_CACHE_H */
\ No newline at end of file
@@ -23,6 +23,22 @@ namespace greaper
 		return *this;
 	}
 
+	template<typename T>
+	INLINE sizet IStream::ReadArray(T* data, const sizet count)const
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "ReadArray can only copy trivially copyable types.");
+		const auto read = Read(data, (ssizet)(count * sizeof(T)));
+		return read > 0 ? (sizet)read / sizeof(T) : 0;
+	}
+
+	template<typename T>
+	INLINE sizet IStream::WriteArray(const T* data, const sizet count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "WriteArray can only copy trivially copyable types.");
+		const auto written = Write(data, (ssizet)(count * sizeof(T)));
+		return written > 0 ? (sizet)written / sizeof(T) : 0;
+	}
+
 	IStream::IStream(const uint16 accessMode)
 		:m_Access(accessMode)
 	{
@@ -36,6 +52,58 @@ namespace greaper
 
 	}
 
+	ssizet IStream::ReadV(const std::span<const IOVec> vecs)const
+	{
+		ssizet done = 0;
+		for (const auto& vec : vecs)
+		{
+			const auto read = Read(vec.Data, (ssizet)vec.Size);
+			if (read > 0)
+				done += read;
+			if (read < (ssizet)vec.Size)
+				break;
+		}
+		return done;
+	}
+
+	ssizet IStream::WriteV(const std::span<const IOVec> vecs)
+	{
+		ssizet done = 0;
+		for (const auto& vec : vecs)
+		{
+			const auto written = Write(vec.Data, (ssizet)vec.Size);
+			if (written > 0)
+				done += written;
+			if (written < (ssizet)vec.Size)
+				break;
+		}
+		return done;
+	}
+
+	std::span<const uint8> IStream::ReadView(const sizet count)const
+	{
+		if (m_Scratch.size() < count)
+			m_Scratch.resize(count);
+		const auto read = Read(m_Scratch.data(), (ssizet)count);
+		return { m_Scratch.data(), read > 0 ? (sizet)read : 0 };
+	}
+
+	std::span<uint8> IStream::WriteReserve(const sizet count)
+	{
+		if (!IsWritable())
+			return {};
+		if (m_Scratch.size() < count)
+			m_Scratch.resize(count);
+		return { m_Scratch.data(), count };
+	}
+
+	void IStream::WriteCommit(const sizet count)
+	{
+		VerifyLessEqual(count, m_Scratch.size(), "Trying to commit more bytes than reserved.");
+		if (count > 0)
+			Write(m_Scratch.data(), (ssizet)count);
+	}
+
 	void IStream::Align(uint32 count)
 	{
 		if (count <= 1)
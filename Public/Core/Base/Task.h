@@ -9,65 +9,68 @@
 #define CORE_TASK_H 1
 
 #include "../Memory.h"
-#include <functional>
+#include "../InplaceFunction.h"
+#include "../Cancellation.h"
+#include "TaskStatistics.h"
 
 namespace greaper
 {
+	constexpr sizet TaskFunctionCapacity = 64;
+
 	class Task
 	{
+	public:
+		using TaskFunction = InplaceFunction<void(), TaskFunctionCapacity>;
+
+	private:
 		Duration_t m_Duration;
-		std::function<void()> m_Function;
+		TaskFunction m_Function;
 		StringView m_Name;
+		CancellationToken m_Token;
 
 	public:
-		explicit Task(std::function<void()> function = nullptr, StringView name = "unnamed"sv);
+		explicit Task(TaskFunction function = nullptr, StringView name = "unnamed"sv, CancellationToken token = CancellationToken{});
 
+		/**
+		 * Runs the task, the duration is only measured while a TaskStatistics sink is set.
+		 * If its token has been cancelled the function is not called.
+		 */
 		void operator()() noexcept;
 
+		[[nodiscard]] bool IsCancelled()const noexcept { return m_Token.IsCancellationRequested(); }
+
+		const CancellationToken& GetCancellationToken()const noexcept { return m_Token; }
+
 		Duration_t GetTaskDuration()const noexcept { return m_Duration; }
 
 		const StringView& GetName()const noexcept { return m_Name; }
 	};
 
-	Task::Task(std::function<void()> function, StringView name)
-		:m_Function(std::move(function))
+	Task::Task(TaskFunction function, StringView name, CancellationToken token)
+		:m_Duration(0)
+		,m_Function(std::move(function))
 		,m_Name(std::move(name))
-		,m_Duration(0)
+		,m_Token(std::move(token))
 	{
 
 	}
 
 	void Task::operator()() noexcept
+	{
+		VerifyNotNull(m_Function, "Trying to execute a nullptr task");
+		if (IsCancelled())
+			return;
+		auto* sink = GetTaskStatisticsSink();
+		if (sink == nullptr)
 		{
-			VerifyNotNull(m_Function, "Trying to execute a nullptr task");
-			const auto before = Clock_t::now();
 			m_Function();
-			const auto after = Clock_t::now();
-			m_Duration = after - before;
-			const auto dur = static_cast<double>(m_Duration.count());
-			String msg;
-			if (dur > 1e9)
-			{
-				msg = Format("Task '%s' took %fs.", m_Name.data(), dur * 1e-9);
-			}
-			else if (dur > 1e6)
-			{
-				msg = Format("Task '%s' took %fms.", m_Name.data(), dur * 1e-6);
-			}
-			else if (dur > 1e3)
-			{
-				msg = Format("Task '%s' took %fµs.", m_Name.data(), dur * 1e-3);
-			}
-			else
-			{
-				msg = Format("Task '%s' took %fns.", m_Name.data(), dur);
-			}
-#if PLT_WINDOWS
-			OutputDebugStringA(msg.c_str());
-#else
-			printf(msg.c_str());
-#endif
+			return;
 		}
+		const auto before = Clock_t::now();
+		m_Function();
+		m_Duration = Clock_t::now() - before;
+		sink->Record(m_Name, m_Duration);
+	}
 }
 
 #endif /* CORE_TASK_H */
\ No newline at end of file
@@ -0,0 +1,137 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_TASK_GROUP_H
+#define CORE_TASK_GROUP_H 1
+
+#include "IThreadPool.h"
+
+namespace greaper
+{
+	/**
+	 * Set of tasks that can be waited for together and cancelled together.
+	 * A group created from a parent token is cancelled along with it, so nested
+	 * groups form a cancellation graph. Tasks are accounted until they are
+	 * destroyed, either after running or when dropped from the queue because the
+	 * group was cancelled, so Wait() never hangs on cancelled work.
+	 * Destroying the group waits for its tasks.
+	 */
+	class TaskGroup
+	{
+		class Ticket
+		{
+			TaskGroup* m_Group;
+
+		public:
+			explicit Ticket(TaskGroup* group) noexcept
+				:m_Group(group)
+			{
+				m_Group->m_Pending.fetch_add(1, std::memory_order_relaxed);
+			}
+			Ticket(const Ticket&) = delete;
+			Ticket& operator=(const Ticket&) = delete;
+
+			Ticket(Ticket&& other) noexcept
+				:m_Group(other.m_Group)
+			{
+				other.m_Group = nullptr;
+			}
+
+			Ticket& operator=(Ticket&&) = delete;
+
+			~Ticket()
+			{
+				if (m_Group == nullptr)
+					return;
+				// Only the address is used to wake, the group may be gone once the count reaches zero
+				auto& pending = m_Group->m_Pending;
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					WakeByAddressAll(pending);
+			}
+		};
+
+		CancellationSource m_Source;
+		std::atomic<uint32> m_Pending;
+
+	public:
+		TaskGroup()
+			:m_Pending(0)
+		{
+
+		}
+
+		explicit TaskGroup(const CancellationToken& parent)
+			:m_Source(parent)
+			,m_Pending(0)
+		{
+
+		}
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		~TaskGroup()
+		{
+			Wait();
+		}
+
+		/** Wraps the function into a Task that belongs to this group */
+		template<class F>
+		[[nodiscard]] Task CreateTask(F&& func, StringView name = "unnamed"sv)
+		{
+			return Task([ticket = Ticket(this), fn = std::forward<F>(func)]() mutable { fn(); }, name, m_Source.GetToken());
+		}
+
+		template<class F>
+		HPooledTask Run(IThreadPool& pool, F&& func, StringView name = "unnamed"sv, const TaskOptions& options = TaskOptions{})
+		{
+			return pool.RunTask(CreateTask(std::forward<F>(func), name), options);
+		}
+
+		/** Queued tasks are dropped, running ones are expected to poll the token */
+		INLINE bool Cancel()
+		{
+			return m_Source.Cancel();
+		}
+
+		[[nodiscard]] INLINE bool IsCancelled()const noexcept { return m_Source.IsCancellationRequested(); }
+
+		/** Token for the tasks to poll and for child groups to link to */
+		[[nodiscard]] INLINE CancellationToken GetToken()const noexcept { return m_Source.GetToken(); }
+
+		[[nodiscard]] INLINE uint32 GetPendingCount()const noexcept { return m_Pending.load(std::memory_order_acquire); }
+
+		INLINE void Wait() noexcept
+		{
+			auto pending = m_Pending.load(std::memory_order_acquire);
+			while (pending != 0)
+			{
+				WaitOnAddress(m_Pending, pending);
+				pending = m_Pending.load(std::memory_order_acquire);
+			}
+		}
+
+		/** Returns false if the timeout expired with tasks still pending */
+		INLINE bool WaitFor(uint32 millis) noexcept
+		{
+			const auto deadline = Clock_t::now() + std::chrono::milliseconds(millis);
+			auto pending = m_Pending.load(std::memory_order_acquire);
+			while (pending != 0)
+			{
+				const auto now = Clock_t::now();
+				if (now >= deadline)
+					return false;
+				const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+				WaitOnAddress(m_Pending, pending, static_cast<uint32>(Max<int64>(remaining, 1)));
+				pending = m_Pending.load(std::memory_order_acquire);
+			}
+			return true;
+		}
+	};
+}
+
+#endif /* CORE_TASK_GROUP_H */
\ No newline at end of file
@@ -0,0 +1,226 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_TASK_QUEUE_H
+#define CORE_TASK_QUEUE_H 1
+
+#include "Task.h"
+#include "../Enumeration.h"
+#include "../Concurrency.h"
+#include <algorithm>
+
+namespace greaper
+{
+	/**
+	 * Critical work must finish before the current frame ends, Frame work within
+	 * the frame loop, and Background work soaks up the idle cores.
+	 */
+	ENUMERATION(TaskPriority, Critical, Frame, Background);
+
+	constexpr Timepoint_t NoDeadline = Timepoint_t::max();
+
+	struct TaskOptions
+	{
+		TaskPriority_t Priority = TaskPriority_t::Frame;
+		Timepoint_t Deadline = NoDeadline; // Earliest deadline first inside its lane
+	};
+
+	struct ScheduledTask
+	{
+		Task TaskToRun;
+		Timepoint_t Deadline = NoDeadline;
+		Timepoint_t EnqueueTime;
+		uint64 Sequence = 0;
+		TaskPriority_t Priority = TaskPriority_t::Frame;
+	};
+
+	/**
+	 * Pending task storage for IThreadPool implementations, one heap per lane
+	 * ordered by deadline and then by submission order. A lane that has been
+	 * skipped StarvationLimit times in a row while having work is served next,
+	 * so background work keeps moving under a constant stream of critical tasks.
+	 */
+	class PriorityTaskQueue
+	{
+		struct EarlierFirst
+		{
+			bool operator()(const ScheduledTask& left, const ScheduledTask& right)const noexcept
+			{
+				// std heaps are max-heaps, so the comparison is inverted
+				if (left.Deadline != right.Deadline)
+					return left.Deadline > right.Deadline;
+				return left.Sequence > right.Sequence;
+			}
+		};
+
+		mutable Mutex m_Mutex;
+		Vector<ScheduledTask> m_Lanes[TaskPriority_t::COUNT];
+		uint32 m_Skipped[TaskPriority_t::COUNT] = {};
+		uint64 m_NextSequence = 0;
+		uint32 m_StarvationLimit;
+		LightweightSemaphore m_Available;
+		std::atomic<uint32> m_Size;
+		std::atomic<uint64> m_DeadlineMisses;
+		std::atomic<uint64> m_DroppedTasks;
+
+		sizet SelectLane()const noexcept
+		{
+			// Lowest priorities first, so the most starved lane wins
+			for (sizet lane = TaskPriority_t::COUNT; lane-- > 0; )
+			{
+				if (!m_Lanes[lane].empty() && m_Skipped[lane] >= m_StarvationLimit)
+					return lane;
+			}
+			for (sizet lane = 0; lane < TaskPriority_t::COUNT; ++lane)
+			{
+				if (!m_Lanes[lane].empty())
+					return lane;
+			}
+			return TaskPriority_t::COUNT;
+		}
+
+		/**
+		 * Every pushed task posts one permit, so each task taken out consumes
+		 * one too, otherwise waiters would wake up for tasks that are gone.
+		 */
+		bool PopTask(ScheduledTask& task, bool permitTaken)
+		{
+			while (true)
+			{
+				{
+					auto lck = Lock<Mutex>(m_Mutex);
+					const auto selected = SelectLane();
+					if (selected == TaskPriority_t::COUNT)
+						return false;
+
+					auto& lane = m_Lanes[selected];
+					std::pop_heap(lane.begin(), lane.end(), EarlierFirst{});
+					task = std::move(lane.back());
+					lane.pop_back();
+					m_Size.fetch_sub(1, std::memory_order_relaxed);
+
+					m_Skipped[selected] = 0;
+					for (sizet other = selected + 1; other < TaskPriority_t::COUNT; ++other)
+					{
+						if (!m_Lanes[other].empty())
+							++m_Skipped[other];
+					}
+				}
+				if (!permitTaken)
+					m_Available.try_wait();
+				permitTaken = false;
+				if (!task.TaskToRun.IsCancelled())
+					return true;
+
+				// Destroyed outside the lock, the captures may submit more work
+				task.TaskToRun = Task();
+				m_DroppedTasks.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+	public:
+		explicit PriorityTaskQueue(uint32 starvationLimit = 8) noexcept
+			:m_StarvationLimit(Max<uint32>(starvationLimit, 1))
+			,m_Available(0)
+			,m_Size(0)
+			,m_DeadlineMisses(0)
+			,m_DroppedTasks(0)
+		{
+
+		}
+		PriorityTaskQueue(const PriorityTaskQueue&) = delete;
+		PriorityTaskQueue& operator=(const PriorityTaskQueue&) = delete;
+		~PriorityTaskQueue() = default;
+
+		INLINE void Push(Task task, const TaskOptions& options = TaskOptions{})
+		{
+			VerifyLess((sizet)options.Priority, (sizet)TaskPriority_t::COUNT, "Trying to push a task with an invalid priority.");
+			{
+				auto lck = Lock<Mutex>(m_Mutex);
+				auto& lane = m_Lanes[options.Priority];
+				auto& scheduled = lane.emplace_back();
+				scheduled.TaskToRun = std::move(task);
+				scheduled.Deadline = options.Deadline;
+				scheduled.EnqueueTime = Clock_t::now();
+				scheduled.Sequence = m_NextSequence++;
+				scheduled.Priority = options.Priority;
+				std::push_heap(lane.begin(), lane.end(), EarlierFirst{});
+				// Updated under the lock, so a racing Clear can't be undone by it
+				m_Size.fetch_add(1, std::memory_order_relaxed);
+			}
+			m_Available.notify();
+		}
+
+		/** Tasks whose token was cancelled while queued are dropped here without running */
+		INLINE bool TryPop(ScheduledTask& task)
+		{
+			return PopTask(task, false);
+		}
+
+		/** Blocks until a task is available or the timeout expires, used by idle workers */
+		INLINE bool WaitAndPop(ScheduledTask& task, uint32 millis = InfiniteWait)
+		{
+			if (millis == InfiniteWait)
+				m_Available.wait();
+			else if (!m_Available.wait_for(millis))
+				return false;
+			return PopTask(task, true);
+		}
+
+		/** Wakes up to count workers blocked on WaitAndPop, ie: to shut them down */
+		INLINE void WakeWaiters(uint32 count) noexcept
+		{
+			m_Available.notify(count);
+		}
+
+		/** Must be called once the task has run, it accounts the deadline misses */
+		INLINE void Complete(const ScheduledTask& task) noexcept
+		{
+			if (task.Deadline != NoDeadline && Clock_t::now() > task.Deadline)
+				m_DeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		INLINE void Clear()
+		{
+			Vector<ScheduledTask> removed[TaskPriority_t::COUNT];
+			sizet removedCount = 0;
+			{
+				auto lck = Lock<Mutex>(m_Mutex);
+				for (sizet lane = 0; lane < TaskPriority_t::COUNT; ++lane)
+				{
+					removed[lane].swap(m_Lanes[lane]);
+					removedCount += removed[lane].size();
+				}
+				m_Size.store(0, std::memory_order_relaxed);
+			}
+			for (sizet i = 0; i < removedCount && m_Available.try_wait(); ++i)
+			{
+			}
+		}
+
+		[[nodiscard]] INLINE sizet GetSize()const noexcept { return m_Size.load(std::memory_order_relaxed); }
+
+		[[nodiscard]] INLINE sizet GetLaneSize(TaskPriority_t priority)const
+		{
+			auto lck = Lock<Mutex>(m_Mutex);
+			return m_Lanes[priority].size();
+		}
+
+		[[nodiscard]] INLINE uint64 GetDeadlineMisses()const noexcept { return m_DeadlineMisses.load(std::memory_order_relaxed); }
+
+		/** Amount of cancelled tasks that were discarded before starting */
+		[[nodiscard]] INLINE uint64 GetDroppedTasks()const noexcept { return m_DroppedTasks.load(std::memory_order_relaxed); }
+
+		INLINE void SetStarvationLimit(uint32 limit)
+		{
+			auto lck = Lock<Mutex>(m_Mutex);
+			m_StarvationLimit = Max<uint32>(limit, 1);
+		}
+	};
+}
+
+#endif /* CORE_TASK_QUEUE_H */
\ No newline at end of file
@@ -0,0 +1,157 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_TASK_STATISTICS_H
+#define CORE_TASK_STATISTICS_H 1
+
+#include "NamedStatistics.h"
+#include <bit>
+
+namespace greaper
+{
+	/**
+	 * Durations are stored in a log2 histogram, bucket i counts the tasks
+	 * that took [2^(i-1), 2^i) nanoseconds, bucket 0 the ones under 1ns.
+	 */
+	struct TaskStatisticsSnapshot
+	{
+		static constexpr uint32 BucketCount = 40;
+
+		StringView Name;
+		uint64 Count = 0;
+		uint64 TotalNanoseconds = 0;
+		uint64 MinNanoseconds = 0;
+		uint64 MaxNanoseconds = 0;
+		uint64 Buckets[BucketCount] = {};
+
+		[[nodiscard]] double GetAverageNanoseconds()const noexcept
+		{
+			return Count == 0 ? 0.0 : static_cast<double>(TotalNanoseconds) / static_cast<double>(Count);
+		}
+
+		/** Returns the upper bound of the bucket where the percentile [0, 1] falls */
+		[[nodiscard]] uint64 GetPercentileNanoseconds(double percentile)const noexcept
+		{
+			if (Count == 0)
+				return 0;
+			const auto target = static_cast<uint64>(Clamp(percentile, 0.0, 1.0) * static_cast<double>(Count - 1)) + 1;
+			uint64 accumulated = 0;
+			for (uint32 i = 0; i < BucketCount; ++i)
+			{
+				accumulated += Buckets[i];
+				if (accumulated >= target)
+					return Min(uint64(1) << i, MaxNanoseconds);
+			}
+			return MaxNanoseconds;
+		}
+	};
+
+	/**
+	 * Lock-free per task name duration statistics in a NamedStatisticsTable.
+	 * Names are stored as views, so like in Task they must outlive the sink,
+	 * string literals are expected.
+	 */
+	class TaskStatistics
+	{
+	public:
+		static constexpr uint32 MaxTaskNames = 256;
+		static constexpr uint32 BucketCount = TaskStatisticsSnapshot::BucketCount;
+
+	private:
+		struct Entry : Impl::NamedStatisticsEntry<StringView>
+		{
+			std::atomic<uint64> Count{ 0 };
+			std::atomic<uint64> TotalNanoseconds{ 0 };
+			std::atomic<uint64> MinNanoseconds{ UINT64_MAX };
+			std::atomic<uint64> MaxNanoseconds{ 0 };
+			std::atomic<uint64> Buckets[BucketCount] = {};
+
+			void Record(uint64 nanos) noexcept
+			{
+				Count.fetch_add(1, std::memory_order_relaxed);
+				TotalNanoseconds.fetch_add(nanos, std::memory_order_relaxed);
+				Buckets[Min<uint32>(static_cast<uint32>(std::bit_width(nanos)), BucketCount - 1)].fetch_add(1, std::memory_order_relaxed);
+				auto cur = MinNanoseconds.load(std::memory_order_relaxed);
+				while (nanos < cur && !MinNanoseconds.compare_exchange_weak(cur, nanos, std::memory_order_relaxed));
+				cur = MaxNanoseconds.load(std::memory_order_relaxed);
+				while (nanos > cur && !MaxNanoseconds.compare_exchange_weak(cur, nanos, std::memory_order_relaxed));
+			}
+
+			void Snapshot(TaskStatisticsSnapshot& snapshot)const noexcept
+			{
+				snapshot.Name = Name;
+				snapshot.Count = Count.load(std::memory_order_relaxed);
+				snapshot.TotalNanoseconds = TotalNanoseconds.load(std::memory_order_relaxed);
+				const auto minNanos = MinNanoseconds.load(std::memory_order_relaxed);
+				snapshot.MinNanoseconds = minNanos == UINT64_MAX ? 0 : minNanos;
+				snapshot.MaxNanoseconds = MaxNanoseconds.load(std::memory_order_relaxed);
+				for (uint32 i = 0; i < BucketCount; ++i)
+					snapshot.Buckets[i] = Buckets[i].load(std::memory_order_relaxed);
+			}
+
+			void Reset() noexcept
+			{
+				Count.store(0, std::memory_order_relaxed);
+				TotalNanoseconds.store(0, std::memory_order_relaxed);
+				MinNanoseconds.store(UINT64_MAX, std::memory_order_relaxed);
+				MaxNanoseconds.store(0, std::memory_order_relaxed);
+				for (auto& bucket : Buckets)
+					bucket.store(0, std::memory_order_relaxed);
+			}
+		};
+
+		Impl::NamedStatisticsTable<Entry, MaxTaskNames> m_Table;
+
+	public:
+		TaskStatistics() = default;
+		TaskStatistics(const TaskStatistics&) = delete;
+		TaskStatistics& operator=(const TaskStatistics&) = delete;
+		~TaskStatistics() = default;
+
+		INLINE void Record(const StringView& name, Duration_t duration) noexcept
+		{
+			const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+			m_Table.FindOrCreate(name).Record(nanos < 0 ? 0 : static_cast<uint64>(nanos));
+		}
+
+		/** Returns false if no task with that name has been recorded */
+		INLINE bool GetStatistics(const StringView& name, TaskStatisticsSnapshot& snapshot)const noexcept
+		{
+			return m_Table.GetSnapshot(name, snapshot);
+		}
+
+		[[nodiscard]] INLINE Vector<TaskStatisticsSnapshot> GetAllStatistics()const
+		{
+			return m_Table.GetAllSnapshots<TaskStatisticsSnapshot>();
+		}
+
+		/** Clears the counters, the known names are kept */
+		INLINE void Reset() noexcept
+		{
+			m_Table.Reset();
+		}
+
+		static TaskStatistics& GetDefault() noexcept
+		{
+			static TaskStatistics statistics;
+			return statistics;
+		}
+	};
+
+	/** Tasks are only timed while a sink is set, nullptr disables the timing */
+	INLINE void SetTaskStatisticsSink(TaskStatistics* sink) noexcept
+	{
+		Impl::GetStatisticsSinkRef<TaskStatistics>().store(sink, std::memory_order_release);
+	}
+
+	[[nodiscard]] INLINE TaskStatistics* GetTaskStatisticsSink() noexcept
+	{
+		return Impl::GetStatisticsSinkRef<TaskStatistics>().load(std::memory_order_acquire);
+	}
+}
+
+#endif /* CORE_TASK_STATISTICS_H */
\ No newline at end of file
@@ -0,0 +1,191 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_THREAD_BUFFER_REGISTRY_H
+#define CORE_THREAD_BUFFER_REGISTRY_H 1
+
+#include "../Concurrency.h"
+#include <algorithm>
+
+namespace greaper::Impl
+{
+	/**
+	 * Base of the buffers a thread fills for one registry owner, ie: an EventBus,
+	 * so it can post without locks. Shared between the owner and the thread, the
+	 * last one to let it go frees it with TBuffer::Delete.
+	 */
+	template<class TBuffer>
+	struct SharedThreadBuffer
+	{
+		static constexpr uint32 RegistryOwned = 1;
+		static constexpr uint32 ThreadOwned = 2;
+
+		TBuffer* Next = nullptr;
+		std::atomic<uint32> Owners{ RegistryOwned | ThreadOwned };
+
+		/** Returns true if it was the last owner */
+		INLINE bool Release(uint32 owner) noexcept
+		{
+			return (Owners.fetch_and(~owner, std::memory_order_acq_rel) & ~owner) == 0;
+		}
+
+		static INLINE void ReleaseAndDelete(TBuffer* buffer, uint32 owner) noexcept
+		{
+			if (buffer->Release(owner))
+				TBuffer::Delete(buffer);
+		}
+	};
+
+	/** Per thread list of the buffers it owns of each registry, released when the thread exits */
+	template<class TBuffer>
+	struct ThreadBufferEntries
+	{
+		struct Entry
+		{
+			uint64 RegistryID;
+			TBuffer* Buffer;
+		};
+
+		Vector<Entry> Entries;
+		Entry Last{ 0, nullptr };
+
+		~ThreadBufferEntries()
+		{
+			for (const auto& entry : Entries)
+				TBuffer::ReleaseAndDelete(entry.Buffer, TBuffer::ThreadOwned);
+		}
+
+		INLINE TBuffer* Find(uint64 registryID) noexcept
+		{
+			if (Last.RegistryID == registryID)
+				return Last.Buffer;
+			for (const auto& entry : Entries)
+			{
+				if (entry.RegistryID == registryID)
+				{
+					Last = entry;
+					return entry.Buffer;
+				}
+			}
+			return nullptr;
+		}
+
+		INLINE void Add(uint64 registryID, TBuffer* buffer)
+		{
+			Entries.push_back({ registryID, buffer });
+			Last = { registryID, buffer };
+		}
+
+		/** Deletes the buffers of the registries that were destroyed */
+		INLINE void Prune() noexcept
+		{
+			Entries.erase(std::remove_if(Entries.begin(), Entries.end(), [](const Entry& entry)
+				{
+					if (entry.Buffer->Owners.load(std::memory_order_acquire) != TBuffer::ThreadOwned)
+						return false;
+					TBuffer::ReleaseAndDelete(entry.Buffer, TBuffer::ThreadOwned);
+					return true;
+				}), Entries.end());
+			Last = Entry{ 0, nullptr };
+		}
+	};
+
+	template<class TBuffer>
+	INLINE ThreadBufferEntries<TBuffer>& GetThreadBufferEntries() noexcept
+	{
+		static thread_local ThreadBufferEntries<TBuffer> entries;
+		return entries;
+	}
+
+	INLINE uint64 GenerateThreadBufferRegistryID() noexcept
+	{
+		static std::atomic<uint64> lastID{ 0 };
+		return lastID.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+	/**
+	 * Owner side of the per thread buffers, a push-only lock-free list of every
+	 * buffer handed to a thread, which the owner walks to drain them. A thread
+	 * asking for its buffer adopts one left by a finished thread before
+	 * allocating a new one. The owner lets go of all of them on ReleaseAll,
+	 * the ones still held by a live thread are deleted when it exits or asks
+	 * for a buffer of a registry it has none of.
+	 */
+	template<class TBuffer>
+	class ThreadBufferRegistry
+	{
+		std::atomic<TBuffer*> m_Head;
+		uint64 m_RegistryID;
+
+	public:
+		ThreadBufferRegistry() noexcept
+			:m_Head(nullptr)
+			,m_RegistryID(GenerateThreadBufferRegistryID())
+		{
+
+		}
+		ThreadBufferRegistry(const ThreadBufferRegistry&) = delete;
+		ThreadBufferRegistry& operator=(const ThreadBufferRegistry&) = delete;
+
+		~ThreadBufferRegistry()
+		{
+			ReleaseAll([](TBuffer*) {});
+		}
+
+		/** Buffer of the calling thread, args construct it if a new one is needed */
+		template<class... Args>
+		TBuffer* GetThreadBuffer(Args&&... args)
+		{
+			auto& entries = GetThreadBufferEntries<TBuffer>();
+			auto* buffer = entries.Find(m_RegistryID);
+			if (buffer != nullptr)
+				return buffer;
+			entries.Prune();
+
+			for (auto* it = m_Head.load(std::memory_order_acquire); it != nullptr; it = it->Next)
+			{
+				auto owners = TBuffer::RegistryOwned;
+				if (it->Owners.compare_exchange_strong(owners, TBuffer::RegistryOwned | TBuffer::ThreadOwned, std::memory_order_acquire))
+				{
+					buffer = it;
+					break;
+				}
+			}
+			if (buffer == nullptr)
+			{
+				void* mem = MemoryAllocator<GenericAllocator>::AllocateAligned(sizeof(TBuffer), alignof(TBuffer));
+				buffer = new(mem)TBuffer(std::forward<Args>(args)...);
+				auto* head = m_Head.load(std::memory_order_relaxed);
+				do
+				{
+					buffer->Next = head;
+				} while (!m_Head.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+			}
+			entries.Add(m_RegistryID, buffer);
+			return buffer;
+		}
+
+		/** First of the buffers, the rest follow through Next */
+		[[nodiscard]] INLINE TBuffer* GetFirst()const noexcept { return m_Head.load(std::memory_order_acquire); }
+
+		/** No thread may be using the buffers, beforeRelease frees what the owner put in each one */
+		template<class Func>
+		INLINE void ReleaseAll(Func&& beforeRelease) noexcept
+		{
+			auto* buffer = m_Head.exchange(nullptr, std::memory_order_acquire);
+			while (buffer != nullptr)
+			{
+				auto* next = buffer->Next;
+				beforeRelease(buffer);
+				TBuffer::ReleaseAndDelete(buffer, TBuffer::RegistryOwned);
+				buffer = next;
+			}
+		}
+	};
+}
+
+#endif /* CORE_THREAD_BUFFER_REGISTRY_H */
\ No newline at end of file
@@ -212,6 +212,19 @@ INLINE bool IsMemoryCleared(const T& data) noexcept
 	static const uint8 zeros[sizeof(T)]  = {};
 	return ::memcmp(&data, &zeros, sizeof(T)) == 0;
 }
+/** Loads a T from memory that may not be aligned for it */
+template<class T>
+INLINE T ReadUnaligned(const void* src) noexcept
+{
+	T value;
+	memcpy(&value, src, sizeof(T));
+	return value;
+}
+template<class T>
+INLINE void WriteUnaligned(void* dst, const T& value) noexcept
+{
+	memcpy(dst, &value, sizeof(T));
+}
 
 /***********************************************************************************
 *                              MACRO HELPER FUNCITONS                              *
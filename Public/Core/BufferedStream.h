@@ -0,0 +1,116 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_BUFFERED_STREAM_H
+#define CORE_BUFFERED_STREAM_H 1
+
+#include "Stream.h"
+
+namespace greaper
+{
+	struct BufferedStreamConfig
+	{
+		sizet BufferSize = 64 * 1024; // 0 passes every transfer straight to the inner stream
+		/**
+		 * Refills read a whole buffer ahead of the caller. Turn it off for inner
+		 * streams whose reads wait until every requested byte arrives, like
+		 * pipes, then only writes are buffered.
+		 */
+		bool ReadAhead = true;
+	};
+
+	/**
+	 * Adds a user-space buffer to any stream, so the many small transfers of a
+	 * serializer reach the inner stream as a few big ones, FileStream is one
+	 * over an OSFileStream. The buffer is shared by reads and writes, switching
+	 * direction flushes it, transfers of at least the buffer size go straight
+	 * to the inner stream, and Seek and Skip inside the buffer never touch it.
+	 * The inner stream is only asked to seek when the next transfer doesn't
+	 * start where it is, so forward-only streams can be wrapped as long as the
+	 * wrapper only moves forward too. When the pending writes can't be flushed
+	 * they are kept, and the transfer that needed the room fails.
+	 */
+	class BufferedStream : public IStream
+	{
+	protected:
+		SPtr<IStream> m_Inner;
+		BufferedStreamConfig m_Config;
+		uint8* m_Buffer;
+		sizet m_BufferCapacity;
+		mutable int64 m_BufferOffset; // Inner stream offset of m_Buffer[0]
+		mutable sizet m_BufferPos;
+		mutable sizet m_BufferFill;
+		mutable int64 m_InnerOffset; // Where the inner stream cursor is
+		mutable bool m_Dirty;
+		bool m_ReservedInPlace; // The last WriteReserve pointed into m_Buffer
+
+		bool MoveInnerOffset(int64 offset)const;
+
+		/** Writes the pending data and empties the buffer at the current position, keeps it if the write fails */
+		bool FlushBuffer()const;
+
+		ssizet ReadFromInner(void* buffer, sizet count)const;
+
+	public:
+		explicit BufferedStream(SPtr<IStream> inner, const BufferedStreamConfig& config = BufferedStreamConfig{});
+
+		BufferedStream(const BufferedStream&) = delete;
+		BufferedStream& operator=(const BufferedStream&) = delete;
+
+		~BufferedStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** Small transfers go through the buffer, the rest goes to the inner ReadV */
+		ssizet ReadV(std::span<const IOVec> vecs)const override;
+
+		/** Small transfers are gathered in the buffer, the rest goes to the inner WriteV */
+		ssizet WriteV(std::span<const IOVec> vecs) override;
+
+		/** Points into the buffer, refilling it first if needed, unless count doesn't fit in it */
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Points into the buffer, flushing it first if needed, unless count doesn't fit in it */
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
+		void Skip(ssizet count) override;
+
+		/**
+		 * Stays in the buffer when pos is inside it and nothing is pending, flushes
+		 * otherwise, so a WriteReserve never overlaps pending writes. Leaves the
+		 * cursor where it was if they can't be flushed.
+		 */
+		void Seek(ssizet pos) override;
+
+		ssizet Tell()const override { return (ssizet)(m_BufferOffset + (int64)m_BufferPos); }
+
+		bool Eof()const override;
+
+		/** Buffers a clone of the inner stream at the same position, nullptr if it can't be cloned or the pending writes fail */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		/** Flushes and lets go of the inner stream without closing it, call Flush first to know whether the pending writes made it */
+		void Close() override;
+
+		/** Hands the buffered writes to the inner stream */
+		bool Flush();
+
+		[[nodiscard]] INLINE const SPtr<IStream>& GetInner()const noexcept { return m_Inner; }
+
+		[[nodiscard]] INLINE const BufferedStreamConfig& GetConfig()const noexcept { return m_Config; }
+	};
+}
+
+#include "Base/BufferedStream.inl"
+
+#endif /* CORE_BUFFERED_STREAM_H */
\ No newline at end of file
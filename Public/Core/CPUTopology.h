@@ -0,0 +1,82 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CPU_TOPOLOGY_H
+#define CORE_CPU_TOPOLOGY_H 1
+
+#include "CorePrerequisites.h"
+
+#if PLT_WINDOWS
+#include "Win/WinCPUInfo.h"
+#else
+#include "Lnx/LnxCPUInfo.h"
+#endif
+
+namespace greaper
+{
+	/** Queried once, the topology of a running machine does not change */
+	INLINE const CPUTopology& GetCPUTopology()
+	{
+		static const CPUTopology topology = OSCPUInfo::QueryTopology();
+		return topology;
+	}
+
+	INLINE bool SetCurrentThreadAffinity(const CPUSet& set)
+	{
+		if (set.IsEmpty())
+			return false;
+		return OSCPUInfo::SetCurrentThreadAffinity(set);
+	}
+
+	INLINE bool SetCurrentThreadPriority(ThreadPriority_t priority, ThreadSchedulingPolicy_t policy = ThreadSchedulingPolicy_t::Default)
+	{
+		return OSCPUInfo::SetCurrentThreadPriority(priority, policy);
+	}
+
+	[[nodiscard]] INLINE uint32 GetCurrentProcessor()
+	{
+		return OSCPUInfo::GetCurrentProcessor();
+	}
+
+	/** Returns the logical processors of the given NUMA node, or an empty set if it does not exist */
+	[[nodiscard]] INLINE CPUSet GetNUMANodeProcessors(uint32 numaNode)
+	{
+		for (const auto& node : GetCPUTopology().NUMANodes)
+		{
+			if (node.ID == numaNode)
+				return node.LogicalProcessors;
+		}
+		return CPUSet{};
+	}
+
+	/**
+	 * Computes one affinity per worker, each being the SMT siblings of a different physical core,
+	 * so workers do not share execution units. Once every core has a worker they wrap around.
+	 * A negative numaNode uses the cores of every node.
+	 */
+	[[nodiscard]] INLINE Vector<CPUSet> ComputePhysicalCoreAffinities(uint32 workerCount, int32 numaNode = -1)
+	{
+		const auto& topology = GetCPUTopology();
+		Vector<const CPUCoreInfo*> cores;
+		cores.reserve(topology.Cores.size());
+		for (const auto& core : topology.Cores)
+		{
+			if (numaNode < 0 || core.NUMANode == (uint32)numaNode)
+				cores.push_back(&core);
+		}
+
+		Vector<CPUSet> affinities;
+		if (cores.empty())
+			return affinities;
+		affinities.reserve(workerCount);
+		for (uint32 i = 0; i < workerCount; ++i)
+			affinities.push_back(cores[i % cores.size()]->LogicalProcessors);
+		return affinities;
+	}
+}
+
+#endif /* CORE_CPU_TOPOLOGY_H */
\ No newline at end of file
@@ -0,0 +1,389 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CANCELLATION_H
+#define CORE_CANCELLATION_H 1
+
+#include "Concurrency.h"
+#include "InplaceFunction.h"
+
+namespace greaper
+{
+	/**
+	 * @brief Cooperative cancellation
+	 *
+	 * A CancellationSource requests the cancellation, and the CancellationTokens
+	 * obtained from it let the work check it with a single relaxed load. Sources
+	 * can be linked to a parent token, so cancelling a parent propagates to every
+	 * child in the graph. Callbacks can be registered to react to cancellation,
+	 * they run on the thread that calls Cancel(), or immediately if the token was
+	 * already cancelled.
+	 */
+	namespace Impl
+	{
+		class CancellationState
+		{
+		public:
+			using Callback = InplaceFunction<void()>;
+
+		private:
+			struct CallbackEntry
+			{
+				Callback Function;
+				uint32 ID = 0;
+			};
+
+			std::atomic<uint32> m_Cancelled{ 0 };
+			std::atomic<uint32> m_RefCount{ 1 };
+			std::atomic<uint32> m_ExecutingID{ 0 };
+			SpinLock m_Lock;
+			Vector<CallbackEntry> m_Callbacks;
+			uint32 m_NextID = 1;
+
+			/** State whose callbacks are being run by the calling thread */
+			static const CancellationState*& ExecutingOnThisThread() noexcept
+			{
+				static thread_local const CancellationState* executing = nullptr;
+				return executing;
+			}
+
+		public:
+			static CancellationState* Create()
+			{
+				return new(AllocT<CancellationState>())CancellationState();
+			}
+
+			INLINE void AddRef() noexcept
+			{
+				m_RefCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			INLINE void RemoveRef() noexcept
+			{
+				if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					Destroy<CancellationState>(this);
+			}
+
+			[[nodiscard]] INLINE bool IsCancelled()const noexcept
+			{
+				return m_Cancelled.load(std::memory_order_acquire) != 0;
+			}
+
+			/** Returns 0 if the callback was executed right away because it was already cancelled */
+			INLINE uint32 Register(Callback callback)
+			{
+				{
+					auto lck = Lock<SpinLock>(m_Lock);
+					if (!IsCancelled())
+					{
+						const auto id = m_NextID++;
+						m_Callbacks.push_back(CallbackEntry{ std::move(callback), id });
+						return id;
+					}
+				}
+				callback();
+				return 0;
+			}
+
+			INLINE void Unregister(uint32 id)
+			{
+				if (id == 0)
+					return;
+				{
+					auto lck = Lock<SpinLock>(m_Lock);
+					for (auto it = m_Callbacks.begin(); it != m_Callbacks.end(); ++it)
+					{
+						if (it->ID == id)
+						{
+							m_Callbacks.erase(it);
+							return;
+						}
+					}
+				}
+				// Running right now, wait for it unless it is unregistering itself
+				if (ExecutingOnThisThread() == this)
+					return;
+				while (m_ExecutingID.load(std::memory_order_acquire) == id)
+					THREAD_YIELD();
+			}
+
+			/** Returns false if it was already cancelled */
+			INLINE bool Cancel()
+			{
+				if (m_Cancelled.exchange(1, std::memory_order_acq_rel) != 0)
+					return false;
+
+				WakeByAddressAll(m_Cancelled);
+				auto& executing = ExecutingOnThisThread();
+				const auto* previous = executing;
+				executing = this;
+				while (true)
+				{
+					CallbackEntry entry;
+					{
+						auto lck = Lock<SpinLock>(m_Lock);
+						if (m_Callbacks.empty())
+							break;
+						entry = std::move(m_Callbacks.back());
+						m_Callbacks.pop_back();
+						m_ExecutingID.store(entry.ID, std::memory_order_release);
+					}
+					entry.Function();
+					m_ExecutingID.store(0, std::memory_order_release);
+				}
+				executing = previous;
+				return true;
+			}
+
+			/** Parks until cancelled or the timeout expires, returns true if cancelled */
+			INLINE bool WaitFor(uint32 millis) noexcept
+			{
+				if (IsCancelled())
+					return true;
+				if (millis == InfiniteWait)
+				{
+					while (!IsCancelled())
+						WaitOnAddress(m_Cancelled, 0);
+					return true;
+				}
+				const auto deadline = Clock_t::now() + std::chrono::milliseconds(millis);
+				while (!IsCancelled())
+				{
+					const auto now = Clock_t::now();
+					if (now >= deadline)
+						return false;
+					const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+					WaitOnAddress(m_Cancelled, 0, static_cast<uint32>(Max<int64>(remaining, 1)));
+				}
+				return true;
+			}
+		};
+	}
+
+	class CancellationToken;
+
+	/** Unregisters its callback when destroyed, after it the callback won't be running */
+	class CancellationRegistration
+	{
+		Impl::CancellationState* m_State = nullptr;
+		uint32 m_ID = 0;
+
+		CancellationRegistration(Impl::CancellationState* state, uint32 id) noexcept
+			:m_State(state)
+			,m_ID(id)
+		{
+
+		}
+
+		friend class CancellationToken;
+
+	public:
+		CancellationRegistration() noexcept = default;
+		CancellationRegistration(const CancellationRegistration&) = delete;
+		CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+
+		CancellationRegistration(CancellationRegistration&& other) noexcept
+			:m_State(other.m_State)
+			,m_ID(other.m_ID)
+		{
+			other.m_State = nullptr;
+			other.m_ID = 0;
+		}
+
+		CancellationRegistration& operator=(CancellationRegistration&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Unregister();
+				m_State = other.m_State;
+				m_ID = other.m_ID;
+				other.m_State = nullptr;
+				other.m_ID = 0;
+			}
+			return *this;
+		}
+
+		~CancellationRegistration()
+		{
+			Unregister();
+		}
+
+		INLINE void Unregister()
+		{
+			if (m_State == nullptr)
+				return;
+			m_State->Unregister(m_ID);
+			m_State->RemoveRef();
+			m_State = nullptr;
+			m_ID = 0;
+		}
+	};
+
+	/** Cheap to copy view of a CancellationSource, a default constructed token is never cancelled */
+	class CancellationToken
+	{
+		Impl::CancellationState* m_State = nullptr;
+
+		explicit CancellationToken(Impl::CancellationState* state) noexcept
+			:m_State(state)
+		{
+			if (m_State != nullptr)
+				m_State->AddRef();
+		}
+
+		friend class CancellationSource;
+
+	public:
+		CancellationToken() noexcept = default;
+
+		CancellationToken(const CancellationToken& other) noexcept
+			:CancellationToken(other.m_State)
+		{
+
+		}
+
+		CancellationToken(CancellationToken&& other) noexcept
+			:m_State(other.m_State)
+		{
+			other.m_State = nullptr;
+		}
+
+		CancellationToken& operator=(const CancellationToken& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (other.m_State != nullptr)
+					other.m_State->AddRef();
+				if (m_State != nullptr)
+					m_State->RemoveRef();
+				m_State = other.m_State;
+			}
+			return *this;
+		}
+
+		CancellationToken& operator=(CancellationToken&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_State != nullptr)
+					m_State->RemoveRef();
+				m_State = other.m_State;
+				other.m_State = nullptr;
+			}
+			return *this;
+		}
+
+		~CancellationToken()
+		{
+			if (m_State != nullptr)
+				m_State->RemoveRef();
+		}
+
+		[[nodiscard]] INLINE bool IsCancellationRequested()const noexcept
+		{
+			return m_State != nullptr && m_State->IsCancelled();
+		}
+
+		[[nodiscard]] INLINE bool CanBeCancelled()const noexcept { return m_State != nullptr; }
+
+		/** The callback runs immediately if the token is already cancelled */
+		[[nodiscard]] INLINE CancellationRegistration Register(Impl::CancellationState::Callback callback)const
+		{
+			if (m_State == nullptr)
+				return CancellationRegistration{};
+			const auto id = m_State->Register(std::move(callback));
+			if (id == 0)
+				return CancellationRegistration{};
+			m_State->AddRef();
+			return CancellationRegistration(m_State, id);
+		}
+
+		/** Blocks until cancelled or the timeout expires, returns true if cancelled */
+		INLINE bool WaitForCancellation(uint32 millis = InfiniteWait)const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to wait on a CancellationToken that can't be cancelled.");
+			return m_State->WaitFor(millis);
+		}
+
+		friend bool operator==(const CancellationToken& left, const CancellationToken& right) noexcept { return left.m_State == right.m_State; }
+		friend bool operator!=(const CancellationToken& left, const CancellationToken& right) noexcept { return left.m_State != right.m_State; }
+	};
+
+	class CancellationSource
+	{
+		Impl::CancellationState* m_State;
+		CancellationRegistration m_ParentLink;
+
+	public:
+		CancellationSource()
+			:m_State(Impl::CancellationState::Create())
+		{
+
+		}
+
+		/** Creates a source that is cancelled as well when the parent token is */
+		explicit CancellationSource(const CancellationToken& parent)
+			:CancellationSource()
+		{
+			if (!parent.CanBeCancelled())
+				return;
+			auto* state = m_State;
+			m_ParentLink = parent.Register([state]() { state->Cancel(); });
+		}
+
+		CancellationSource(const CancellationSource&) = delete;
+		CancellationSource& operator=(const CancellationSource&) = delete;
+
+		CancellationSource(CancellationSource&& other) noexcept
+			:m_State(other.m_State)
+			,m_ParentLink(std::move(other.m_ParentLink))
+		{
+			other.m_State = nullptr;
+		}
+
+		CancellationSource& operator=(CancellationSource&& other) noexcept
+		{
+			if (this != &other)
+			{
+				m_ParentLink.Unregister();
+				if (m_State != nullptr)
+					m_State->RemoveRef();
+				m_State = other.m_State;
+				m_ParentLink = std::move(other.m_ParentLink);
+				other.m_State = nullptr;
+			}
+			return *this;
+		}
+
+		~CancellationSource()
+		{
+			// The link must go first, the parent callback uses the state
+			m_ParentLink.Unregister();
+			if (m_State != nullptr)
+				m_State->RemoveRef();
+		}
+
+		/** Returns false if it was already cancelled */
+		INLINE bool Cancel()
+		{
+			VerifyNotNull(m_State, "Trying to use a moved CancellationSource.");
+			return m_State->Cancel();
+		}
+
+		[[nodiscard]] INLINE bool IsCancellationRequested()const noexcept
+		{
+			return m_State != nullptr && m_State->IsCancelled();
+		}
+
+		[[nodiscard]] INLINE CancellationToken GetToken()const noexcept
+		{
+			return CancellationToken(m_State);
+		}
+	};
+}
+
+#endif /* CORE_CANCELLATION_H */
\ No newline at end of file
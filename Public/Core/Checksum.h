@@ -0,0 +1,122 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CHECKSUM_H
+#define CORE_CHECKSUM_H 1
+
+#include "Memory.h"
+#include "Enumeration.h"
+#include "Base/CPUInfo.h"
+#include <array>
+#include <span>
+
+namespace greaper
+{
+	ENUMERATION(ChecksumAlgorithm, CRC32C, XXH3);
+
+	/**
+	 * Running CRC32C (Castagnoli), the one stored by iSCSI, ext4 and most storage
+	 * formats. Uses the SSE4.2 crc32 instruction on three interleaved lanes merged
+	 * with PCLMUL when the CPU has them, slicing by 8 tables otherwise.
+	 */
+	class Crc32C
+	{
+		uint32 m_State = 0xFFFFFFFF;
+
+	public:
+		static constexpr sizet DigestSize = sizeof(uint32);
+
+		void Update(const void* data, sizet size) noexcept;
+
+		INLINE void Update(std::span<const uint8> data) noexcept { Update(data.data(), data.size()); }
+
+		[[nodiscard]] INLINE uint32 GetValue()const noexcept { return ~m_State; }
+
+		INLINE void Reset() noexcept { m_State = 0xFFFFFFFF; }
+
+		[[nodiscard]] static uint32 Compute(std::span<const uint8> data) noexcept;
+	};
+
+	/**
+	 * Running 64 bit XXH3 with the default secret and seed, gives the same values
+	 * as XXH3_64bits. Stripes are accumulated with AVX2 when the CPU has it.
+	 */
+	class XXH3Hash
+	{
+		static constexpr sizet BufferSize = 256;
+
+		alignas(32) uint64 m_Acc[8];
+		alignas(32) uint8 m_Buffer[BufferSize];
+		sizet m_BufferedSize;
+		sizet m_StripesSoFar; // Stripes of the current block already accumulated
+		uint64 m_TotalSize;
+
+	public:
+		static constexpr sizet DigestSize = sizeof(uint64);
+
+		XXH3Hash() noexcept;
+
+		void Update(const void* data, sizet size) noexcept;
+
+		INLINE void Update(std::span<const uint8> data) noexcept { Update(data.data(), data.size()); }
+
+		[[nodiscard]] uint64 GetValue()const noexcept;
+
+		void Reset() noexcept;
+
+		[[nodiscard]] static uint64 Compute(std::span<const uint8> data) noexcept;
+	};
+
+	/** Any of the checksums picked at runtime, values are widened to 64 bits */
+	class RunningChecksum
+	{
+		ChecksumAlgorithm_t m_Algorithm;
+		Crc32C m_Crc32C;
+		XXH3Hash m_XXH3;
+
+	public:
+		explicit RunningChecksum(ChecksumAlgorithm_t algorithm = ChecksumAlgorithm_t::XXH3) noexcept
+			:m_Algorithm(algorithm)
+		{
+
+		}
+
+		[[nodiscard]] INLINE ChecksumAlgorithm_t GetAlgorithm()const noexcept { return m_Algorithm; }
+
+		INLINE void Update(std::span<const uint8> data) noexcept
+		{
+			if (m_Algorithm == ChecksumAlgorithm_t::CRC32C)
+				m_Crc32C.Update(data);
+			else
+				m_XXH3.Update(data);
+		}
+
+		[[nodiscard]] INLINE uint64 GetValue()const noexcept
+		{
+			return m_Algorithm == ChecksumAlgorithm_t::CRC32C ? (uint64)m_Crc32C.GetValue() : m_XXH3.GetValue();
+		}
+
+		INLINE void Reset() noexcept
+		{
+			m_Crc32C.Reset();
+			m_XXH3.Reset();
+		}
+
+		/** Bytes the value takes when stored, little endian */
+		[[nodiscard]] static constexpr sizet GetDigestSize(ChecksumAlgorithm_t algorithm) noexcept
+		{
+			return algorithm == ChecksumAlgorithm_t::CRC32C ? Crc32C::DigestSize : XXH3Hash::DigestSize;
+		}
+	};
+
+	/** Checksum of a whole buffer in one go, CRC32C values are widened to 64 bits */
+	[[nodiscard]] uint64 Checksum(std::span<const uint8> data, ChecksumAlgorithm_t algorithm = ChecksumAlgorithm_t::XXH3) noexcept;
+}
+
+#include "Base/Checksum.inl"
+
+#endif /* CORE_CHECKSUM_H */
\ No newline at end of file
@@ -0,0 +1,105 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CHECKSUM_STREAM_H
+#define CORE_CHECKSUM_STREAM_H 1
+
+#include "Stream.h"
+#include "Checksum.h"
+
+namespace greaper
+{
+	ENUMERATION(ChecksumTrailer, None, Append, Check);
+
+	struct ChecksumStreamConfig
+	{
+		ChecksumAlgorithm_t Algorithm = ChecksumAlgorithm_t::XXH3;
+		/**
+		 * Append stores the value little endian after the data when closing,
+		 * Check keeps those bytes out of the data, so the inner stream must know
+		 * its size, and checks them on VerifyTrailer.
+		 */
+		ChecksumTrailer_t Trailer = ChecksumTrailer_t::None;
+	};
+
+	/**
+	 * Forwards everything to another stream while keeping a running checksum of
+	 * the bytes that go through, in the order they go through. Views and
+	 * reservations are the inner stream ones, so wrapping costs no copies. The
+	 * cursor only moves forward, skipping reads through the bytes there are and
+	 * writes zeros past them on writable streams.
+	 */
+	class ChecksumStream : public IStream
+	{
+	protected:
+		SPtr<IStream> m_Inner;
+		ChecksumStreamConfig m_Config;
+		mutable RunningChecksum m_Checksum;
+		mutable ssizet m_Position;
+		std::span<uint8> m_Reserved;
+
+		/** Bytes that can still be read before the trailer */
+		sizet GetReadable(sizet count)const;
+
+		void Hash(std::span<const uint8> data)const;
+
+		void HashVecs(std::span<const IOVec> vecs, sizet size)const;
+
+	public:
+		explicit ChecksumStream(SPtr<IStream> inner, const ChecksumStreamConfig& config = ChecksumStreamConfig{});
+
+		ChecksumStream(const ChecksumStream&) = delete;
+		ChecksumStream& operator=(const ChecksumStream&) = delete;
+
+		~ChecksumStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		ssizet ReadV(std::span<const IOVec> vecs)const override;
+
+		ssizet WriteV(std::span<const IOVec> vecs) override;
+
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
+		void Skip(ssizet count) override;
+
+		/** Only forward, same as skipping to pos */
+		void Seek(ssizet pos) override;
+
+		/** Bytes that went through since the stream was wrapped */
+		ssizet Tell()const override { return m_Position; }
+
+		bool Eof()const override;
+
+		/** The running checksum can't be shared, returns nullptr */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		/** Appends the trailer if configured and lets go of the inner stream without closing it */
+		void Close() override;
+
+		/** Checksum of the bytes that went through so far */
+		[[nodiscard]] INLINE uint64 GetValue()const noexcept { return m_Checksum.GetValue(); }
+
+		/**
+		 * Reads through whatever is left of the data and compares the checksum
+		 * with the trailer that follows it, only for the Check trailer.
+		 */
+		[[nodiscard]] bool VerifyTrailer();
+	};
+}
+
+#include "Base/ChecksumStream.inl"
+
+#endif /* CORE_CHECKSUM_STREAM_H */
\ No newline at end of file
@@ -0,0 +1,149 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_CHUNKED_MEMORY_STREAM_H
+#define CORE_CHUNKED_MEMORY_STREAM_H 1
+
+#include "Stream.h"
+#include "Concurrency.h"
+#include "Base/IOVec.h"
+
+namespace greaper
+{
+	/** Thread safe cache of equally sized memory chunks shared by ChunkedMemoryStreams */
+	class MemoryChunkPool
+	{
+		sizet m_ChunkSize;
+		uint32 m_MaxCachedChunks;
+		Vector<uint8*> m_FreeChunks;
+		SpinLock m_Lock;
+
+	public:
+		explicit MemoryChunkPool(sizet chunkSize = 64 * 1024, uint32 maxCachedChunks = 256)
+			:m_ChunkSize(chunkSize)
+			,m_MaxCachedChunks(maxCachedChunks)
+		{
+			VerifyGreater(m_ChunkSize, (sizet)0, "A MemoryChunkPool needs a chunk size.");
+		}
+
+		MemoryChunkPool(const MemoryChunkPool&) = delete;
+		MemoryChunkPool& operator=(const MemoryChunkPool&) = delete;
+
+		~MemoryChunkPool()
+		{
+			for (auto* chunk : m_FreeChunks)
+				Dealloc(chunk);
+		}
+
+		[[nodiscard]] uint8* Acquire()
+		{
+			{
+				auto lck = Lock<SpinLock>(m_Lock);
+				if (!m_FreeChunks.empty())
+				{
+					auto* chunk = m_FreeChunks.back();
+					m_FreeChunks.pop_back();
+					return chunk;
+				}
+			}
+			return (uint8*)Alloc(m_ChunkSize);
+		}
+
+		void Release(uint8* chunk)
+		{
+			{
+				auto lck = Lock<SpinLock>(m_Lock);
+				if (m_FreeChunks.size() < m_MaxCachedChunks)
+				{
+					m_FreeChunks.push_back(chunk);
+					return;
+				}
+			}
+			Dealloc(chunk);
+		}
+
+		[[nodiscard]] INLINE sizet GetChunkSize()const noexcept { return m_ChunkSize; }
+	};
+
+	/**
+	 * Memory stream stored as a list of fixed size chunks, growing it never moves
+	 * the written data nor needs a big contiguous allocation. Seek and Tell work
+	 * across chunks so written data can be patched, and GetSegments exports the
+	 * contents for a vectored write.
+	 */
+	class ChunkedMemoryStream : public IStream
+	{
+	protected:
+		MemoryChunkPool* m_Pool;
+		sizet m_ChunkSize;
+		Vector<uint8*> m_Chunks;
+		mutable ssizet m_Position;
+		bool m_ReservedInPlace; // The last WriteReserve pointed into a chunk
+
+		uint8* AcquireChunk();
+
+		void ReleaseChunks();
+
+	public:
+		static constexpr sizet DefaultChunkSize = 64 * 1024;
+
+		/** Chunks are allocated and freed by the stream */
+		explicit ChunkedMemoryStream(sizet chunkSize = DefaultChunkSize);
+
+		/** Chunks are drawn from pool, which must outlive the stream */
+		explicit ChunkedMemoryStream(MemoryChunkPool& pool);
+
+		ChunkedMemoryStream(const ChunkedMemoryStream&) = delete;
+		ChunkedMemoryStream& operator=(const ChunkedMemoryStream&) = delete;
+		ChunkedMemoryStream(ChunkedMemoryStream&& other) noexcept;
+		ChunkedMemoryStream& operator=(ChunkedMemoryStream&& other) noexcept;
+
+		~ChunkedMemoryStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** Points into the chunk unless the bytes cross into the next one */
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Points into the chunk unless the bytes cross into the next one */
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
+		void Skip(ssizet count) override;
+
+		void Seek(ssizet pos) override;
+
+		ssizet Tell()const override { return m_Position; }
+
+		bool Eof()const override { return m_Position >= m_Size; }
+
+		/** The chunks can't be shared, so the data is always copied */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		[[nodiscard]] INLINE sizet GetChunkSize()const noexcept { return m_ChunkSize; }
+
+		[[nodiscard]] INLINE sizet GetChunkCount()const noexcept { return m_Chunks.size(); }
+
+		/**
+		 * Returns one IOVec per chunk holding data, in order. They stay valid until
+		 * the stream is closed, and on Linux can go to writev through ToOSIOVec,
+		 * which takes at most IOV_MAX of them per call.
+		 */
+		[[nodiscard]] Vector<IOVec> GetSegments()const;
+	};
+}
+
+#include "Base/ChunkedMemoryStream.inl"
+
+#endif /* CORE_CHUNKED_MEMORY_STREAM_H */
\ No newline at end of file
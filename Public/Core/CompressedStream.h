@@ -0,0 +1,220 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_COMPRESSED_STREAM_H
+#define CORE_COMPRESSED_STREAM_H 1
+
+#include "Stream.h"
+#include "LZCodec.h"
+#include "Base/TaskGroup.h"
+
+namespace greaper
+{
+	struct CompressedStreamConfig
+	{
+		uint32 BlockSize = 256 * 1024; // Writer only, uncompressed bytes per block, between 1KiB and 64MiB
+		CompressionLevel_t Level = CompressionLevel_t::Fast; // Writer only
+		IThreadPool* Pool = nullptr; // Reader only, decompresses blocks in parallel when given
+		uint32 ParallelBlocks = 8; // Reader only, blocks read ahead and decompressed together when there's a pool
+	};
+
+	namespace Impl
+	{
+		static constexpr uint32 CompressedStreamMagic = 0x315A4C47; // "GLZ1"
+		static constexpr uint32 CompressedStreamMinBlockSize = 1024;
+		static constexpr uint32 CompressedStreamMaxBlockSize = 64 * 1024 * 1024;
+		static constexpr uint32 CompressedBlockStored = 0x80000000; // Set on PackedSize when the block didn't compress
+
+		struct CompressedStreamHeader
+		{
+			uint32 Magic;
+			uint32 BlockSize;
+		};
+
+		/** Precedes every block, a RawSize of 0 ends the stream */
+		struct CompressedBlockHeader
+		{
+			uint32 RawSize;
+			uint32 PackedSize;
+		};
+
+		/** Both headers are stored as their two fields in little endian, whatever the host is */
+		static constexpr sizet CompressedHeaderSize = 2 * sizeof(uint32);
+
+		INLINE void StoreCompressedHeader(uint8(&bytes)[CompressedHeaderSize], const uint32 first, const uint32 second) noexcept
+		{
+			for (sizet i = 0; i < sizeof(uint32); ++i)
+			{
+				bytes[i] = (uint8)(first >> (i * 8));
+				bytes[sizeof(uint32) + i] = (uint8)(second >> (i * 8));
+			}
+		}
+
+		INLINE void LoadCompressedHeader(const uint8(&bytes)[CompressedHeaderSize], uint32& first, uint32& second) noexcept
+		{
+			first = 0;
+			second = 0;
+			for (sizet i = 0; i < sizeof(uint32); ++i)
+			{
+				first |= (uint32)bytes[i] << (i * 8);
+				second |= (uint32)bytes[sizeof(uint32) + i] << (i * 8);
+			}
+		}
+	}
+
+	/**
+	 * Compresses everything written into independent blocks and writes them to
+	 * another stream, each with a small header, so a reader can decompress
+	 * them in any order. Blocks that don't shrink are stored as they are.
+	 * Only moves forward, skipping writes zeros. Closing writes the last block
+	 * and the end mark and lets go of the inner stream without closing it.
+	 * Once a block can't be written the stream fails, nothing else is taken
+	 * and the end mark is left out so readers see the data as cut.
+	 */
+	class CompressedWriterStream : public IStream
+	{
+	protected:
+		SPtr<IStream> m_Inner;
+		CompressedStreamConfig m_Config;
+		LZCompressor m_Compressor;
+		Vector<uint8> m_Block;
+		Vector<uint8> m_Packed;
+		sizet m_Fill;
+		bool m_ReservedInPlace;
+		bool m_Failed; // A block didn't reach the inner stream
+
+		bool WriteBlock(const uint8* data, sizet size);
+
+		bool FlushBlock();
+
+	public:
+		explicit CompressedWriterStream(SPtr<IStream> inner, const CompressedStreamConfig& config = CompressedStreamConfig{});
+
+		CompressedWriterStream(const CompressedWriterStream&) = delete;
+		CompressedWriterStream& operator=(const CompressedWriterStream&) = delete;
+
+		~CompressedWriterStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** Room inside the current block, no copy is needed */
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
+		void Skip(ssizet count) override;
+
+		/** Only forward, same as skipping to pos */
+		void Seek(ssizet pos) override;
+
+		/** Uncompressed bytes written so far */
+		ssizet Tell()const override { return m_Size; }
+
+		bool Eof()const override { return m_Inner == nullptr; }
+
+		/** The pending block can't be shared, returns nullptr */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		/** Compresses and writes the pending bytes as a shorter block */
+		bool Flush();
+
+		[[nodiscard]] INLINE bool HasFailed()const noexcept { return m_Failed; }
+	};
+
+	/**
+	 * Reads what a CompressedWriterStream wrote. With a pool, ParallelBlocks
+	 * blocks are read at once and decompressed on the pool while this thread
+	 * takes one of them, otherwise blocks are decompressed straight from a view
+	 * of the inner stream. ReadView points into the decompressed block when
+	 * the bytes don't cross a block. The total size isn't stored, so Size stays
+	 * at zero. Malformed data ends the stream early and sets IsCorrupted.
+	 */
+	class CompressedReaderStream : public IStream
+	{
+	protected:
+		struct Block
+		{
+			Vector<uint8> Packed;
+			Vector<uint8> Data;
+			sizet Size = 0;
+			sizet PackedSize = 0;
+			bool Stored = false;
+			bool Valid = false;
+		};
+
+		SPtr<IStream> m_Inner;
+		CompressedStreamConfig m_Config;
+		uint32 m_BlockSize;
+		mutable Vector<Block> m_Blocks;
+		mutable sizet m_BlockCount; // Blocks loaded by the last batch
+		mutable sizet m_Current;
+		mutable sizet m_Offset; // Bytes of the current block already consumed
+		mutable ssizet m_Position;
+		mutable Impl::CompressedBlockHeader m_NextHeader; // Read ahead to find the end mark
+		mutable bool m_Ended;
+		mutable bool m_HasNextHeader;
+		mutable bool m_Corrupted;
+
+		/** Reads the next block header, false at the end of the stream */
+		bool ReadBlockHeader(Impl::CompressedBlockHeader& header)const;
+
+		static void DecompressBlock(Block& block);
+
+		/** Makes the current block the next one with data, false at the end of the stream */
+		bool NextBlock()const;
+
+		bool LoadBatch()const;
+
+		sizet Consume(uint8* dst, sizet count)const;
+
+	public:
+		explicit CompressedReaderStream(SPtr<IStream> inner, const CompressedStreamConfig& config = CompressedStreamConfig{});
+
+		CompressedReaderStream(const CompressedReaderStream&) = delete;
+		CompressedReaderStream& operator=(const CompressedReaderStream&) = delete;
+
+		~CompressedReaderStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Decompresses and drops the next count bytes */
+		void Skip(ssizet count) override;
+
+		/** Only forward, same as skipping to pos */
+		void Seek(ssizet pos) override;
+
+		/** Uncompressed bytes consumed so far */
+		ssizet Tell()const override { return m_Position; }
+
+		bool Eof()const override;
+
+		/** The decompressed blocks can't be shared, returns nullptr */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		/** Lets go of the inner stream without closing it */
+		void Close() override;
+
+		/** True if a header or a block couldn't be decoded */
+		[[nodiscard]] INLINE bool IsCorrupted()const noexcept { return m_Corrupted; }
+	};
+}
+
+#include "Base/CompressedStream.inl"
+
+#endif /* CORE_COMPRESSED_STREAM_H */
\ No newline at end of file
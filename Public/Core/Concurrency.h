@@ -18,7 +18,6 @@
 #include <atomic>
 #include <mutex>
 #include <functional>
-#include <any>
 
 namespace greaper
 {
@@ -265,6 +264,32 @@ namespace greaper
 		}
 	};
 
+	static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32), "WaitOnAddress requires std::atomic<uint32> to be lock-free and unpadded.");
+
+	constexpr uint32 InfiniteWait = static_cast<uint32>(-1);
+
+	/**
+	 * Parks the calling thread while the value at address equals undesiredValue.
+	 * Can wake up spuriously, callers must re-check their condition.
+	 * Returns false if it timed out.
+	 */
+	INLINE bool WaitOnAddress(std::atomic<uint32>& address, uint32 undesiredValue, uint32 millis = InfiniteWait) noexcept
+	{
+		return Impl::WaitOnAddressImpl::Wait(reinterpret_cast<volatile uint32*>(&address), undesiredValue, millis);
+	}
+
+	/** Wakes up one thread parked on address */
+	INLINE void WakeByAddressSingle(std::atomic<uint32>& address) noexcept
+	{
+		Impl::WaitOnAddressImpl::WakeOne(reinterpret_cast<volatile uint32*>(&address));
+	}
+
+	/** Wakes up all threads parked on address */
+	INLINE void WakeByAddressAll(std::atomic<uint32>& address) noexcept
+	{
+		Impl::WaitOnAddressImpl::WakeAll(reinterpret_cast<volatile uint32*>(&address));
+	}
+
 	struct AdoptLock { explicit AdoptLock() = default; };
 
 	template<class Mtx>
@@ -592,192 +617,260 @@ namespace greaper
 		[[nodiscard]] INLINE Mutex& GetMutex() { return m_Mutex; }
 	};
 
-	// from: https://stackoverflow.com/a/27118537
-	class Barrier
+	/**
+	 * Semaphore that only touches the OS when a thread has to sleep,
+	 * acquiring and releasing an available permit costs a single atomic.
+	 */
+	class LightweightSemaphore
 	{
-		Mutex m_Mutex;
-		Signal m_Signal;
-		const sizet m_MaxCount;
-		sizet m_Count;
-		sizet m_Generation;
+		static constexpr uint32 SpinCount = 1000;
+		std::atomic<uint32> m_Count;
+		std::atomic<uint32> m_Waiters;
 
 	public:
-		Barrier(sizet maxCount = 0)
-			:m_MaxCount(maxCount)
-			,m_Count(maxCount)
-			,m_Generation(0)
+		LightweightSemaphore(uint32 initialCount = 0) noexcept
+			:m_Count(initialCount)
+			,m_Waiters(0)
 		{
 
 		}
+		LightweightSemaphore(const LightweightSemaphore&) = delete;
+		LightweightSemaphore& operator=(const LightweightSemaphore&) = delete;
+		~LightweightSemaphore() = default;
 
-		void sync()
+		INLINE bool try_wait() noexcept
 		{
-			UniqueLock<Mutex> lck(m_Mutex);
-			const auto gen = m_Generation;
-			if(!--m_Count)
-			{
-				++m_Generation;
-				m_Count = m_MaxCount;
-				m_Signal.notify_all();
-			}
-			else
+			auto count = m_Count.load(std::memory_order_relaxed);
+			while (count > 0)
 			{
-				m_Signal.wait(lck, [this, gen] { return gen != m_Generation; });
+				if (m_Count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+					return true;
 			}
+			return false;
 		}
 
-		[[nodiscard]] INLINE sizet GetMaxCount()const { return m_MaxCount; }
-
-		[[nodiscard]] INLINE const Signal& GetSignal()const { return m_Signal; }
-		[[nodiscard]] INLINE Signal& GetSignal() { return m_Signal; }
-		[[nodiscard]] INLINE const Mutex& GetMutex()const { return m_Mutex; }
-		[[nodiscard]] INLINE Mutex& GetMutex() { return m_Mutex; }
-	};
-
-	struct AsyncOpSyncData
-	{
-		Mutex Mtx;
-		Signal Condition;
-	};
-
-	struct AsyncOpEmpty {  };
-
-	class IAsyncOp
-	{
-		struct OpData
+		INLINE void wait() noexcept
 		{
-			std::any RetValue;
-			std::atomic_bool IsComplete = false;
-		};
-
-	protected:
-		SPtr<OpData> m_Data;
-		SPtr<AsyncOpSyncData> m_SyncData;
+			for (uint32 i = 0; i < SpinCount; ++i)
+			{
+				if (try_wait())
+					return;
+				CPU_PAUSE();
+			}
 
-		void CompleteCheck()const
-		{
-			Verify(HasCompleted(), "Trying to get AsyncOp return value but the operation hasn't completed yet.");
+			m_Waiters.fetch_add(1, std::memory_order_seq_cst);
+			while (!try_wait())
+				WaitOnAddress(m_Count, 0);
+			m_Waiters.fetch_sub(1, std::memory_order_relaxed);
 		}
 
-	public:
-		IAsyncOp()
-			:m_Data(std::make_shared<OpData>())
+		INLINE bool wait_for(uint32 millis) noexcept
 		{
+			if (try_wait())
+				return true;
 
+			const auto deadline = Clock_t::now() + std::chrono::milliseconds(millis);
+			m_Waiters.fetch_add(1, std::memory_order_seq_cst);
+			bool acquired = try_wait();
+			while (!acquired)
+			{
+				const auto now = Clock_t::now();
+				if (now >= deadline)
+					break;
+				const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+				WaitOnAddress(m_Count, 0, static_cast<uint32>(Max<int64>(remaining, 1)));
+				acquired = try_wait();
+			}
+			m_Waiters.fetch_sub(1, std::memory_order_relaxed);
+			return acquired;
 		}
 
-		IAsyncOp(AsyncOpEmpty empty)
+		INLINE void notify(uint32 count = 1) noexcept
 		{
-			UNUSED(empty);
+			m_Count.fetch_add(count, std::memory_order_seq_cst);
+			if (m_Waiters.load(std::memory_order_seq_cst) == 0)
+				return;
+			if (count == 1)
+				WakeByAddressSingle(m_Count);
+			else
+				WakeByAddressAll(m_Count);
 		}
 
-		IAsyncOp(const SPtr<AsyncOpSyncData>& syncData)
-			:m_Data(std::make_shared<OpData>())
-			,m_SyncData(syncData)
+		[[nodiscard]] INLINE uint32 GetCount()const noexcept { return m_Count.load(std::memory_order_relaxed); }
+	};
+
+	/**
+	 * Single use countdown, threads calling wait() are released once the count
+	 * reaches zero.
+	 */
+	class Latch
+	{
+		std::atomic<uint32> m_Count;
+
+	public:
+		explicit Latch(uint32 count) noexcept
+			:m_Count(count)
 		{
 
 		}
+		Latch(const Latch&) = delete;
+		Latch& operator=(const Latch&) = delete;
+		~Latch() = default;
 
-		IAsyncOp(AsyncOpEmpty empty, const SPtr<AsyncOpSyncData>& syncData)
-			:m_SyncData(syncData)
+		INLINE void count_down(uint32 update = 1) noexcept
 		{
-			UNUSED(empty);
+			const auto prev = m_Count.fetch_sub(update, std::memory_order_acq_rel);
+			VerifyGreaterEqual(prev, update, "Trying to count down a Latch more times than its count.");
+			if (prev == update)
+				WakeByAddressAll(m_Count);
 		}
 
-		bool HasCompleted()const
+		[[nodiscard]] INLINE bool try_wait()const noexcept
 		{
-			return m_Data->IsComplete.load(std::memory_order_acquire);
+			return m_Count.load(std::memory_order_acquire) == 0;
 		}
 
-		void BlockUntilComplete()const
+		INLINE void wait() noexcept
 		{
-			if(m_SyncData == nullptr)
+			auto count = m_Count.load(std::memory_order_acquire);
+			while (count != 0)
 			{
-				// "No sync data is available, AsyncOp must be complete to be able to block."
-				return;
+				WaitOnAddress(m_Count, count);
+				count = m_Count.load(std::memory_order_acquire);
 			}
-			UniqueLock<Mutex> lock(m_SyncData->Mtx);
-			while(!HasCompleted())
-				m_SyncData->Condition.wait(lock);
 		}
 
-		template<typename T>
-		T GetReturnValue()const
+		INLINE void arrive_and_wait(uint32 update = 1) noexcept
 		{
-			return std::any_cast<T>(GetGenericReturnValue());
-		}
-
-		std::any GetGenericReturnValue()const
-		{
-			CompleteCheck();
-
-			return m_Data->RetValue;
+			count_down(update);
+			wait();
 		}
 	};
 
-	template<class RetType>
-	class TAsyncOp : public IAsyncOp
+	/**
+	 * Event that stays signaled until Reset() is called, while set wait() returns
+	 * immediately. Set() only calls into the OS if there is a thread waiting.
+	 */
+	class ManualResetEvent
 	{
-		template<class RetType2>
-		friend bool operator==(const TAsyncOp<RetType2>&, std::nullptr_t);
-	public:
-		using ReturnType = RetType;
-
-		TAsyncOp() = default;
+		enum State : uint32
+		{
+			StateUnset = 0,
+			StateSet = 1,
+			StateWaiting = 2
+		};
+		std::atomic<uint32> m_State;
 
-		TAsyncOp(AsyncOpEmpty empty)
-			:AsyncOpBase(empty)
+	public:
+		explicit ManualResetEvent(bool initialState = false) noexcept
+			:m_State(initialState ? StateSet : StateUnset)
 		{
 
 		}
+		ManualResetEvent(const ManualResetEvent&) = delete;
+		ManualResetEvent& operator=(const ManualResetEvent&) = delete;
+		~ManualResetEvent() = default;
 
-		TAsyncOp(const SPtr<AsyncOpSyncData>& syncData)
-			:AsyncOpBase(syncData)
+		INLINE void set() noexcept
 		{
-
+			if (m_State.exchange(StateSet, std::memory_order_acq_rel) == StateWaiting)
+				WakeByAddressAll(m_State);
 		}
 
-		TAsyncOp(AsyncOpEmpty empty, const SPtr<AsyncOpSyncData>& syncData)
-			:AsyncOpBase(empty, syncData)
+		INLINE void reset() noexcept
 		{
-
+			uint32 expected = StateSet;
+			m_State.compare_exchange_strong(expected, StateUnset, std::memory_order_relaxed);
 		}
 
-		RetType GetReturnValue()const
+		[[nodiscard]] INLINE bool is_set()const noexcept
 		{
-			this->CompleteCheck();
-
-			return any_cast<RetType>(m_Data->RetValue);
+			return m_State.load(std::memory_order_acquire) == StateSet;
 		}
 
-		void _CompleteOperation()
+		INLINE void wait() noexcept
 		{
-			m_Data->IsCompleted.store(true, std::memory_order_release);
-
-			if (m_SyncData != nullptr)
-				m_SyncData->Condition.notify_all();
+			auto state = m_State.load(std::memory_order_acquire);
+			while (state != StateSet)
+			{
+				if (state == StateUnset && !m_State.compare_exchange_weak(state, StateWaiting, std::memory_order_acquire))
+					continue;
+				WaitOnAddress(m_State, StateWaiting);
+				state = m_State.load(std::memory_order_acquire);
+			}
 		}
 
-		void _CompleteOperation(const RetType& retVal)
+		INLINE bool wait_for(uint32 millis) noexcept
 		{
-			m_Data->RetValue = retVal;
-			_CompleteOperation();
+			const auto deadline = Clock_t::now() + std::chrono::milliseconds(millis);
+			auto state = m_State.load(std::memory_order_acquire);
+			while (state != StateSet)
+			{
+				if (state == StateUnset && !m_State.compare_exchange_weak(state, StateWaiting, std::memory_order_acquire))
+					continue;
+				const auto now = Clock_t::now();
+				if (now >= deadline)
+					return false;
+				const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+				WaitOnAddress(m_State, StateWaiting, static_cast<uint32>(Max<int64>(remaining, 1)));
+				state = m_State.load(std::memory_order_acquire);
+			}
+			return true;
 		}
 	};
 
-	template<class RetType>
-	bool operator==(const TAsyncOp<RetType>& left, std::nullptr_t right)
+	/**
+	 * Reusable barrier, threads arriving before the last one spin for a while
+	 * and then park on the generation counter until the barrier flips.
+	 */
+	class Barrier
 	{
-		return left.m_Data == nullptr;
-	}
+		static constexpr uint32 SpinCount = 4000;
+		const uint32 m_MaxCount;
+		std::atomic<uint32> m_Count;
+		std::atomic<uint32> m_Generation;
+		std::atomic<uint32> m_Sleepers;
 
-	template<class RetType>
-	bool operator!=(const TAsyncOp<RetType>& left, std::nullptr_t right)
-	{
-		return !(left == nullptr);
-	}
+	public:
+		Barrier(uint32 maxCount = 0)
+			:m_MaxCount(maxCount)
+			,m_Count(maxCount)
+			,m_Generation(0)
+			,m_Sleepers(0)
+		{
+
+		}
+		Barrier(const Barrier&) = delete;
+		Barrier& operator=(const Barrier&) = delete;
+		~Barrier() = default;
 
-	using AsyncOp = TAsyncOp<std::any>;
+		void sync() noexcept
+		{
+			const auto gen = m_Generation.load(std::memory_order_acquire);
+			if (m_Count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				m_Count.store(m_MaxCount, std::memory_order_relaxed);
+				m_Generation.fetch_add(1, std::memory_order_seq_cst);
+				if (m_Sleepers.load(std::memory_order_seq_cst) > 0)
+					WakeByAddressAll(m_Generation);
+				return;
+			}
+
+			for (uint32 i = 0; i < SpinCount; ++i)
+			{
+				if (m_Generation.load(std::memory_order_acquire) != gen)
+					return;
+				CPU_PAUSE();
+			}
+
+			m_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+			while (m_Generation.load(std::memory_order_acquire) == gen)
+				WaitOnAddress(m_Generation, gen);
+			m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] INLINE uint32 GetMaxCount()const noexcept { return m_MaxCount; }
+	};
 }
 
 #endif /* CORE_CONCURRENCY_H */
\ No newline at end of file
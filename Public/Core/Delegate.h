@@ -0,0 +1,123 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_DELEGATE_H
+#define CORE_DELEGATE_H 1
+
+#include "Memory.h"
+#include <new>
+#include <type_traits>
+
+namespace greaper
+{
+	template<class Signature>
+	class Delegate;
+
+	/**
+	 * Non-owning callable of three pointers that never allocates. It binds a
+	 * member function to an object, a free function, or a small trivially
+	 * copyable callable such as a lambda capturing a couple of pointers, which
+	 * is stored inline. Delegates are trivially copyable, so arrays of them are
+	 * relocated with a memcpy and a call is a single indirect jump.
+	 * The bound object must outlive the delegate.
+	 */
+	template<class R, class... Args>
+	class Delegate<R(Args...)>
+	{
+		static constexpr sizet StorageSize = 2 * sizeof(void*);
+
+		using Stub = R(*)(const void* storage, Args&&... args);
+
+		alignas(void*) uint8 m_Storage[StorageSize] = {};
+		Stub m_Stub = nullptr;
+
+		template<class F>
+		static R InvokeCallable(const void* storage, Args&&... args)
+		{
+			return (*static_cast<const F*>(storage))(std::forward<Args>(args)...);
+		}
+
+		template<class T, auto Method>
+		static R InvokeMethod(const void* storage, Args&&... args)
+		{
+			auto* object = *static_cast<T* const*>(storage);
+			return (object->*Method)(std::forward<Args>(args)...);
+		}
+
+		template<auto Function>
+		static R InvokeFunction(const void*, Args&&... args)
+		{
+			return Function(std::forward<Args>(args)...);
+		}
+
+	public:
+		/** Whether the callable can be bound inline, otherwise wrap it into a std::function */
+		template<class F>
+		static constexpr bool CanStoreInline = sizeof(F) <= StorageSize
+			&& alignof(F) <= alignof(void*)
+			&& std::is_trivially_copyable_v<F>
+			&& std::is_trivially_destructible_v<F>
+			&& std::is_invocable_r_v<R, const F&, Args...>;
+
+		Delegate() noexcept = default;
+
+		Delegate(std::nullptr_t) noexcept
+		{
+
+		}
+
+		template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, const std::decay_t<F>&, Args...>>>
+		Delegate(F&& func) noexcept
+		{
+			using Func = std::decay_t<F>;
+			static_assert(CanStoreInline<Func>, "The callable can't be stored in a Delegate, it must be trivially copyable and fit in two pointers.");
+			if constexpr (std::is_pointer_v<Func>)
+			{
+				if (func == nullptr)
+					return;
+			}
+			new(m_Storage)Func(std::forward<F>(func));
+			m_Stub = &InvokeCallable<Func>;
+		}
+
+		/** Binds Method to object, ie: Delegate<void(int)>::FromMethod<&Foo::OnValue>(this) */
+		template<auto Method, class T>
+		[[nodiscard]] static Delegate FromMethod(T* object) noexcept
+		{
+			Delegate delegate;
+			new(delegate.m_Storage)T*(object);
+			delegate.m_Stub = &InvokeMethod<T, Method>;
+			return delegate;
+		}
+
+		template<auto Function>
+		[[nodiscard]] static Delegate FromFunction() noexcept
+		{
+			Delegate delegate;
+			delegate.m_Stub = &InvokeFunction<Function>;
+			return delegate;
+		}
+
+		INLINE void Reset() noexcept
+		{
+			m_Stub = nullptr;
+		}
+
+		INLINE R operator()(Args... args)const
+		{
+			VerifyNotNull(m_Stub, "Trying to call an empty Delegate.");
+			return m_Stub(m_Storage, std::forward<Args>(args)...);
+		}
+
+		[[nodiscard]] INLINE explicit operator bool()const noexcept { return m_Stub != nullptr; }
+
+		friend bool operator==(const Delegate& left, std::nullptr_t) noexcept { return left.m_Stub == nullptr; }
+		friend bool operator!=(const Delegate& left, std::nullptr_t) noexcept { return left.m_Stub != nullptr; }
+	};
+}
+
+#endif /* CORE_DELEGATE_H */
\ No newline at end of file
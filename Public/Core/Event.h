@@ -10,6 +10,10 @@
 
 #include "Memory.h"
 #include "Concurrency.h"
+#include "Reclamation.h"
+#include "Delegate.h"
+#include "Base/PooledBlockCache.h"
+#include "Base/EventStatistics.h"
 #include <functional>
 
 namespace greaper
@@ -17,50 +21,188 @@ namespace greaper
 	template<class... Args>
 	class Event;
 
+	template<class... Args>
+	struct EventHandlerID;
+
+	namespace Impl
+	{
+		// Rounded to cache lines like the future states, so slots of different signatures share pools
+		template<class Slot>
+		using EventSlotPool = PooledBlockCache<(sizeof(Slot) + 63) & ~sizet(63), Max<sizet>(alignof(Slot), 64)>;
+	}
+
 	template<class... Args>
 	class EventHandler
 	{
 		Event<Args...>* m_Event = nullptr;
-		uint32 m_ID = 0;
+		EventHandlerID<Args...>* m_Slot = nullptr;
+		StringView m_Name;
 		
 	public:
+		/** The name identifies the handler in the EventStatistics, like task names it must outlive the sink */
+		EventHandler(StringView name = "unnamed"sv) noexcept
+			:m_Name(name)
+		{
+
+		}
 		~EventHandler();
 
+		const StringView& GetName()const noexcept { return m_Name; }
+
 		void Disconnect();
 
 		friend class Event<Args...>;
 	};
 
+	/** Connected handler, shared by every snapshot that lists it, Function is only set for std::function handlers */
 	template<class... Args>
 	struct EventHandlerID
 	{
 		using HandlerFunction = std::function<void(Args...)>;
+		using DelegateType = Delegate<void(Args...)>;
 		HandlerFunction Function;
-		uint32 ID;
+		StringView Name;
+		std::atomic<uint32> RefCount{ 1 };
+		std::atomic<bool> Connected{ true };
+
+		/** Slots come from a per-thread pool, so connecting doesn't reach the allocator once it is warm */
+		static INLINE EventHandlerID* Create()
+		{
+			return new(Impl::EventSlotPool<EventHandlerID>::Allocate())EventHandlerID();
+		}
+
+		INLINE void AddRef() noexcept { RefCount.fetch_add(1, std::memory_order_relaxed); }
+
+		INLINE void RemoveRef() noexcept
+		{
+			if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->~EventHandlerID();
+				Impl::EventSlotPool<EventHandlerID>::Deallocate(this);
+			}
+		}
 	};
 
 	template<>
 	struct EventHandlerID<void>
 	{
 		using HandlerFunction = std::function<void()>;
+		using DelegateType = Delegate<void()>;
 		HandlerFunction Function;
-		uint32 ID;
+		StringView Name;
+		std::atomic<uint32> RefCount{ 1 };
+		std::atomic<bool> Connected{ true };
+
+		static INLINE EventHandlerID* Create()
+		{
+			return new(Impl::EventSlotPool<EventHandlerID>::Allocate())EventHandlerID();
+		}
+
+		INLINE void AddRef() noexcept { RefCount.fetch_add(1, std::memory_order_relaxed); }
+
+		INLINE void RemoveRef() noexcept
+		{
+			if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->~EventHandlerID();
+				Impl::EventSlotPool<EventHandlerID>::Deallocate(this);
+			}
+		}
+	};
+
+	/**
+	 * Immutable view of the handler list, readers take a reference inside an
+	 * epoch critical region and run the handlers outside of it. Connect appends
+	 * into the spare capacity, publishing the new count with a release store,
+	 * so only growing or compacting creates a new snapshot. Entries keep the
+	 * delegate inline, so a trigger walks a contiguous array of 32 byte entries.
+	 */
+	template<class... Args>
+	struct EventSnapshot
+	{
+		using Slot = EventHandlerID<Args...>;
+
+		struct Entry
+		{
+			typename Slot::DelegateType Function;
+			Slot* Handler;
+		};
+
+		Entry* Entries = nullptr;
+		std::atomic<uint32> Count{ 0 };
+		uint32 Capacity = 0;
+		std::atomic<uint32> RefCount{ 1 };
+
+		static EventSnapshot* Create(uint32 capacity)
+		{
+			auto* snapshot = new(AllocT<EventSnapshot>())EventSnapshot();
+			snapshot->Entries = AllocN<Entry>(capacity);
+			snapshot->Capacity = capacity;
+			return snapshot;
+		}
+
+		~EventSnapshot()
+		{
+			const auto count = Count.load(std::memory_order_relaxed);
+			for (uint32 i = 0; i < count; ++i)
+				Entries[i].Handler->RemoveRef();
+			Dealloc(Entries);
+		}
+
+		INLINE void AddRef() noexcept { RefCount.fetch_add(1, std::memory_order_relaxed); }
+
+		INLINE void RemoveRef() noexcept
+		{
+			if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Destroy<EventSnapshot>(this);
+		}
+
+		static void ReleaseRetired(void* ptr) noexcept
+		{
+			static_cast<EventSnapshot*>(ptr)->RemoveRef();
+		}
 	};
 
+	/**
+	 * Trigger takes no lock, so it can run concurrently from any thread and
+	 * handlers may connect or disconnect from within a trigger. Connect and
+	 * Disconnect are serialized between themselves and are O(1) amortized,
+	 * disconnected handlers are skipped and compacted away once they are half
+	 * of the snapshot. A trigger that started before a Disconnect may still
+	 * call that handler.
+	 */
 	template<class... Args>
 	class Event
 	{
+		using Slot = EventHandlerID<Args...>;
+		using Snapshot = EventSnapshot<Args...>;
+		using Entry = typename Snapshot::Entry;
+
+		static constexpr uint32 MinCapacity = 4;
+
 		Mutex m_Mutex;
-		Vector<EventHandlerID<Args...>> m_Handlers;
+		std::atomic<Snapshot*> m_Snapshot;
+		uint32 m_Disconnected;
 		String m_Name;
-		uint32 m_LastID;
+
+		/**
+		 * Must be called with m_Mutex locked, returns the previous snapshot, which
+		 * must be retired once the lock is released, reclaiming it may run handler
+		 * destructors that disconnect.
+		 */
+		Snapshot* Publish(uint32 capacity) noexcept;
+
+		static void RetireSnapshot(Snapshot* snapshot) noexcept;
+
+		void Insert(EventHandler<Args...>& handler, Slot* slot, const typename Slot::DelegateType& function) noexcept;
 
 	public:
 		using HandlerType = EventHandler<Args...>;
 		using HandlerFunction = typename EventHandlerID<Args...>::HandlerFunction;
+		using DelegateType = typename EventHandlerID<Args...>::DelegateType;
 		
 		Event(const StringView& eventName = "unnamed"sv) noexcept;
-		~Event() = default;
+		~Event();
 		Event(const Event&) = delete;
 		Event& operator=(const Event&) = delete;
 
@@ -68,6 +210,20 @@ namespace greaper
 
 		void Connect(HandlerType& handler, HandlerFunction function) noexcept;
 
+		/** No std::function, the delegate is stored inline in the handler array and the slot is pooled */
+		void Connect(HandlerType& handler, DelegateType function) noexcept;
+
+		/** Callables that fit in a Delegate are bound inline, the rest go through std::function */
+		template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, HandlerFunction> && !std::is_same_v<std::decay_t<F>, DelegateType>>>
+		void Connect(HandlerType& handler, F&& function) noexcept
+		{
+			using Func = std::decay_t<F>;
+			if constexpr (DelegateType::template CanStoreInline<Func>)
+				Connect(handler, DelegateType(std::forward<F>(function)));
+			else
+				Connect(handler, HandlerFunction(std::forward<F>(function)));
+		}
+
 		void Disconnect(HandlerType& handler) noexcept;
 
 		void Trigger(Args&&... args) noexcept;
@@ -91,48 +247,159 @@ namespace greaper
 
 	template<class... Args>
 	Event<Args...>::Event(const StringView& eventName) noexcept
-		:m_Name(eventName)
-		,m_LastID(0)
+		:m_Snapshot(nullptr)
+		,m_Disconnected(0)
+		,m_Name(eventName)
 	{
 
 	}
 
+	template<class... Args>
+	Event<Args...>::~Event()
+	{
+		// No trigger can start anymore, the ones running hold their own reference
+		auto* snapshot = m_Snapshot.exchange(nullptr, std::memory_order_acq_rel);
+		if (snapshot != nullptr)
+			snapshot->RemoveRef();
+	}
+
+	template<class... Args>
+	typename Event<Args...>::Snapshot* Event<Args...>::Publish(uint32 capacity) noexcept
+	{
+		auto* current = m_Snapshot.load(std::memory_order_relaxed);
+		auto* snapshot = Snapshot::Create(capacity);
+		uint32 count = 0;
+		if (current != nullptr)
+		{
+			const auto currentCount = current->Count.load(std::memory_order_relaxed);
+			for (uint32 i = 0; i < currentCount; ++i)
+			{
+				const auto& entry = current->Entries[i];
+				if (!entry.Handler->Connected.load(std::memory_order_relaxed))
+					continue;
+				entry.Handler->AddRef();
+				snapshot->Entries[count++] = entry;
+			}
+		}
+		snapshot->Count.store(count, std::memory_order_relaxed);
+		m_Disconnected = 0;
+		m_Snapshot.store(snapshot, std::memory_order_release);
+		return current;
+	}
+
+	template<class... Args>
+	void Event<Args...>::RetireSnapshot(Snapshot* snapshot) noexcept
+	{
+		// Triggers that loaded the old snapshot hold their own reference
+		if (snapshot != nullptr)
+			EpochDomain::GetDefault().Retire(snapshot, &Snapshot::ReleaseRetired);
+	}
+
 	template<class... Args>
 	void Event<Args...>::Connect(HandlerType& handler, HandlerFunction function) noexcept
 	{
-		EventHandlerID<Args...> hnd;
-		hnd.Function = std::move(function);
-		hnd.ID = m_LastID++;
-		handler.m_Event = this;
-		handler.m_ID = hnd.ID;
-		auto lck = Lock(m_Mutex);
-		m_Handlers.push_back(std::move(hnd));
+		handler.Disconnect();
+		auto* slot = Slot::Create();
+		slot->Function = std::move(function);
+		const auto* stored = &slot->Function;
+		Insert(handler, slot, DelegateType([stored](auto&&... args) { (*stored)(std::forward<decltype(args)>(args)...); }));
 	}
 
 	template<class... Args>
-	void Event<Args...>::Disconnect(HandlerType& handler) noexcept
+	void Event<Args...>::Connect(HandlerType& handler, DelegateType function) noexcept
+	{
+		handler.Disconnect();
+		Insert(handler, Slot::Create(), function);
+	}
+
+	template<class... Args>
+	void Event<Args...>::Insert(HandlerType& handler, Slot* slot, const DelegateType& function) noexcept
 	{
-		auto lck = Lock(m_Mutex);
-		for (auto it = m_Handlers.begin(); it != m_Handlers.end(); ++it)
+		slot->Name = handler.m_Name;
+		Snapshot* retired = nullptr;
 		{
-			EventHandlerID<Args...>& hnd = *it;
-			if (hnd.ID == handler.m_ID)
+			auto lck = Lock(m_Mutex);
+			auto* snapshot = m_Snapshot.load(std::memory_order_relaxed);
+			auto count = snapshot != nullptr ? snapshot->Count.load(std::memory_order_relaxed) : 0;
+			if (snapshot == nullptr || count == snapshot->Capacity)
 			{
-				handler.m_Event = nullptr;
-				m_Handlers.erase(it);
-				break;
+				retired = Publish(Max(MinCapacity, (count - m_Disconnected + 1) * 2));
+				snapshot = m_Snapshot.load(std::memory_order_relaxed);
+				count = snapshot->Count.load(std::memory_order_relaxed);
 			}
+			snapshot->Entries[count] = Entry{ function, slot };
+			snapshot->Count.store(count + 1, std::memory_order_release);
+			handler.m_Event = this;
+			handler.m_Slot = slot;
 		}
+		RetireSnapshot(retired);
+	}
+
+	template<class... Args>
+	void Event<Args...>::Disconnect(HandlerType& handler) noexcept
+	{
+		if (handler.m_Slot == nullptr)
+			return;
+		Snapshot* retired = nullptr;
+		{
+			auto lck = Lock(m_Mutex);
+			handler.m_Slot->Connected.store(false, std::memory_order_release);
+			handler.m_Slot = nullptr;
+			handler.m_Event = nullptr;
+			auto* snapshot = m_Snapshot.load(std::memory_order_relaxed);
+			if (++m_Disconnected * 2 > snapshot->Count.load(std::memory_order_relaxed))
+				retired = Publish(Max(MinCapacity, snapshot->Capacity / 2));
+		}
+		RetireSnapshot(retired);
 	}
 
 	template<class... Args>
 	void Event<Args...>::Trigger(Args&&... args) noexcept
 	{
-		auto lck = Lock(m_Mutex);
-		for (EventHandlerID<Args...>& hnd : m_Handlers)
+		Snapshot* snapshot;
+		{
+			auto guard = EpochGuard();
+			snapshot = m_Snapshot.load(std::memory_order_acquire);
+			if (snapshot == nullptr)
+				return;
+			snapshot->AddRef();
+		}
+		const auto count = snapshot->Count.load(std::memory_order_acquire);
+		auto* sink = GetEventStatisticsSink();
+		if (sink == nullptr)
 		{
-			hnd.Function(std::forward<Args>(args)...);
+			for (uint32 i = 0; i < count; ++i)
+			{
+				const auto& entry = snapshot->Entries[i];
+				if (entry.Handler->Connected.load(std::memory_order_acquire))
+					entry.Function(std::forward<Args>(args)...);
+			}
+			snapshot->RemoveRef();
+			return;
+		}
+
+		const auto start = Clock_t::now();
+		auto before = start;
+		auto slowest = Duration_t{ 0 };
+		StringView slowestName;
+		uint32 handlerCount = 0;
+		for (uint32 i = 0; i < count; ++i)
+		{
+			const auto& entry = snapshot->Entries[i];
+			if (!entry.Handler->Connected.load(std::memory_order_acquire))
+				continue;
+			entry.Function(std::forward<Args>(args)...);
+			const auto after = Clock_t::now();
+			if (after - before > slowest)
+			{
+				slowest = after - before;
+				slowestName = entry.Handler->Name;
+			}
+			before = after;
+			++handlerCount;
 		}
+		sink->Record(m_Name, handlerCount, before - start, slowest, slowestName);
+		snapshot->RemoveRef();
 	}
 }
 
@@ -0,0 +1,372 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_EVENT_BUS_H
+#define CORE_EVENT_BUS_H 1
+
+#include "Concurrency.h"
+#include "FrameArena.h"
+#include "InplaceFunction.h"
+#include "IDeferredCallManager.h"
+#include "Base/ThreadBufferRegistry.h"
+#include <algorithm>
+#include <span>
+
+namespace greaper
+{
+	using EventID_t = uint32;
+
+	/** Posted event as seen by the listeners, the payload lives until the end of the dispatch */
+	struct DeferredEvent
+	{
+		EventID_t ID = 0;
+		uint32 Sequence = 0; // Post order inside the frame
+		const void* Payload = nullptr;
+		sizet Size = 0;
+
+		template<class T>
+		[[nodiscard]] INLINE const T& As()const noexcept
+		{
+			VerifyEqual(Size, sizeof(T), "Trying to read a DeferredEvent payload with the wrong type.");
+			return *static_cast<const T*>(Payload);
+		}
+	};
+
+	/** Receives every event of its EventID posted during the frame at once */
+	using EventListener_t = InplaceFunction<void(std::span<const DeferredEvent>)>;
+
+	struct EventSubscription
+	{
+		EventID_t Event = 0;
+		uint32 ID = 0;
+
+		[[nodiscard]] constexpr bool IsValid()const noexcept { return ID != 0; }
+	};
+
+	struct EventBusConfig
+	{
+		IDeferredCallManager* CallManager = nullptr; // Runs Dispatch on every DispatchPhase update, nullptr leaves it to the caller
+		DeferredUpdate_t DispatchPhase = DeferredUpdate_t::PreUpdate;
+		sizet ArenaChunkSize = 64 * 1024;
+	};
+
+	namespace Impl
+	{
+		/**
+		 * Events posted by one thread, double buffered by frame parity so the
+		 * dispatcher can drain one half while the thread keeps posting into the
+		 * other. Shared between the bus and the owner thread, the last one to
+		 * let it go frees it.
+		 */
+		struct alignas(CACHE_LINE_SIZE) EventBusBuffer : public SharedThreadBuffer<EventBusBuffer>
+		{
+			static constexpr uint64 PostingBit = 1;
+
+			struct Half
+			{
+				FrameArena Arena;
+				Vector<DeferredEvent> Events;
+
+				explicit Half(sizet chunkSize)
+					:Arena(chunkSize)
+				{
+
+				}
+			};
+
+			std::atomic<uint64> Posting{ 0 }; // (frame << 1) | PostingBit while the owner writes
+			Half Halves[2];
+
+			explicit EventBusBuffer(sizet chunkSize)
+				:Halves{ Half(chunkSize), Half(chunkSize) }
+			{
+
+			}
+
+			/** Frees the arenas and events while the owner thread keeps the buffer itself */
+			INLINE void ReleaseStorage() noexcept
+			{
+				for (auto& half : Halves)
+				{
+					half.Arena.Release();
+					Vector<DeferredEvent>().swap(half.Events);
+				}
+			}
+
+			static INLINE void Delete(EventBusBuffer* buffer) noexcept
+			{
+				buffer->~EventBusBuffer();
+				MemoryAllocator<GenericAllocator>::DeallocateAligned(buffer);
+			}
+		};
+	}
+
+	/**
+	 * @brief Deferred event system
+	 *
+	 * Events are posted from any thread into a buffer owned by that thread, with
+	 * no locks, and their payload is copied into the frame arena of the buffer.
+	 * Once per frame, during the configured update phase, Dispatch merges every
+	 * buffer, sorts the events by EventID and hands each listener the contiguous
+	 * span of the events it subscribed to, so the cost per event is a copy and a
+	 * sort instead of a call per handler.
+	 * Subscribe, Unsubscribe and Dispatch belong to the update thread, listeners
+	 * may subscribe and unsubscribe, which takes effect after the dispatch.
+	 * With a CallManager in the config the bus schedules its own Dispatch on the
+	 * dispatch phase, then it must be created and destroyed on the update thread.
+	 */
+	class EventBus
+	{
+		struct Listener
+		{
+			EventListener_t Function;
+			uint32 ID = 0;
+		};
+
+		EventBusConfig m_Config;
+		DeferredCallHandle m_DispatchCall;
+		std::atomic<uint64> m_Frame;
+		Impl::ThreadBufferRegistry<Impl::EventBusBuffer> m_Buffers;
+		UnorderedMap<EventID_t, Vector<Listener>> m_Listeners;
+		Vector<std::pair<EventID_t, Listener>> m_PendingListeners;
+		Vector<DeferredEvent> m_Merged;
+		uint32 m_LastListenerID;
+		bool m_Dispatching;
+		bool m_HasRemovedListeners;
+
+		INLINE Impl::EventBusBuffer* GetThreadBuffer()
+		{
+			return m_Buffers.GetThreadBuffer(m_Config.ArenaChunkSize);
+		}
+
+		/** Marks the buffer as being written on the current frame, same handshake as EpochDomain::Enter */
+		INLINE uint64 BeginPost(Impl::EventBusBuffer* buffer) noexcept
+		{
+			auto frame = m_Frame.load(std::memory_order_relaxed);
+			while (true)
+			{
+				// Release so the dispatcher reading it also sees the previous posts
+				buffer->Posting.store((frame << 1) | Impl::EventBusBuffer::PostingBit, std::memory_order_release);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				// Acquire pairs with the frame flip, the dispatcher reset this half before it
+				const auto current = m_Frame.load(std::memory_order_acquire);
+				if (current == frame)
+					return frame;
+				frame = current;
+			}
+		}
+
+		INLINE void EndPost(Impl::EventBusBuffer* buffer) noexcept
+		{
+			buffer->Posting.store(0, std::memory_order_release);
+		}
+
+		void ApplyListenerChanges()
+		{
+			if (m_HasRemovedListeners)
+			{
+				for (auto it = m_Listeners.begin(); it != m_Listeners.end(); )
+				{
+					auto& listeners = it->second;
+					listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](const Listener& listener) { return listener.ID == 0; }), listeners.end());
+					if (listeners.empty())
+						it = m_Listeners.erase(it);
+					else
+						++it;
+				}
+				m_HasRemovedListeners = false;
+			}
+			for (auto& pending : m_PendingListeners)
+				m_Listeners[pending.first].push_back(std::move(pending.second));
+			m_PendingListeners.clear();
+		}
+
+		void ScheduleDispatch()
+		{
+			m_DispatchCall = m_Config.CallManager->DelayCall([this]()
+				{
+					Dispatch();
+					ScheduleDispatch();
+				}, 0, m_Config.DispatchPhase);
+			Verify(m_DispatchCall.IsValid(), "Trying to schedule the dispatch of an EventBus outside the update thread.");
+		}
+
+	public:
+		explicit EventBus(const EventBusConfig& config = EventBusConfig{})
+			:m_Config(config)
+			,m_Frame(0)
+			,m_LastListenerID(0)
+			,m_Dispatching(false)
+			,m_HasRemovedListeners(false)
+		{
+			if (m_Config.CallManager != nullptr)
+				ScheduleDispatch();
+		}
+		EventBus(const EventBus&) = delete;
+		EventBus& operator=(const EventBus&) = delete;
+
+		/**
+		 * No thread may be posting. The storage of every buffer is freed here,
+		 * the buffers still owned by a live thread are left empty and deleted
+		 * when it exits or posts to a bus it has no buffer for.
+		 */
+		~EventBus()
+		{
+			if (m_DispatchCall.IsValid())
+				m_Config.CallManager->CancelCall(m_DispatchCall);
+
+			m_Buffers.ReleaseAll([](Impl::EventBusBuffer* buffer) { buffer->ReleaseStorage(); });
+		}
+
+		[[nodiscard]] INLINE DeferredUpdate_t GetDispatchPhase()const noexcept { return m_Config.DispatchPhase; }
+
+		/** Thread-safe and lock-free, the payload is copied into the frame arena */
+		INLINE void Post(EventID_t id, const void* payload, sizet size, sizet alignment = alignof(std::max_align_t))
+		{
+			auto* buffer = GetThreadBuffer();
+			const auto frame = BeginPost(buffer);
+			auto& half = buffer->Halves[frame & 1];
+			void* data = nullptr;
+			if (size > 0)
+			{
+				data = half.Arena.Allocate(size, alignment);
+				memcpy(data, payload, size);
+			}
+			half.Events.push_back(DeferredEvent{ id, 0, data, size });
+			EndPost(buffer);
+		}
+
+		template<class T>
+		INLINE void Post(EventID_t id, const T& payload)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "EventBus payloads are copied into a frame arena and never destroyed.");
+			Post(id, &payload, sizeof(T), alignof(T));
+		}
+
+		INLINE void Post(EventID_t id)
+		{
+			Post(id, nullptr, 0);
+		}
+
+		INLINE EventSubscription Subscribe(EventID_t id, EventListener_t listener)
+		{
+			const auto listenerID = ++m_LastListenerID;
+			if (m_Dispatching)
+				m_PendingListeners.emplace_back(id, Listener{ std::move(listener), listenerID });
+			else
+				m_Listeners[id].push_back(Listener{ std::move(listener), listenerID });
+			return EventSubscription{ id, listenerID };
+		}
+
+		/** Returns false if the subscription was not found */
+		INLINE bool Unsubscribe(EventSubscription& subscription)
+		{
+			if (!subscription.IsValid())
+				return false;
+			const auto eventID = subscription.Event;
+			const auto listenerID = subscription.ID;
+			subscription = EventSubscription{};
+			for (auto it = m_PendingListeners.begin(); it != m_PendingListeners.end(); ++it)
+			{
+				if (it->second.ID == listenerID)
+				{
+					m_PendingListeners.erase(it);
+					return true;
+				}
+			}
+			auto found = m_Listeners.find(eventID);
+			if (found == m_Listeners.end())
+				return false;
+			auto& listeners = found->second;
+			for (auto it = listeners.begin(); it != listeners.end(); ++it)
+			{
+				if (it->ID != listenerID)
+					continue;
+				if (m_Dispatching)
+				{
+					// It may be the one running, it is removed after the dispatch
+					it->ID = 0;
+					m_HasRemovedListeners = true;
+				}
+				else
+				{
+					listeners.erase(it);
+					if (listeners.empty())
+						m_Listeners.erase(found);
+				}
+				return true;
+			}
+			return false;
+		}
+
+		/**
+		 * Delivers the events posted since the previous Dispatch, must be called
+		 * once per frame during the dispatch phase, which the bus does by itself
+		 * when it has a CallManager. Events posted by the listeners
+		 * are delivered on the next one. Returns the amount of events dispatched.
+		 */
+		sizet Dispatch()
+		{
+			VerifyNot(m_Dispatching, "Trying to dispatch an EventBus from one of its listeners.");
+			const auto frame = m_Frame.fetch_add(1, std::memory_order_seq_cst);
+			const auto postingFrame = (frame << 1) | Impl::EventBusBuffer::PostingBit;
+
+			m_Merged.clear();
+			for (auto* buffer = m_Buffers.GetFirst(); buffer != nullptr; buffer = buffer->Next)
+			{
+				// Posters that saw the previous frame are done in a few instructions
+				while (buffer->Posting.load(std::memory_order_acquire) == postingFrame)
+					THREAD_YIELD();
+				const auto& events = buffer->Halves[frame & 1].Events;
+				m_Merged.insert(m_Merged.end(), events.begin(), events.end());
+			}
+
+			for (sizet i = 0; i < m_Merged.size(); ++i)
+				m_Merged[i].Sequence = static_cast<uint32>(i);
+			std::sort(m_Merged.begin(), m_Merged.end(), [](const DeferredEvent& left, const DeferredEvent& right)
+				{
+					if (left.ID != right.ID)
+						return left.ID < right.ID;
+					return left.Sequence < right.Sequence;
+				});
+
+			m_Dispatching = true;
+			for (sizet begin = 0; begin < m_Merged.size(); )
+			{
+				const auto id = m_Merged[begin].ID;
+				auto end = begin + 1;
+				while (end < m_Merged.size() && m_Merged[end].ID == id)
+					++end;
+
+				auto found = m_Listeners.find(id);
+				if (found != m_Listeners.end())
+				{
+					const auto events = std::span<const DeferredEvent>(m_Merged.data() + begin, end - begin);
+					auto& listeners = found->second;
+					for (auto& listener : listeners)
+					{
+						if (listener.ID != 0)
+							listener.Function(events);
+					}
+				}
+				begin = end;
+			}
+			m_Dispatching = false;
+			ApplyListenerChanges();
+
+			for (auto* buffer = m_Buffers.GetFirst(); buffer != nullptr; buffer = buffer->Next)
+			{
+				auto& half = buffer->Halves[frame & 1];
+				half.Events.clear();
+				half.Arena.Reset();
+			}
+			return m_Merged.size();
+		}
+	};
+}
+
+#endif /* CORE_EVENT_BUS_H */
\ No newline at end of file
@@ -0,0 +1,128 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_FILE_STREAM_H
+#define CORE_FILE_STREAM_H 1
+
+#include "BufferedStream.h"
+
+#if PLT_WINDOWS
+#include "Win/WinFile.h"
+#else
+#include "Lnx/LnxFile.h"
+#endif
+
+namespace greaper
+{
+	struct FileStreamConfig
+	{
+		sizet BufferSize = 64 * 1024; // 0 disables the user-space buffer
+		FileAccessPattern_t AccessPattern = FileAccessPattern_t::Normal;
+		FileOpenMode_t OpenMode = FileOpenMode_t::OpenExisting; // Writable streams create the file unless OpenExisting
+	};
+
+	/**
+	 * Unbuffered file stream, every transfer is a syscall. Seek, Skip and Tell
+	 * never make one, the file offset is only moved on the next transfer when
+	 * it isn't already there. The BufferSize of the config is ignored.
+	 */
+	class OSFileStream : public IStream
+	{
+		FileStreamConfig m_Config;
+		OSFile::Handle m_Handle;
+		mutable int64 m_Offset;
+		mutable int64 m_FileOffset; // Offset of the OS file cursor
+
+		bool MoveFileOffset()const;
+
+	public:
+		OSFileStream(StringView path, uint16 accessMode = READ, const FileStreamConfig& config = FileStreamConfig{});
+
+		OSFileStream(const OSFileStream&) = delete;
+		OSFileStream& operator=(const OSFileStream&) = delete;
+
+		~OSFileStream();
+
+		INLINE bool IsFile()const noexcept override { return true; }
+
+		[[nodiscard]] INLINE bool IsOpen()const noexcept { return m_Handle != OSFile::InvalidHandle; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** A single readv straight into the pieces */
+		ssizet ReadV(std::span<const IOVec> vecs)const override;
+
+		/** A single writev from the pieces */
+		ssizet WriteV(std::span<const IOVec> vecs) override;
+
+		void Skip(ssizet count) override;
+
+		void Seek(ssizet pos) override;
+
+		ssizet Tell()const override { return (ssizet)m_Offset; }
+
+		bool Eof()const override { return m_Offset >= (int64)m_Size; }
+
+		/** Opens the same file again with the same access and position, data is never copied */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		/** Waits until the written data reaches the device */
+		bool Sync();
+
+		void SetAccessPattern(FileAccessPattern_t pattern);
+
+		[[nodiscard]] INLINE const FileStreamConfig& GetConfig()const noexcept { return m_Config; }
+	};
+
+	/**
+	 * Buffered file stream, a BufferedStream over an OSFileStream. The same
+	 * buffer is used for reading and writing, switching direction flushes it.
+	 * Transfers of at least the buffer size go straight between the file and
+	 * the caller memory, and Seek, Skip and Tell never make a syscall, the file
+	 * offset is only moved on the next transfer when the target is not already
+	 * inside the buffer.
+	 */
+	class FileStream : public BufferedStream
+	{
+		FileStreamConfig m_FileConfig;
+
+		INLINE OSFileStream* GetFile()const noexcept { return static_cast<OSFileStream*>(m_Inner.get()); }
+
+	public:
+		FileStream(StringView path, uint16 accessMode = READ, const FileStreamConfig& config = FileStreamConfig{});
+
+		FileStream(const FileStream&) = delete;
+		FileStream& operator=(const FileStream&) = delete;
+
+		~FileStream();
+
+		INLINE bool IsFile()const noexcept override { return true; }
+
+		[[nodiscard]] INLINE bool IsOpen()const noexcept { return m_Inner != nullptr && GetFile()->IsOpen(); }
+
+		/** Opens the same file again with the same access and position, data is never copied, nullptr if the pending writes fail */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		/** Pending writes that fail here are lost, call Flush first to know whether they made it */
+		void Close() override;
+
+		/** Hands the buffered writes to the OS, syncDevice also waits for the device */
+		bool Flush(bool syncDevice = false);
+
+		void SetAccessPattern(FileAccessPattern_t pattern);
+
+		[[nodiscard]] INLINE const FileStreamConfig& GetConfig()const noexcept { return m_FileConfig; }
+	};
+}
+
+#include "Base/FileStream.inl"
+
+#endif /* CORE_FILE_STREAM_H */
\ No newline at end of file
@@ -0,0 +1,141 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_FRAME_ARENA_H
+#define CORE_FRAME_ARENA_H 1
+
+#include "Memory.h"
+
+namespace greaper
+{
+	/**
+	 * Chunked bump allocator for data that lives until the end of a frame.
+	 * Allocating is a pointer bump, Reset rewinds every chunk at once keeping
+	 * them for the next frame, so a steady frame never touches the heap.
+	 * Destructors are not run, only trivially destructible data belongs here.
+	 * Not thread-safe.
+	 */
+	class FrameArena
+	{
+		struct alignas(16) Chunk
+		{
+			Chunk* Next;
+			sizet Size;
+		};
+
+		Chunk* m_First = nullptr;
+		Chunk* m_Current = nullptr;
+		uint8* m_Cursor = nullptr;
+		uint8* m_End = nullptr;
+		sizet m_ChunkSize;
+		sizet m_Used = 0;
+
+		static INLINE uint8* GetData(Chunk* chunk) noexcept { return reinterpret_cast<uint8*>(chunk + 1); }
+
+		INLINE void SetCurrent(Chunk* chunk) noexcept
+		{
+			m_Current = chunk;
+			m_Cursor = GetData(chunk);
+			m_End = m_Cursor + chunk->Size;
+		}
+
+		void* AllocateSlow(sizet size, sizet alignment)
+		{
+			// Reuse the following chunks first, they were kept by Reset
+			while (m_Current != nullptr && m_Current->Next != nullptr)
+			{
+				SetCurrent(m_Current->Next);
+				auto* ptr = TryBump(size, alignment);
+				if (ptr != nullptr)
+					return ptr;
+			}
+			const auto dataSize = Max(m_ChunkSize, size + alignment);
+			auto* chunk = static_cast<Chunk*>(Alloc(sizeof(Chunk) + dataSize));
+			chunk->Next = nullptr;
+			chunk->Size = dataSize;
+			if (m_Current != nullptr)
+				m_Current->Next = chunk;
+			else
+				m_First = chunk;
+			SetCurrent(chunk);
+			return TryBump(size, alignment);
+		}
+
+		INLINE void* TryBump(sizet size, sizet alignment) noexcept
+		{
+			if (m_Cursor == nullptr)
+				return nullptr;
+			const auto address = reinterpret_cast<ptruint>(m_Cursor);
+			const auto padding = ((address + alignment - 1) & ~static_cast<ptruint>(alignment - 1)) - address;
+			if (padding + size > static_cast<sizet>(m_End - m_Cursor))
+				return nullptr;
+			auto* aligned = m_Cursor + padding;
+			m_Cursor = aligned + size;
+			m_Used += size;
+			return aligned;
+		}
+
+	public:
+		explicit FrameArena(sizet chunkSize = 64 * 1024) noexcept
+			:m_ChunkSize(Max<sizet>(chunkSize, 256))
+		{
+
+		}
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		~FrameArena()
+		{
+			Release();
+		}
+
+		/** alignment must be a power of two */
+		[[nodiscard]] INLINE void* Allocate(sizet size, sizet alignment = alignof(std::max_align_t))
+		{
+			auto* ptr = TryBump(size, alignment);
+			if (ptr != nullptr)
+				return ptr;
+			return AllocateSlow(size, alignment);
+		}
+
+		template<class T>
+		[[nodiscard]] INLINE T* AllocateT(sizet count = 1)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		/** Every previous allocation becomes invalid, the chunks are kept */
+		INLINE void Reset() noexcept
+		{
+			m_Used = 0;
+			if (m_First != nullptr)
+				SetCurrent(m_First);
+		}
+
+		/** Frees every chunk */
+		INLINE void Release() noexcept
+		{
+			auto* chunk = m_First;
+			while (chunk != nullptr)
+			{
+				auto* next = chunk->Next;
+				Dealloc(chunk);
+				chunk = next;
+			}
+			m_First = nullptr;
+			m_Current = nullptr;
+			m_Cursor = nullptr;
+			m_End = nullptr;
+			m_Used = 0;
+		}
+
+		/** Bytes handed out since the last Reset, without the alignment padding */
+		[[nodiscard]] INLINE sizet GetUsedSize()const noexcept { return m_Used; }
+	};
+}
+
+#endif /* CORE_FRAME_ARENA_H */
\ No newline at end of file
@@ -0,0 +1,361 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_FUTURE_H
+#define CORE_FUTURE_H 1
+
+#include "Concurrency.h"
+#include "Base/PooledBlockCache.h"
+#include <new>
+#include <type_traits>
+
+namespace greaper
+{
+	/**
+	 * @brief Single allocation Promise/Future pair
+	 *
+	 * Both ends share an intrusive refcounted block which holds the state word
+	 * and inline storage for the value, blocks are drawn from a thread-local pool
+	 * keyed by size, so creating an operation usually doesn't touch the allocator.
+	 * Waiters park directly on the state word through WaitOnAddress.
+	 */
+	namespace Impl
+	{
+		enum FutureState : uint32
+		{
+			FutureStatePending = 0,
+			FutureStateWaiting = 1,
+			FutureStateReady = 2,
+			FutureStateBroken = 3,
+			FutureStateCancelled = 4
+		};
+
+		struct FutureStateBase
+		{
+			std::atomic<uint32> State{ FutureStatePending };
+			std::atomic<uint32> RefCount{ 1 };
+			void(*Release)(FutureStateBase*) = nullptr;
+
+			INLINE void AddRef() noexcept
+			{
+				RefCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			INLINE void RemoveRef() noexcept
+			{
+				if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					Release(this);
+			}
+
+			[[nodiscard]] INLINE bool IsDone()const noexcept
+			{
+				return State.load(std::memory_order_acquire) >= FutureStateReady;
+			}
+
+			INLINE void Publish(uint32 state) noexcept
+			{
+				if (State.exchange(state, std::memory_order_acq_rel) == FutureStateWaiting)
+					WakeByAddressAll(State);
+			}
+
+			INLINE void Wait() noexcept
+			{
+				auto state = State.load(std::memory_order_acquire);
+				while (state < FutureStateReady)
+				{
+					if (state == FutureStatePending && !State.compare_exchange_weak(state, FutureStateWaiting, std::memory_order_acquire))
+						continue;
+					WaitOnAddress(State, FutureStateWaiting);
+					state = State.load(std::memory_order_acquire);
+				}
+			}
+
+			INLINE bool WaitFor(uint32 millis) noexcept
+			{
+				const auto deadline = Clock_t::now() + std::chrono::milliseconds(millis);
+				auto state = State.load(std::memory_order_acquire);
+				while (state < FutureStateReady)
+				{
+					if (state == FutureStatePending && !State.compare_exchange_weak(state, FutureStateWaiting, std::memory_order_acquire))
+						continue;
+					const auto now = Clock_t::now();
+					if (now >= deadline)
+						return false;
+					const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+					WaitOnAddress(State, FutureStateWaiting, static_cast<uint32>(Max<int64>(remaining, 1)));
+					state = State.load(std::memory_order_acquire);
+				}
+				return true;
+			}
+		};
+
+		template<class T>
+		struct TFutureState : public FutureStateBase
+		{
+			using StorageType = std::conditional_t<std::is_void_v<T>, uint8, T>;
+			alignas(StorageType) uint8 Storage[sizeof(StorageType)];
+
+			[[nodiscard]] INLINE StorageType* GetValue() noexcept
+			{
+				return std::launder(reinterpret_cast<StorageType*>(Storage));
+			}
+		};
+
+		// Blocks are rounded to cache lines, so states of different types share pools
+		template<class T>
+		using TFutureStatePool = PooledBlockCache<(sizeof(TFutureState<T>) + 63) & ~sizet(63), Max<sizet>(alignof(TFutureState<T>), 64)>;
+
+		template<class T>
+		INLINE void DestroyFutureState(FutureStateBase* base) noexcept
+		{
+			auto* state = static_cast<TFutureState<T>*>(base);
+			if constexpr (!std::is_void_v<T> && !std::is_trivially_destructible_v<T>)
+			{
+				if (state->State.load(std::memory_order_relaxed) == FutureStateReady)
+					state->GetValue()->~T();
+			}
+			state->~TFutureState<T>();
+			TFutureStatePool<T>::Deallocate(state);
+		}
+
+		template<class T>
+		INLINE TFutureState<T>* CreateFutureState() noexcept
+		{
+			auto* state = new(TFutureStatePool<T>::Allocate())TFutureState<T>();
+			state->Release = &DestroyFutureState<T>;
+			return state;
+		}
+	}
+
+	template<class T> class Promise;
+
+	template<class T>
+	class Future
+	{
+		Impl::TFutureState<T>* m_State = nullptr;
+
+		explicit Future(Impl::TFutureState<T>* state) noexcept
+			:m_State(state)
+		{
+
+		}
+
+		friend class Promise<T>;
+
+	public:
+		using ReturnType = T;
+
+		Future() noexcept = default;
+
+		Future(const Future& other) noexcept
+			:m_State(other.m_State)
+		{
+			if (m_State != nullptr)
+				m_State->AddRef();
+		}
+
+		Future(Future&& other) noexcept
+			:m_State(other.m_State)
+		{
+			other.m_State = nullptr;
+		}
+
+		Future& operator=(const Future& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (other.m_State != nullptr)
+					other.m_State->AddRef();
+				if (m_State != nullptr)
+					m_State->RemoveRef();
+				m_State = other.m_State;
+			}
+			return *this;
+		}
+
+		Future& operator=(Future&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_State != nullptr)
+					m_State->RemoveRef();
+				m_State = other.m_State;
+				other.m_State = nullptr;
+			}
+			return *this;
+		}
+
+		~Future()
+		{
+			if (m_State != nullptr)
+				m_State->RemoveRef();
+		}
+
+		[[nodiscard]] INLINE bool IsValid()const noexcept { return m_State != nullptr; }
+
+		/** Returns true once a value has been set, the promise has been cancelled or destroyed without one */
+		[[nodiscard]] INLINE bool HasCompleted()const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use an empty Future.");
+			return m_State->IsDone();
+		}
+
+		/** Returns true if the producer gave up through Promise::SetCancelled */
+		[[nodiscard]] INLINE bool IsCancelled()const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use an empty Future.");
+			return m_State->State.load(std::memory_order_acquire) == Impl::FutureStateCancelled;
+		}
+
+		/** Returns false if the promise was destroyed without setting a value */
+		[[nodiscard]] INLINE bool HasValue()const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use an empty Future.");
+			return m_State->State.load(std::memory_order_acquire) == Impl::FutureStateReady;
+		}
+
+		INLINE void BlockUntilComplete()const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use an empty Future.");
+			m_State->Wait();
+		}
+
+		/** Returns false if the timeout expired before completion */
+		INLINE bool BlockUntilComplete(uint32 millis)const noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use an empty Future.");
+			return m_State->WaitFor(millis);
+		}
+
+		/** Blocks until completion, and returns the value */
+		INLINE decltype(auto) GetReturnValue()const noexcept
+		{
+			BlockUntilComplete();
+			Verify(HasValue(), "Trying to get a Future return value but its Promise was broken or cancelled.");
+			if constexpr (!std::is_void_v<T>)
+				return static_cast<const T&>(*m_State->GetValue());
+		}
+
+		INLINE decltype(auto) GetReturnValue() noexcept
+		{
+			BlockUntilComplete();
+			Verify(HasValue(), "Trying to get a Future return value but its Promise was broken or cancelled.");
+			if constexpr (!std::is_void_v<T>)
+				return static_cast<T&>(*m_State->GetValue());
+		}
+
+		friend bool operator==(const Future& left, std::nullptr_t) noexcept { return left.m_State == nullptr; }
+		friend bool operator!=(const Future& left, std::nullptr_t) noexcept { return left.m_State != nullptr; }
+	};
+
+	/**
+	 * Writing end of a Future, only one thread may set the value. Destroying it
+	 * without setting a value breaks the promise and releases the waiters.
+	 */
+	template<class T>
+	class Promise
+	{
+		Impl::TFutureState<T>* m_State;
+		bool m_FutureRetrieved = false;
+		bool m_Satisfied = false;
+
+	public:
+		Promise() noexcept
+			:m_State(Impl::CreateFutureState<T>())
+		{
+
+		}
+
+		Promise(const Promise&) = delete;
+		Promise& operator=(const Promise&) = delete;
+
+		Promise(Promise&& other) noexcept
+			:m_State(other.m_State)
+			,m_FutureRetrieved(other.m_FutureRetrieved)
+			,m_Satisfied(other.m_Satisfied)
+		{
+			other.m_State = nullptr;
+		}
+
+		Promise& operator=(Promise&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Abandon();
+				m_State = other.m_State;
+				m_FutureRetrieved = other.m_FutureRetrieved;
+				m_Satisfied = other.m_Satisfied;
+				other.m_State = nullptr;
+			}
+			return *this;
+		}
+
+		~Promise()
+		{
+			Abandon();
+		}
+
+		[[nodiscard]] Future<T> GetFuture() noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use a moved Promise.");
+			Verify(!m_FutureRetrieved, "Trying to retrieve the Future of a Promise twice, copy the Future instead.");
+			m_FutureRetrieved = true;
+			m_State->AddRef();
+			return Future<T>(m_State);
+		}
+
+		template<class... Args>
+		INLINE void SetValue(Args&&... args) noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use a moved Promise.");
+			Verify(!m_Satisfied, "Trying to set the value of a Promise twice.");
+			m_Satisfied = true;
+			if constexpr (!std::is_void_v<T>)
+				new(m_State->GetValue())T(std::forward<Args>(args)...);
+			m_State->Publish(Impl::FutureStateReady);
+		}
+
+		/** Completes the Future without a value, used when the operation observed a cancellation request */
+		INLINE void SetCancelled() noexcept
+		{
+			VerifyNotNull(m_State, "Trying to use a moved Promise.");
+			Verify(!m_Satisfied, "Trying to cancel an already satisfied Promise.");
+			m_Satisfied = true;
+			m_State->Publish(Impl::FutureStateCancelled);
+		}
+
+		[[nodiscard]] INLINE bool IsSatisfied()const noexcept { return m_Satisfied; }
+
+	private:
+		INLINE void Abandon() noexcept
+		{
+			if (m_State == nullptr)
+				return;
+			if (!m_Satisfied)
+				m_State->Publish(Impl::FutureStateBroken);
+			m_State->RemoveRef();
+			m_State = nullptr;
+		}
+	};
+
+	/** Creates an already completed Future, useful for operations that finish synchronously */
+	template<class T, class... Args>
+	[[nodiscard]] INLINE Future<T> MakeReadyFuture(Args&&... args) noexcept
+	{
+		Promise<T> promise;
+		auto future = promise.GetFuture();
+		promise.SetValue(std::forward<Args>(args)...);
+		return future;
+	}
+
+	template<class RetType>
+	using TAsyncOp = Future<RetType>;
+
+	using AsyncOp = Future<void>;
+}
+
+#endif /* CORE_FUTURE_H */
\ No newline at end of file
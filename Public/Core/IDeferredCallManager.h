@@ -9,22 +9,29 @@
 #define CORE_I_DEFERRED_CALL_MANAGER_H 1
 
 #include "Interface.h"
-#include "Enumeration.h"
-#include <functional>
+#include "Base/DeferredCallScheduler.h"
 
 namespace greaper
 {
-    ENUMERATION(DeferredUpdate, PreUpdate, Update, PostUpdate, Fixed);
-
     class IDeferredCallManager : public TInterface<IDeferredCallManager>
     {
     public:
         static constexpr Uuid InterfaceUUID = Uuid{ 0x07C76D1A, 0xF08C4F0B, 0x8870B912, 0xE75E481E };
         static constexpr StringView InterfaceName = StringView{ "DeferredCallManager" };
 
-        virtual void DelayCall(std::function<void()> call, uint32 updatesToWait = 0, DeferredUpdate_t updateWhen = DeferredUpdate_t::Update) = 0;
+        /**
+         * The submission functions can be called from any thread, calls from outside the update thread are
+         * spliced into the phase on its next update and return an invalid handle.
+         */
+        virtual DeferredCallHandle DelayCall(DeferredCall_t call, uint32 updatesToWait = 0, DeferredUpdate_t updateWhen = DeferredUpdate_t::Update) = 0;
+
+        virtual DeferredCallHandle DelayCallTime(DeferredCall_t call, Duration_t timeToWait = Duration_t{0}, DeferredUpdate_t updateWhen = DeferredUpdate_t::Update) = 0;
+
+        /** Bulk DelayCall, the requests are submitted as a single batch and their calls are moved out */
+        virtual void DelayCalls(std::span<DeferredCallRequest> calls, DeferredUpdate_t updateWhen = DeferredUpdate_t::Update) = 0;
 
-        virtual void DelayCallTime(std::function<void()> call, Duration_t timeToWait = Duration_t{0}, DeferredUpdate_t updateWhen = DeferredUpdate_t::Update) = 0;
+        /** O(1), returns false if the call already ran or was cancelled */
+        virtual bool CancelCall(const DeferredCallHandle& handle) = 0;
     };
 }
 
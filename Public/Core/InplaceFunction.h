@@ -0,0 +1,142 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_INPLACE_FUNCTION_H
+#define CORE_INPLACE_FUNCTION_H 1
+
+#include "Memory.h"
+#include <new>
+#include <type_traits>
+
+namespace greaper
+{
+	constexpr sizet InplaceFunctionDefaultCapacity = 48;
+
+	template<class Signature, sizet Capacity = InplaceFunctionDefaultCapacity>
+	class InplaceFunction;
+
+	/**
+	 * Move-only replacement of std::function that never allocates, the callable
+	 * is stored inside the object and must fit in Capacity bytes, which is
+	 * checked at compile time.
+	 */
+	template<class R, class... Args, sizet Capacity>
+	class InplaceFunction<R(Args...), Capacity>
+	{
+		struct Operations
+		{
+			R(*Invoke)(void* storage, Args&&... args);
+			void(*MoveTo)(void* src, void* dst) noexcept;
+			void(*Destroy)(void* storage) noexcept;
+		};
+
+		template<class F>
+		static constexpr Operations OperationsFor = {
+			[](void* storage, Args&&... args) -> R
+			{
+				return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+			},
+			[](void* src, void* dst) noexcept
+			{
+				new(dst)F(std::move(*static_cast<F*>(src)));
+				static_cast<F*>(src)->~F();
+			},
+			[](void* storage) noexcept
+			{
+				static_cast<F*>(storage)->~F();
+			}
+		};
+
+		alignas(std::max_align_t) uint8 m_Storage[Capacity];
+		const Operations* m_Ops = nullptr;
+
+	public:
+		static constexpr sizet StorageCapacity = Capacity;
+
+		InplaceFunction() noexcept = default;
+
+		InplaceFunction(std::nullptr_t) noexcept
+		{
+
+		}
+
+		template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+		InplaceFunction(F&& func) noexcept(std::is_nothrow_constructible_v<std::decay_t<F>, F&&>)
+		{
+			using Func = std::decay_t<F>;
+			static_assert(sizeof(Func) <= Capacity, "The callable is too big for this InplaceFunction, increase its Capacity or reduce the captures.");
+			static_assert(alignof(Func) <= alignof(std::max_align_t), "The callable is over-aligned for an InplaceFunction.");
+			static_assert(std::is_nothrow_move_constructible_v<Func>, "InplaceFunction callables must be nothrow move constructible.");
+			if constexpr (std::is_pointer_v<Func> || std::is_member_pointer_v<Func>)
+			{
+				if (func == nullptr)
+					return;
+			}
+			new(m_Storage)Func(std::forward<F>(func));
+			m_Ops = &OperationsFor<Func>;
+		}
+
+		InplaceFunction(InplaceFunction&& other) noexcept
+		{
+			if (other.m_Ops == nullptr)
+				return;
+			other.m_Ops->MoveTo(other.m_Storage, m_Storage);
+			m_Ops = other.m_Ops;
+			other.m_Ops = nullptr;
+		}
+
+		InplaceFunction& operator=(InplaceFunction&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				if (other.m_Ops != nullptr)
+				{
+					other.m_Ops->MoveTo(other.m_Storage, m_Storage);
+					m_Ops = other.m_Ops;
+					other.m_Ops = nullptr;
+				}
+			}
+			return *this;
+		}
+
+		InplaceFunction& operator=(std::nullptr_t) noexcept
+		{
+			Reset();
+			return *this;
+		}
+
+		InplaceFunction(const InplaceFunction&) = delete;
+		InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+		~InplaceFunction()
+		{
+			Reset();
+		}
+
+		INLINE void Reset() noexcept
+		{
+			if (m_Ops == nullptr)
+				return;
+			m_Ops->Destroy(m_Storage);
+			m_Ops = nullptr;
+		}
+
+		INLINE R operator()(Args... args)const
+		{
+			VerifyNotNull(m_Ops, "Trying to call an empty InplaceFunction.");
+			return m_Ops->Invoke(const_cast<uint8*>(m_Storage), std::forward<Args>(args)...);
+		}
+
+		[[nodiscard]] INLINE explicit operator bool()const noexcept { return m_Ops != nullptr; }
+
+		friend bool operator==(const InplaceFunction& left, std::nullptr_t) noexcept { return left.m_Ops == nullptr; }
+		friend bool operator!=(const InplaceFunction& left, std::nullptr_t) noexcept { return left.m_Ops != nullptr; }
+	};
+}
+
+#endif /* CORE_INPLACE_FUNCTION_H */
\ No newline at end of file
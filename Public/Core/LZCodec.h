@@ -0,0 +1,63 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_LZ_CODEC_H
+#define CORE_LZ_CODEC_H 1
+
+#include "Memory.h"
+#include "Enumeration.h"
+#include <span>
+
+namespace greaper
+{
+	/** Fast takes the first match a hash table gives, High walks hash chains for the longest one and matches lazily */
+	ENUMERATION(CompressionLevel, Fast, High);
+
+	/** Worst case size of a compressed block, incompressible data grows a little */
+	[[nodiscard]] constexpr sizet LZCompressBound(sizet size) noexcept
+	{
+		return size + size / 255 + 16;
+	}
+
+	/**
+	 * LZ77 block compressor producing the LZ4 block format: sequences of
+	 * literals followed by a match up to 64KiB back. Each block is
+	 * self-contained, so blocks can be decoded in any order. The match tables
+	 * are kept between calls to avoid reallocating them for every block.
+	 */
+	class LZCompressor
+	{
+		static constexpr uint32 FastHashLog = 14;
+		static constexpr uint32 HighHashLog = 15;
+		static constexpr uint32 HighMaxAttempts = 64;
+
+		Vector<uint32> m_Table; // Position + 1 of the last occurrence of each hash, 0 if none
+		Vector<uint16> m_Chain; // Distance to the previous position with the same hash, indexed by position modulo the window
+
+		sizet CompressFast(const uint8* src, sizet size, uint8* dst);
+
+		sizet CompressHigh(const uint8* src, sizet size, uint8* dst);
+
+	public:
+		/**
+		 * Compresses src into dst, which must hold LZCompressBound(src.size())
+		 * bytes, returns the compressed size.
+		 */
+		sizet Compress(std::span<const uint8> src, std::span<uint8> dst, CompressionLevel_t level = CompressionLevel_t::Fast);
+	};
+
+	/**
+	 * Decompresses a whole block into dst, which must be big enough for it.
+	 * Malformed input never reads or writes out of bounds, returns the
+	 * decompressed size or -1 if the block is malformed or doesn't fit.
+	 */
+	[[nodiscard]] ssizet LZDecompress(std::span<const uint8> src, std::span<uint8> dst) noexcept;
+}
+
+#include "Base/LZCodec.inl"
+
+#endif /* CORE_LZ_CODEC_H */
\ No newline at end of file
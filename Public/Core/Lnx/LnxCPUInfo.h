@@ -0,0 +1,239 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_LNX_CPU_INFO_H
+#define CORE_LNX_CPU_INFO_H 1
+
+#include "../Base/CPUInfo.h"
+#include <sched.h>
+#include <sys/resource.h>
+#include <cstdio>
+#include <algorithm>
+
+namespace greaper
+{
+	class LnxCPUInfo
+	{
+		static bool ReadFileLine(const achar* path, achar* buffer, sizet bufferSize)
+		{
+			FILE* file = fopen(path, "r");
+			if (file == nullptr)
+				return false;
+			const bool read = fgets(buffer, (int)bufferSize, file) != nullptr;
+			fclose(file);
+			return read;
+		}
+
+		static bool ReadFileUInt(const achar* path, uint32& value)
+		{
+			achar buffer[64];
+			if (!ReadFileLine(path, buffer, ArraySize(buffer)))
+				return false;
+			value = (uint32)strtoul(buffer, nullptr, 10);
+			return true;
+		}
+
+		/** Parses the kernel cpu list format, ie: "0-3,8,10-11" */
+		static CPUSet ParseCPUList(const achar* list)
+		{
+			CPUSet set;
+			const achar* it = list;
+			while (*it != '\0' && *it != '\n')
+			{
+				achar* end = nullptr;
+				const auto first = (uint32)strtoul(it, &end, 10);
+				if (end == it)
+					break;
+				auto last = first;
+				it = end;
+				if (*it == '-')
+				{
+					last = (uint32)strtoul(it + 1, &end, 10);
+					it = end;
+				}
+				for (auto cpu = first; cpu <= last && cpu < CPUSet::MaxProcessors; ++cpu)
+					set.Set(cpu);
+				if (*it == ',')
+					++it;
+			}
+			return set;
+		}
+
+		static bool ReadCPUList(const achar* path, CPUSet& set)
+		{
+			achar buffer[4096];
+			if (!ReadFileLine(path, buffer, ArraySize(buffer)))
+				return false;
+			set = ParseCPUList(buffer);
+			return true;
+		}
+
+		static void QueryCaches(uint32 cpu, CPUTopology& topology)
+		{
+			achar path[128];
+			for (uint32 index = 0; ; ++index)
+			{
+				uint32 level = 0;
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, index);
+				if (!ReadFileUInt(path, level))
+					break;
+
+				CPUCacheInfo cache;
+				cache.Level = (uint8)level;
+				achar buffer[32];
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/type", cpu, index);
+				if (ReadFileLine(path, buffer, ArraySize(buffer)))
+				{
+					cache.IsInstruction = buffer[0] == 'I' || buffer[0] == 'U';
+					cache.IsData = buffer[0] == 'D' || buffer[0] == 'U';
+				}
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+				if (!ReadCPUList(path, cache.SharedBy))
+					cache.SharedBy = CPUSet::FromProcessor(cpu);
+
+				// Shared caches are reported by every processor that shares them
+				const auto known = std::find_if(topology.Caches.begin(), topology.Caches.end(), [&cache](const CPUCacheInfo& other)
+					{
+						return other.Level == cache.Level && other.IsData == cache.IsData
+							&& other.IsInstruction == cache.IsInstruction && other.SharedBy == cache.SharedBy;
+					});
+				if (known != topology.Caches.end())
+					continue;
+
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/size", cpu, index);
+				if (ReadFileLine(path, buffer, ArraySize(buffer)))
+				{
+					achar* suffix = nullptr;
+					cache.SizeBytes = (uint32)strtoul(buffer, &suffix, 10);
+					if (*suffix == 'K')
+						cache.SizeBytes *= 1024;
+					else if (*suffix == 'M')
+						cache.SizeBytes *= 1024 * 1024;
+				}
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/coherency_line_size", cpu, index);
+				ReadFileUInt(path, cache.LineSize);
+				topology.Caches.push_back(cache);
+			}
+		}
+
+	public:
+		static CPUTopology QueryTopology()
+		{
+			CPUTopology topology;
+
+			CPUSet online;
+			if (!ReadCPUList("/sys/devices/system/cpu/online", online))
+			{
+				const auto count = Min<uint32>((uint32)sysconf(_SC_NPROCESSORS_ONLN), CPUSet::MaxProcessors);
+				for (uint32 i = 0; i < count; ++i)
+					online.Set(i);
+			}
+			topology.LogicalProcessorCount = online.Count();
+
+			for (uint32 node = 0; ; ++node)
+			{
+				achar path[96];
+				snprintf(path, ArraySize(path), "/sys/devices/system/node/node%u/cpulist", node);
+				NUMANodeInfo info;
+				if (!ReadCPUList(path, info.LogicalProcessors))
+				{
+					if (node == 0)
+					{
+						info.LogicalProcessors = online;
+						topology.NUMANodes.push_back(info);
+					}
+					break;
+				}
+				info.ID = node;
+				topology.NUMANodes.push_back(info);
+			}
+
+			Vector<uint32> packages;
+			CPUSet visited;
+			for (uint32 cpu = 0; cpu < CPUSet::MaxProcessors; ++cpu)
+			{
+				if (!online.Test(cpu) || visited.Test(cpu))
+					continue;
+
+				achar path[128];
+				CPUCoreInfo core;
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", cpu);
+				if (!ReadCPUList(path, core.LogicalProcessors))
+					core.LogicalProcessors = CPUSet::FromProcessor(cpu);
+				core.LogicalProcessors &= online;
+				visited |= core.LogicalProcessors;
+
+				snprintf(path, ArraySize(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+				ReadFileUInt(path, core.PackageID);
+				if (std::find(packages.begin(), packages.end(), core.PackageID) == packages.end())
+					packages.push_back(core.PackageID);
+
+				for (const auto& node : topology.NUMANodes)
+				{
+					if (node.LogicalProcessors.Test(cpu))
+					{
+						core.NUMANode = node.ID;
+						break;
+					}
+				}
+
+				QueryCaches(cpu, topology);
+				topology.Cores.push_back(core);
+			}
+			topology.PackageCount = Max<uint32>((uint32)packages.size(), 1);
+			return topology;
+		}
+
+		static bool SetCurrentThreadAffinity(const CPUSet& set)
+		{
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			for (uint32 cpu = 0; cpu < CPUSet::MaxProcessors && cpu < CPU_SETSIZE; ++cpu)
+			{
+				if (set.Test(cpu))
+					CPU_SET(cpu, &cpuSet);
+			}
+			return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+		}
+
+		static bool SetCurrentThreadPriority(ThreadPriority_t priority, ThreadSchedulingPolicy_t policy)
+		{
+			if (policy == ThreadSchedulingPolicy_t::FIFO || policy == ThreadSchedulingPolicy_t::RoundRobin)
+			{
+				const auto nativePolicy = policy == ThreadSchedulingPolicy_t::FIFO ? SCHED_FIFO : SCHED_RR;
+				const auto minPrio = sched_get_priority_min(nativePolicy);
+				const auto maxPrio = sched_get_priority_max(nativePolicy);
+				sched_param param;
+				param.sched_priority = minPrio + ((maxPrio - minPrio) * (int)priority) / ((int)ThreadPriority_t::COUNT - 1);
+				return pthread_setschedparam(pthread_self(), nativePolicy, &param) == 0;
+			}
+
+			sched_param param;
+			param.sched_priority = 0;
+			auto nativePolicy = SCHED_OTHER;
+			if (policy == ThreadSchedulingPolicy_t::Batch)
+				nativePolicy = SCHED_BATCH;
+			else if (policy == ThreadSchedulingPolicy_t::Background)
+				nativePolicy = SCHED_IDLE;
+			if (pthread_setschedparam(pthread_self(), nativePolicy, &param) != 0)
+				return false;
+
+			// Normal policies have no priority, the per-thread nice value is used instead
+			static constexpr int niceValues[ThreadPriority_t::COUNT] = { 19, 10, 5, 0, -5, -10, -20 };
+			return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), niceValues[(sizet)priority]) == 0;
+		}
+
+		static uint32 GetCurrentProcessor()
+		{
+			const auto cpu = sched_getcpu();
+			return cpu < 0 ? 0 : (uint32)cpu;
+		}
+	};
+	using OSCPUInfo = LnxCPUInfo;
+}
+
+#endif /* CORE_LNX_CPU_INFO_H */
\ No newline at end of file
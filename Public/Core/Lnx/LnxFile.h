@@ -0,0 +1,282 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_LNX_FILE_H
+#define CORE_LNX_FILE_H 1
+
+#include "../Base/FileInfo.h"
+#include "../Base/IOVec.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+namespace greaper
+{
+	/** Thin wrapper over the file descriptor syscalls, EINTR is retried and partial transfers continued */
+	class LnxFile
+	{
+		template<bool IsWrite>
+		static ssizet TransferV(int handle, const IOVec* vecs, sizet count)
+		{
+			sizet done = 0;
+			sizet index = 0;
+			sizet consumed = 0; // Bytes of vecs[index] already transferred
+			while (index < count)
+			{
+				ssize_t res;
+				if (consumed > 0)
+				{
+					// Finish the piece cut by a partial transfer before going vectored again
+					auto* data = static_cast<uint8*>(vecs[index].Data) + consumed;
+					const auto size = vecs[index].Size - consumed;
+					if constexpr (IsWrite)
+						res = write(handle, data, size);
+					else
+						res = read(handle, data, size);
+				}
+				else
+				{
+					const auto batch = (int)Min<sizet>(count - index, IOV_MAX);
+					if constexpr (IsWrite)
+						res = writev(handle, ToOSIOVec(vecs + index), batch);
+					else
+						res = readv(handle, ToOSIOVec(vecs + index), batch);
+				}
+				if (res < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				if (res == 0)
+					break;
+				done += (sizet)res;
+
+				auto left = (sizet)res;
+				while (index < count && left >= vecs[index].Size - consumed)
+				{
+					left -= vecs[index].Size - consumed;
+					consumed = 0;
+					++index;
+				}
+				consumed += left;
+			}
+			return (ssizet)done;
+		}
+
+	public:
+		using Handle = int;
+		static constexpr Handle InvalidHandle = -1;
+
+		static Handle Open(const achar* path, bool read, bool write, FileOpenMode_t mode, FileAccessPattern_t pattern)
+		{
+			int flags = O_CLOEXEC;
+			if (read && write)
+				flags |= O_RDWR;
+			else if (write)
+				flags |= O_WRONLY;
+			else
+				flags |= O_RDONLY;
+			if (mode == FileOpenMode_t::OpenOrCreate)
+				flags |= O_CREAT;
+			else if (mode == FileOpenMode_t::CreateOrTruncate)
+				flags |= O_CREAT | O_TRUNC;
+
+			Handle handle;
+			do
+			{
+				handle = open(path, flags, 0644);
+			} while (handle < 0 && errno == EINTR);
+			if (handle >= 0)
+				Advise(handle, pattern);
+			return handle < 0 ? InvalidHandle : handle;
+		}
+
+		static void Close(Handle handle)
+		{
+			if (handle != InvalidHandle)
+				close(handle);
+		}
+
+		/** Reads at the current file offset, returns the bytes read or -1 on error */
+		static ssizet Read(Handle handle, void* buffer, sizet count)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				const auto res = read(handle, static_cast<uint8*>(buffer) + done, count - done);
+				if (res < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				if (res == 0)
+					break;
+				done += (sizet)res;
+			}
+			return (ssizet)done;
+		}
+
+		/** Writes at the current file offset, returns the bytes written or -1 on error */
+		static ssizet Write(Handle handle, const void* buffer, sizet count)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				const auto res = write(handle, static_cast<const uint8*>(buffer) + done, count - done);
+				if (res < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				done += (sizet)res;
+			}
+			return (ssizet)done;
+		}
+
+		/** readv at the current file offset, partial transfers are continued, returns the bytes read or -1 on error */
+		static ssizet ReadV(Handle handle, const IOVec* vecs, sizet count)
+		{
+			return TransferV<false>(handle, vecs, count);
+		}
+
+		/** writev at the current file offset, partial transfers are continued, returns the bytes written or -1 on error */
+		static ssizet WriteV(Handle handle, const IOVec* vecs, sizet count)
+		{
+			return TransferV<true>(handle, vecs, count);
+		}
+
+		/** Reads at the given offset without moving the file offset, returns the bytes read or -1 on error */
+		static ssizet ReadAt(Handle handle, void* buffer, sizet count, int64 offset)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				const auto res = pread(handle, static_cast<uint8*>(buffer) + done, count - done, (off_t)(offset + (int64)done));
+				if (res < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				if (res == 0)
+					break;
+				done += (sizet)res;
+			}
+			return (ssizet)done;
+		}
+
+		/** Writes at the given offset without moving the file offset, returns the bytes written or -1 on error */
+		static ssizet WriteAt(Handle handle, const void* buffer, sizet count, int64 offset)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				const auto res = pwrite(handle, static_cast<const uint8*>(buffer) + done, count - done, (off_t)(offset + (int64)done));
+				if (res < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				done += (sizet)res;
+			}
+			return (ssizet)done;
+		}
+
+		/** Returns the new offset or -1 on error */
+		static int64 Seek(Handle handle, int64 offset)
+		{
+			return (int64)lseek(handle, (off_t)offset, SEEK_SET);
+		}
+
+		static int64 GetSize(Handle handle)
+		{
+			struct stat info;
+			if (fstat(handle, &info) != 0)
+				return -1;
+			return (int64)info.st_size;
+		}
+
+		static void Advise(Handle handle, FileAccessPattern_t pattern, int64 offset = 0, int64 length = 0)
+		{
+			int advice = POSIX_FADV_NORMAL;
+			if (pattern == FileAccessPattern_t::Sequential)
+				advice = POSIX_FADV_SEQUENTIAL;
+			else if (pattern == FileAccessPattern_t::Random)
+				advice = POSIX_FADV_RANDOM;
+			posix_fadvise(handle, (off_t)offset, (off_t)length, advice);
+		}
+
+		/** Forces the written data to the device */
+		static bool Sync(Handle handle)
+		{
+			return fdatasync(handle) == 0;
+		}
+
+		/** Grows or shrinks the file, new bytes read as zero */
+		static bool Resize(Handle handle, int64 size)
+		{
+			int res;
+			do
+			{
+				res = ftruncate(handle, (off_t)size);
+			} while (res != 0 && errno == EINTR);
+			return res == 0;
+		}
+
+		/** Map offsets must be a multiple of this */
+		static sizet GetMapGranularity()
+		{
+			return (sizet)sysconf(_SC_PAGESIZE);
+		}
+
+		/** Maps the given range of the file shared, returns nullptr on failure */
+		static void* Map(Handle handle, int64 offset, sizet size, bool write, bool populate)
+		{
+			int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+			if (populate)
+				flags |= MAP_POPULATE;
+#else
+			UNUSED(populate);
+#endif
+			const int protection = write ? PROT_READ | PROT_WRITE : PROT_READ;
+			void* address = mmap(nullptr, size, protection, flags, handle, (off_t)offset);
+			return address == MAP_FAILED ? nullptr : address;
+		}
+
+		static void Unmap(void* address, sizet size)
+		{
+			if (address != nullptr)
+				munmap(address, size);
+		}
+
+		/** madvise counterpart of Advise, willNeed starts reading the range in the background */
+		static void AdviseMap(void* address, sizet size, FileAccessPattern_t pattern, bool willNeed)
+		{
+			int advice = MADV_NORMAL;
+			if (pattern == FileAccessPattern_t::Sequential)
+				advice = MADV_SEQUENTIAL;
+			else if (pattern == FileAccessPattern_t::Random)
+				advice = MADV_RANDOM;
+			madvise(address, size, advice);
+			if (willNeed)
+				madvise(address, size, MADV_WILLNEED);
+		}
+
+		/** Starts writing the dirty pages of the range back to the file */
+		static bool FlushMap(void* address, sizet size)
+		{
+			return msync(address, size, MS_ASYNC) == 0;
+		}
+	};
+	using OSFile = LnxFile;
+}
+
+#endif /* CORE_LNX_FILE_H */
\ No newline at end of file
@@ -0,0 +1,239 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_LNX_IO_URING_H
+#define CORE_LNX_IO_URING_H 1
+
+#include "../Memory.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+namespace greaper
+{
+	/**
+	 * Minimal io_uring ring driven through the raw syscalls. The submission side
+	 * must be serialized by the caller, the completion side has a single consumer,
+	 * both sides may run concurrently on different threads.
+	 */
+	class LnxIOUring
+	{
+		int m_Fd = -1;
+		uint8* m_SQRing = nullptr;
+		sizet m_SQRingSize = 0;
+		uint8* m_CQRing = nullptr;
+		sizet m_CQRingSize = 0;
+		io_uring_sqe* m_SQEs = nullptr;
+		sizet m_SQEsSize = 0;
+
+		uint32* m_SQHead = nullptr;
+		uint32* m_SQTail = nullptr;
+		uint32* m_SQArray = nullptr;
+		uint32 m_SQMask = 0;
+		uint32 m_SQEntries = 0;
+		uint32 m_SQLocalTail = 0; // Filled entries, published on Submit
+
+		uint32* m_CQHead = nullptr;
+		uint32* m_CQTail = nullptr;
+		io_uring_cqe* m_CQEs = nullptr;
+		uint32 m_CQMask = 0;
+		uint32 m_CQEntries = 0;
+
+		INLINE int Enter(uint32 toSubmit, uint32 minComplete, uint32 flags)noexcept
+		{
+			int res;
+			do
+			{
+				res = (int)syscall(__NR_io_uring_enter, m_Fd, toSubmit, minComplete, flags, nullptr, 0);
+			} while (res < 0 && errno == EINTR);
+			return res < 0 ? -errno : res;
+		}
+
+	public:
+		LnxIOUring() noexcept = default;
+
+		LnxIOUring(const LnxIOUring&) = delete;
+		LnxIOUring& operator=(const LnxIOUring&) = delete;
+
+		~LnxIOUring()
+		{
+			Shutdown();
+		}
+
+		/** Returns false if the kernel doesn't support io_uring or it has been disabled */
+		bool Initialize(uint32 entries)noexcept
+		{
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+			m_Fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+			if (m_Fd < 0)
+			{
+				m_Fd = -1;
+				return false;
+			}
+
+			m_SQRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+			m_CQRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMap)
+				m_SQRingSize = m_CQRingSize = Max(m_SQRingSize, m_CQRingSize);
+
+			void* sqRing = mmap(nullptr, m_SQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+			if (sqRing == MAP_FAILED)
+			{
+				Shutdown();
+				return false;
+			}
+			m_SQRing = (uint8*)sqRing;
+			if (singleMap)
+			{
+				m_CQRing = m_SQRing;
+			}
+			else
+			{
+				void* cqRing = mmap(nullptr, m_CQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+				if (cqRing == MAP_FAILED)
+				{
+					Shutdown();
+					return false;
+				}
+				m_CQRing = (uint8*)cqRing;
+			}
+			m_SQEsSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, m_SQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED)
+			{
+				Shutdown();
+				return false;
+			}
+			m_SQEs = (io_uring_sqe*)sqes;
+
+			m_SQHead = (uint32*)(m_SQRing + params.sq_off.head);
+			m_SQTail = (uint32*)(m_SQRing + params.sq_off.tail);
+			m_SQArray = (uint32*)(m_SQRing + params.sq_off.array);
+			m_SQMask = *(uint32*)(m_SQRing + params.sq_off.ring_mask);
+			m_SQEntries = params.sq_entries;
+			m_SQLocalTail = *m_SQTail;
+
+			m_CQHead = (uint32*)(m_CQRing + params.cq_off.head);
+			m_CQTail = (uint32*)(m_CQRing + params.cq_off.tail);
+			m_CQEs = (io_uring_cqe*)(m_CQRing + params.cq_off.cqes);
+			m_CQMask = *(uint32*)(m_CQRing + params.cq_off.ring_mask);
+			m_CQEntries = params.cq_entries;
+			return true;
+		}
+
+		void Shutdown()noexcept
+		{
+			if (m_SQEs != nullptr)
+				munmap(m_SQEs, m_SQEsSize);
+			if (m_CQRing != nullptr && m_CQRing != m_SQRing)
+				munmap(m_CQRing, m_CQRingSize);
+			if (m_SQRing != nullptr)
+				munmap(m_SQRing, m_SQRingSize);
+			if (m_Fd >= 0)
+				close(m_Fd);
+			m_Fd = -1;
+			m_SQRing = m_CQRing = nullptr;
+			m_SQEs = nullptr;
+		}
+
+		[[nodiscard]] INLINE bool IsValid()const noexcept { return m_Fd >= 0; }
+
+		/** Completions the ring can hold, more requests in flight make the kernel refuse submissions */
+		[[nodiscard]] INLINE uint32 GetCQEntries()const noexcept { return m_CQEntries; }
+
+		/** Pins the given blocks once, so READ_FIXED/WRITE_FIXED can refer to them by index */
+		bool RegisterBuffers(uint8* memory, sizet blockSize, uint32 blockCount)noexcept
+		{
+			if (blockCount == 0)
+				return false;
+			Vector<iovec> iovecs(blockCount);
+			for (uint32 i = 0; i < blockCount; ++i)
+			{
+				iovecs[i].iov_base = memory + i * blockSize;
+				iovecs[i].iov_len = blockSize;
+			}
+			return syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_BUFFERS, iovecs.data(), blockCount) == 0;
+		}
+
+		/** Returns a cleared entry to fill, or nullptr if the submission queue is full */
+		[[nodiscard]] io_uring_sqe* GetSQE()noexcept
+		{
+			const auto head = __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+			if (m_SQLocalTail - head >= m_SQEntries)
+				return nullptr;
+			const auto index = m_SQLocalTail & m_SQMask;
+			auto* sqe = &m_SQEs[index];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			m_SQArray[index] = index;
+			++m_SQLocalTail;
+			return sqe;
+		}
+
+		/** Hands all the pending entries to the kernel with one syscall, returns the amount submitted or -errno */
+		int Submit()noexcept
+		{
+			// Entries left by a partial submission are handed again
+			const auto toSubmit = m_SQLocalTail - __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+			if (toSubmit == 0)
+				return 0;
+			__atomic_store_n(m_SQTail, m_SQLocalTail, __ATOMIC_RELEASE);
+			return Enter(toSubmit, 0, 0);
+		}
+
+		[[nodiscard]] INLINE uint32 GetUnsubmittedCount()const noexcept
+		{
+			return m_SQLocalTail - __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+		}
+
+		/**
+		 * Takes back the entries the kernel didn't consume on the last Submit and
+		 * calls func(userData) for each of them. The ring is not created with
+		 * SQPOLL, so the kernel only reads the queue inside Submit.
+		 */
+		template<class F>
+		uint32 RetractUnsubmitted(F&& func)
+		{
+			const auto head = __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+			for (auto i = head; i != m_SQLocalTail; ++i)
+				func(m_SQEs[m_SQArray[i & m_SQMask]].user_data);
+			const auto retracted = m_SQLocalTail - head;
+			m_SQLocalTail = head;
+			__atomic_store_n(m_SQTail, head, __ATOMIC_RELEASE);
+			return retracted;
+		}
+
+		/** Blocks until at least one completion is available */
+		int WaitCompletion()noexcept
+		{
+			return Enter(0, 1, IORING_ENTER_GETEVENTS);
+		}
+
+		/** Calls func(userData, result) for each available completion, returns the amount processed */
+		template<class F>
+		uint32 ProcessCompletions(F&& func)
+		{
+			auto head = *m_CQHead;
+			const auto tail = __atomic_load_n(m_CQTail, __ATOMIC_ACQUIRE);
+			uint32 processed = 0;
+			while (head != tail)
+			{
+				const auto& cqe = m_CQEs[head & m_CQMask];
+				const auto userData = cqe.user_data;
+				const auto result = cqe.res;
+				++head;
+				__atomic_store_n(m_CQHead, head, __ATOMIC_RELEASE);
+				func(userData, result);
+				++processed;
+			}
+			return processed;
+		}
+	};
+}
+
+#endif /* CORE_LNX_IO_URING_H */
\ No newline at end of file
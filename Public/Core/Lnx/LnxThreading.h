@@ -38,6 +38,11 @@ namespace greaper
 		::pthread_yield();
 	}
 
+	INLINE void CPU_PAUSE() noexcept
+	{
+		_mm_pause();
+	}
+
     namespace Impl
     {
         struct LnxMutexImpl
@@ -246,6 +251,32 @@ namespace greaper
 			}
 		};
 		using SignalImpl = LnxSignalImpl;
+
+		struct LnxWaitOnAddressImpl
+		{
+			static bool Wait(volatile uint32* address, uint32 compareValue, uint32 millis) noexcept
+			{
+				timespec timeout;
+				timespec* timeoutPtr = nullptr;
+				if (millis != static_cast<uint32>(-1))
+				{
+					timeout.tv_sec = millis / 1000;
+					timeout.tv_nsec = (millis % 1000) * 1000000;
+					timeoutPtr = &timeout;
+				}
+				const auto res = ::syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, compareValue, timeoutPtr, nullptr, 0);
+				return res == 0 || errno != ETIMEDOUT;
+			}
+			static void WakeOne(volatile uint32* address) noexcept
+			{
+				::syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+			}
+			static void WakeAll(volatile uint32* address) noexcept
+			{
+				::syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+			}
+		};
+		using WaitOnAddressImpl = LnxWaitOnAddressImpl;
     }
 }
 
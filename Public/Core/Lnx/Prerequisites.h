@@ -12,6 +12,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <uuid/uuid.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <immintrin.h>
 
 struct LnxTypes : BasicTypes
 {
@@ -28,6 +34,7 @@ typedef LnxTypes PlatformTypes;
 #define FUNCTION_NO_RETURN_START 
 #define FUNCTION_NO_RETURN_END __attribute__((noreturn))
 #define TRIGGER_BREAKPOINT() __asm__ volatile("int $0x03")
+#define TARGET_ISA(isa) __attribute__((target(isa)))
 
 #define DLLIMPORT __attribute__((visibility("default")))
 #define DLLEXPORT __attribute__((visibility("default")))
@@ -0,0 +1,156 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_MMAP_STREAM_H
+#define CORE_MMAP_STREAM_H 1
+
+#include "Stream.h"
+
+#if PLT_WINDOWS
+#include "Win/WinFile.h"
+#else
+#include "Lnx/LnxFile.h"
+#endif
+
+namespace greaper
+{
+	struct MMapStreamConfig
+	{
+		sizet WindowSize = 0; // 0 maps the whole file, otherwise the bytes mapped at once
+		sizet GrowthSize = 16 * 1024 * 1024; // Minimum step a writable file is grown by
+		FileAccessPattern_t AccessPattern = FileAccessPattern_t::Sequential;
+		FileOpenMode_t OpenMode = FileOpenMode_t::OpenExisting;
+		bool WillNeed = false; // Start reading each mapped range in the background
+		bool Populate = false; // Prefault each mapped range, Linux only
+	};
+
+	/**
+	 * Stream over a memory mapped file. GetData and GetCursor point straight into
+	 * the mapping so deserializers can read in place. Big files can be mapped by
+	 * windows of WindowSize bytes, which are moved when the cursor leaves them,
+	 * so GetData is then relative to GetWindowOffset. Writable streams grow the
+	 * file geometrically and trim it back to the written size on Close.
+	 * The class is final so ReadArray and WriteArray resolve to the inlined
+	 * versions below whenever the stream type is known.
+	 */
+	class MMapStream final : public IStream
+	{
+	private:
+		MMapStreamConfig m_Config;
+		OSFile::Handle m_Handle;
+		mutable uint8* m_View;
+		mutable sizet m_ViewSize;
+		mutable int64 m_ViewOffset; // File offset of m_View[0]
+		mutable int64 m_Position;
+		int64 m_FileSize; // Bigger than m_Size while a writable stream grows
+		sizet m_WindowSize;
+		bool m_Grown; // Only the stream that grew the file trims it back on Close
+		bool m_ReservedInPlace; // The last WriteReserve pointed into the mapping
+
+		/** Makes sure that the given offset is mapped, remapping the window if needed */
+		bool MapOffset(int64 offset)const;
+
+		void Unmap()const;
+
+		bool Grow(int64 size);
+
+	public:
+		MMapStream(StringView path, uint16 accessMode = READ, const MMapStreamConfig& config = MMapStreamConfig{});
+
+		MMapStream(const MMapStream&) = delete;
+		MMapStream& operator=(const MMapStream&) = delete;
+
+		~MMapStream();
+
+		INLINE bool IsFile()const noexcept override { return true; }
+
+		[[nodiscard]] INLINE bool IsOpen()const noexcept { return m_Handle != OSFile::InvalidHandle; }
+
+		/** Start of the mapped window, nullptr if nothing is mapped yet */
+		uint8* GetData()const { return m_View; }
+
+		/** Current position inside the mapping, maps its window if needed */
+		uint8* GetCursor()const;
+
+		/** Bytes that can be accessed from GetCursor without moving the window */
+		[[nodiscard]] sizet GetContiguousSize()const;
+
+		[[nodiscard]] INLINE int64 GetWindowOffset()const noexcept { return m_ViewOffset; }
+
+		[[nodiscard]] INLINE sizet GetWindowSize()const noexcept { return m_ViewSize; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** Copies straight from the mapping, falls back to Read when the values cross the window */
+		template<typename T>
+		INLINE sizet ReadArray(T* data, sizet count)const
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "ReadArray can only copy trivially copyable types.");
+			const auto bytes = (int64)(count * sizeof(T));
+			const auto offset = m_Position - m_ViewOffset;
+			if (m_View == nullptr || !IsReadable() || bytes == 0 || offset < 0
+				|| offset + bytes > (int64)m_ViewSize || m_Position + bytes > (int64)m_Size)
+				return IStream::ReadArray(data, count);
+			memcpy(data, m_View + offset, (sizet)bytes);
+			m_Position += bytes;
+			return count;
+		}
+
+		/** Copies straight into the mapping, falls back to Write when the values cross the window */
+		template<typename T>
+		INLINE sizet WriteArray(const T* data, sizet count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "WriteArray can only copy trivially copyable types.");
+			const auto bytes = (int64)(count * sizeof(T));
+			const auto offset = m_Position - m_ViewOffset;
+			if (m_View == nullptr || !IsWritable() || bytes == 0 || offset < 0 || offset + bytes > (int64)m_ViewSize)
+				return IStream::WriteArray(data, count);
+			memcpy(m_View + offset, data, (sizet)bytes);
+			m_Position += bytes;
+			m_Size = Max(m_Size, (ssizet)m_Position);
+			return count;
+		}
+
+		/** Points into the mapping unless the bytes cross the end of the window */
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Grows the file like Write, points into the mapping unless the bytes cross the end of the window */
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
+		void Skip(ssizet count) override;
+
+		void Seek(ssizet pos) override;
+
+		ssizet Tell()const override { return (ssizet)m_Position; }
+
+		bool Eof()const override { return m_Position >= m_Size; }
+
+		/**
+		 * Maps the same file again at the same position, data is never copied.
+		 * The clone is always read-only, so it can't resize the file under the
+		 * mapping of this stream.
+		 */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		/** Hands the written pages to the OS, syncDevice also waits for the device */
+		bool Flush(bool syncDevice = false);
+
+		void SetAccessPattern(FileAccessPattern_t pattern);
+
+		[[nodiscard]] INLINE const MMapStreamConfig& GetConfig()const noexcept { return m_Config; }
+	};
+}
+
+#include "Base/MMapStream.inl"
+
+#endif /* CORE_MMAP_STREAM_H */
\ No newline at end of file
@@ -12,21 +12,46 @@
 
 namespace greaper
 {
-	class MemoryStream : public IStream
+	/**
+	 * Stream over a memory buffer. Size is the amount of data written, the
+	 * buffer capacity grows geometrically so appending is amortized O(1),
+	 * Reserve avoids the reallocations when the final size is known.
+	 * The class is final so ReadArray and WriteArray resolve to the inlined
+	 * versions below whenever the stream type is known.
+	 */
+	class MemoryStream final : public IStream
 	{
-	protected:
+	private:
+		using AllocateFn = void*(*)(sizet);
+		using DeallocateFn = void(*)(void*);
+
+		static constexpr sizet MinimumCapacity = 64;
+
 		uint8* m_Data;
 		mutable uint8* m_Cursor;
 		uint8* m_End;
+		sizet m_Capacity;
 		bool m_OwnsMemory;
+		AllocateFn m_Allocate;
+		DeallocateFn m_Deallocate;
 
+		/** Moves the data to a buffer of bytes capacity, which must fit it */
 		void Realloc(sizet bytes);
 
+		/** Makes room for count bytes at the cursor, returns how many of them fit */
+		sizet PrepareWrite(sizet count);
+
 	public:
 		MemoryStream();
 
+		/** Creates an empty stream with capacity bytes already reserved */
 		MemoryStream(sizet capacity);
 
+		/** Same, but the buffer is requested to the allocator tagged by _Alloc_ */
+		template<class _Alloc_>
+		MemoryStream(sizet capacity, _Alloc_ allocatorTag);
+
+		/** Wraps memory without owning it, writes cannot go past size */
 		MemoryStream(void* memory, sizet size);
 
 		MemoryStream(const MemoryStream& other);
@@ -42,10 +67,62 @@ namespace greaper
 
 		uint8* GetCursor()const { return m_Cursor; }
 
+		[[nodiscard]] sizet GetCapacity()const noexcept { return m_Capacity; }
+
+		/** Makes sure bytes fit without reallocating */
+		void Reserve(sizet bytes);
+
+		/** Drops the unused capacity */
+		void ShrinkToFit();
+
 		ssizet Read(void* buf, ssizet count)const override;
 
 		ssizet Write(const void* buf, ssizet count) override;
 
+		/** Copies straight from the buffer, only falls back to Read at its end */
+		template<typename T>
+		INLINE sizet ReadArray(T* data, sizet count)const
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "ReadArray can only copy trivially copyable types.");
+			const auto bytes = count * sizeof(T);
+			if (!IsReadable() || bytes == 0 || bytes > (sizet)(m_End - m_Cursor))
+				return IStream::ReadArray(data, count);
+			memcpy(data, m_Cursor, bytes);
+			m_Cursor += bytes;
+			return count;
+		}
+
+		/** Copies straight into the buffer, only falls back to Write when it has to grow */
+		template<typename T>
+		INLINE sizet WriteArray(const T* data, sizet count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "WriteArray can only copy trivially copyable types.");
+			const auto bytes = count * sizeof(T);
+			if (!IsWritable() || bytes == 0 || bytes > (sizet)(m_Data + m_Capacity - m_Cursor))
+				return IStream::WriteArray(data, count);
+			memcpy(m_Cursor, data, bytes);
+			m_Cursor += bytes;
+			if (m_Cursor > m_End)
+			{
+				m_End = m_Cursor;
+				m_Size = m_End - m_Data;
+			}
+			return count;
+		}
+
+		ssizet ReadV(std::span<const IOVec> vecs)const override;
+
+		/** Grows the buffer once for all the pieces */
+		ssizet WriteV(std::span<const IOVec> vecs) override;
+
+		/** Points into the buffer, nothing is copied */
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Points into the buffer, which grows like on Write */
+		std::span<uint8> WriteReserve(sizet count) override;
+
+		void WriteCommit(sizet count) override;
+
 		void Skip(ssizet count) override;
 
 		void Seek(ssizet pos) override;
@@ -60,6 +137,22 @@ namespace greaper
 
 		uint8* DisownMemory();
 	};
+
+	template<class _Alloc_>
+	MemoryStream::MemoryStream(const sizet capacity, _Alloc_ allocatorTag)
+		:IStream(READ | WRITE)
+		,m_Data(nullptr)
+		,m_Cursor(nullptr)
+		,m_End(nullptr)
+		,m_Capacity(0)
+		,m_OwnsMemory(true)
+		,m_Allocate(&MemoryAllocator<_Alloc_>::Allocate)
+		,m_Deallocate(&MemoryAllocator<_Alloc_>::Deallocate)
+	{
+		UNUSED(allocatorTag);
+		m_Size = 0;
+		Reserve(capacity);
+	}
 }
 
 #include "Base/MemoryStream.inl"
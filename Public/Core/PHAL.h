@@ -260,6 +260,10 @@
 #ifndef NOINLINE
 #define NOINLINE
 #endif
+/* Lets a function use instruction set extensions the build doesn't enable, callers check the CPU has them first */
+#ifndef TARGET_ISA
+#define TARGET_ISA(isa)
+#endif
 /* Indicate that the function never returns. */
 #ifndef FUNCTION_NO_RETURN_START
 #define FUNCTION_NO_RETURN_START
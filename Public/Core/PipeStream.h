@@ -0,0 +1,185 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_PIPE_STREAM_H
+#define CORE_PIPE_STREAM_H 1
+
+#include "Stream.h"
+#include "Concurrency.h"
+
+namespace greaper
+{
+	struct PipeStreamConfig
+	{
+		sizet Capacity = 1024 * 1024; // Rounded up to a power of two
+		sizet WakeThreshold = 0; // Bytes that have to be ready before a parked end is woken, 0 uses a quarter of the capacity, at most half
+	};
+
+	namespace Impl
+	{
+		/**
+		 * Single producer single consumer byte ring shared by the two ends of a pipe.
+		 * Head and Tail only grow, so Tail - Head is the amount of data and each end
+		 * only stores to its own counter. An end that has to wait spins for a while
+		 * and then parks on its Seq word, advertising in Need how many bytes would be
+		 * worth waking it for, so the other end only calls into the OS once a batch
+		 * is ready.
+		 */
+		struct PipeRing
+		{
+			static constexpr uint32 SpinCount = 1000;
+
+			alignas(CACHE_LINE_SIZE) std::atomic<uint64> Head; // Bytes consumed by the reader
+			std::atomic<uint64> ReaderNeed; // 0 while the reader isn't parked
+			std::atomic<uint32> ReaderSeq;
+			std::atomic<bool> ReaderClosed;
+			alignas(CACHE_LINE_SIZE) std::atomic<uint64> Tail; // Bytes produced by the writer
+			std::atomic<uint64> WriterNeed; // 0 while the writer isn't parked
+			std::atomic<uint32> WriterSeq;
+			std::atomic<bool> WriterClosed;
+			alignas(CACHE_LINE_SIZE) uint8* Data;
+			sizet Capacity;
+			sizet WakeThreshold;
+
+			explicit PipeRing(const PipeStreamConfig& config);
+
+			PipeRing(const PipeRing&) = delete;
+			PipeRing& operator=(const PipeRing&) = delete;
+
+			~PipeRing();
+
+			/** Parks until woken if fewer than need bytes can be read, returns straight away once the writer closed */
+			void WaitForData(uint64 head, sizet need);
+
+			/** Parks until woken if fewer than need bytes can be written, returns straight away once the reader closed */
+			void WaitForSpace(uint64 tail, sizet need);
+
+			/** Called by the writer after moving Tail, force wakes a parked reader even if its batch isn't ready */
+			void WakeReader(uint64 tail, bool force);
+
+			/** Called by the reader after moving Head */
+			void WakeWriter(uint64 head);
+
+			void CopyIn(uint64 position, const uint8* src, sizet size);
+
+			void CopyOut(uint64 position, uint8* dst, sizet size)const;
+		};
+	}
+
+	/**
+	 * Writing end of a pipe. Write blocks while the ring is full and returns
+	 * fewer bytes only once the reader closed. Data is published to the reader
+	 * on every Write, but a parked reader is only woken once its batch is ready,
+	 * Flush wakes it for whatever is there. Closing marks the end of the data.
+	 */
+	class PipeWriterStream : public IStream
+	{
+	protected:
+		SPtr<Impl::PipeRing> m_Ring;
+
+	public:
+		explicit PipeWriterStream(SPtr<Impl::PipeRing> ring);
+
+		PipeWriterStream(const PipeWriterStream&) = delete;
+		PipeWriterStream& operator=(const PipeWriterStream&) = delete;
+
+		~PipeWriterStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		/** Pipes can only move forward, skipping on the writing end is not supported */
+		void Skip(ssizet count) override;
+
+		void Seek(ssizet pos) override;
+
+		/** Bytes written so far */
+		ssizet Tell()const override { return m_Size; }
+
+		/** True once the reader closed, nothing else can be written */
+		bool Eof()const override;
+
+		/** Pipe ends can't be cloned, returns nullptr */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+
+		/** Wakes a parked reader for whatever is already in the ring */
+		void Flush();
+	};
+
+	/**
+	 * Reading end of a pipe. Read blocks until count bytes arrived and returns
+	 * fewer only once the writer closed. ReadView points straight into the ring
+	 * when the bytes don't wrap around it, holding them until the next call.
+	 * The amount of data isn't known up front, so Size stays at zero.
+	 */
+	class PipeReaderStream : public IStream
+	{
+	protected:
+		SPtr<Impl::PipeRing> m_Ring;
+		mutable ssizet m_Position;
+		mutable sizet m_Held; // Bytes of the last ReadView still owned by the reader
+
+		sizet Consume(uint8* dst, sizet count)const;
+
+		void ReleaseView()const;
+
+	public:
+		explicit PipeReaderStream(SPtr<Impl::PipeRing> ring);
+
+		PipeReaderStream(const PipeReaderStream&) = delete;
+		PipeReaderStream& operator=(const PipeReaderStream&) = delete;
+
+		~PipeReaderStream();
+
+		INLINE bool IsFile()const noexcept override { return false; }
+
+		ssizet Read(void* buf, ssizet count)const override;
+
+		ssizet Write(const void* buf, ssizet count) override;
+
+		std::span<const uint8> ReadView(sizet count)const override;
+
+		/** Drops the next count bytes, blocking like Read */
+		void Skip(ssizet count) override;
+
+		/** Only forward, same as skipping to pos */
+		void Seek(ssizet pos) override;
+
+		/** Bytes consumed so far */
+		ssizet Tell()const override { return m_Position; }
+
+		/** True once the writer closed and everything it wrote was consumed */
+		bool Eof()const override;
+
+		/** Pipe ends can't be cloned, returns nullptr */
+		SPtr<IStream> Clone(bool copyData = true)const override;
+
+		void Close() override;
+	};
+
+	struct PipeStreamPair
+	{
+		SPtr<PipeWriterStream> Writer;
+		SPtr<PipeReaderStream> Reader;
+	};
+
+	/**
+	 * Creates the two ends of a bounded pipe, so a thread can serialize into the
+	 * writer while another one consumes the reader with constant memory. Each end
+	 * must only be used by one thread at a time.
+	 */
+	PipeStreamPair CreatePipeStream(const PipeStreamConfig& config = PipeStreamConfig{});
+}
+
+#include "Base/PipeStream.inl"
+
+#endif /* CORE_PIPE_STREAM_H */
\ No newline at end of file
@@ -0,0 +1,645 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_RECLAMATION_H
+#define CORE_RECLAMATION_H 1
+
+#include "Concurrency.h"
+#include <algorithm>
+
+namespace greaper
+{
+	/**
+	 * @brief Deferred deletion of nodes unlinked from lock-free structures
+	 *
+	 * Two domains are provided, EpochDomain (EBR) is the cheapest for readers,
+	 * entering and exiting a critical region are a couple of thread-local stores,
+	 * but a stalled reader blocks all reclamation. HazardPointerDomain bounds the
+	 * amount of unreclaimed memory at the cost of a fence on every Protect.
+	 * Threads register themselves lazily the first time they touch a domain, and
+	 * threads created through IThreadManager::CreateThread are registered for
+	 * their whole life to the default domains (see ThreadConfig).
+	 */
+	struct RetiredPointer
+	{
+		void* Pointer;
+		void(*Deleter)(void*);
+	};
+
+	template<class T, class _Alloc_ = GenericAllocator>
+	void DestroyRetired(void* ptr)
+	{
+		Destroy<T, _Alloc_>(static_cast<T*>(ptr));
+	}
+
+	namespace Impl
+	{
+		/**
+		 * IDs of the domains alive, they are never reused so a domain created
+		 * where a destroyed one was isn't mistaken for it. Exiting threads only
+		 * unregister from the domains still here, holding the lock so they can't
+		 * be destroyed meanwhile, it is recursive because the deleters run there.
+		 */
+		struct ReclamationDomainRegistry
+		{
+			RecursiveMutex Guard;
+			Vector<uint64> LiveIDs;
+			uint64 LastID = 0;
+
+			INLINE bool IsLive(uint64 id)const noexcept
+			{
+				return std::find(LiveIDs.begin(), LiveIDs.end(), id) != LiveIDs.end();
+			}
+		};
+
+		INLINE ReclamationDomainRegistry& GetReclamationDomainRegistry() noexcept
+		{
+			static ReclamationDomainRegistry registry;
+			return registry;
+		}
+	}
+
+	class IReclamationDomain
+	{
+	protected:
+		uint64 m_DomainID;
+
+		/** Must be the first thing the domain destructors do, threads exiting afterwards leave the domain alone */
+		void ReleaseDomainID() noexcept
+		{
+			auto& registry = Impl::GetReclamationDomainRegistry();
+			auto lck = Lock<RecursiveMutex>(registry.Guard);
+			registry.LiveIDs.erase(std::remove(registry.LiveIDs.begin(), registry.LiveIDs.end(), m_DomainID), registry.LiveIDs.end());
+		}
+
+	public:
+		IReclamationDomain() noexcept
+		{
+			auto& registry = Impl::GetReclamationDomainRegistry();
+			auto lck = Lock<RecursiveMutex>(registry.Guard);
+			m_DomainID = ++registry.LastID;
+			registry.LiveIDs.push_back(m_DomainID);
+		}
+		virtual ~IReclamationDomain() = default;
+
+		[[nodiscard]] INLINE uint64 GetDomainID()const noexcept { return m_DomainID; }
+
+		virtual void RegisterThread() = 0;
+
+		virtual void UnregisterThread() = 0;
+	};
+
+	namespace Impl
+	{
+		/** Per thread record of each domain it is registered to, keyed by domain ID */
+		struct ReclamationThreadSlots
+		{
+			static constexpr sizet MaxDomains = 8;
+			uint64 IDs[MaxDomains] = {};
+			IReclamationDomain* Domains[MaxDomains] = {};
+			void* Records[MaxDomains] = {};
+
+			~ReclamationThreadSlots()
+			{
+				auto& registry = GetReclamationDomainRegistry();
+				auto lck = Lock<RecursiveMutex>(registry.Guard);
+				for (sizet i = 0; i < MaxDomains; ++i)
+				{
+					if (IDs[i] != 0 && registry.IsLive(IDs[i]))
+						Domains[i]->UnregisterThread();
+				}
+			}
+
+			INLINE void* Find(uint64 domainID)const noexcept
+			{
+				for (sizet i = 0; i < MaxDomains; ++i)
+				{
+					if (IDs[i] == domainID)
+						return Records[i];
+				}
+				return nullptr;
+			}
+
+			INLINE void Add(IReclamationDomain* domain, void* record) noexcept
+			{
+				for (sizet pass = 0; pass < 2; ++pass)
+				{
+					for (sizet i = 0; i < MaxDomains; ++i)
+					{
+						if (IDs[i] == 0)
+						{
+							IDs[i] = domain->GetDomainID();
+							Domains[i] = domain;
+							Records[i] = record;
+							return;
+						}
+					}
+					// Drop the slots of the domains destroyed since, their records are gone with them
+					auto& registry = GetReclamationDomainRegistry();
+					auto lck = Lock<RecursiveMutex>(registry.Guard);
+					for (sizet i = 0; i < MaxDomains; ++i)
+					{
+						if (IDs[i] != 0 && !registry.IsLive(IDs[i]))
+							Remove(IDs[i]);
+					}
+				}
+				Break("Trying to register a thread into more than %lld reclamation domains.", MaxDomains);
+			}
+
+			INLINE void Remove(uint64 domainID) noexcept
+			{
+				for (sizet i = 0; i < MaxDomains; ++i)
+				{
+					if (IDs[i] == domainID)
+					{
+						IDs[i] = 0;
+						Domains[i] = nullptr;
+						Records[i] = nullptr;
+						return;
+					}
+				}
+			}
+		};
+
+		INLINE ReclamationThreadSlots& GetReclamationThreadSlots() noexcept
+		{
+			static thread_local ReclamationThreadSlots slots;
+			return slots;
+		}
+
+		INLINE void DeleteRetired(Vector<RetiredPointer>& retired) noexcept
+		{
+			for (const auto& r : retired)
+				r.Deleter(r.Pointer);
+			retired.clear();
+		}
+
+		/** Gets a free record from an intrusive push-only list, or pushes a new one */
+		template<class Record>
+		INLINE Record* AcquireRecord(std::atomic<Record*>& head) noexcept
+		{
+			for (auto* rec = head.load(std::memory_order_acquire); rec != nullptr; rec = rec->Next)
+			{
+				bool inUse = false;
+				if (!rec->InUse.load(std::memory_order_relaxed) && rec->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+					return rec;
+			}
+			// Records are cache line aligned, so they can't go through Construct
+			void* mem = MemoryAllocator<GenericAllocator>::AllocateAligned(sizeof(Record), alignof(Record));
+			auto* rec = new(mem)Record();
+			rec->InUse.store(true, std::memory_order_relaxed);
+			auto* oldHead = head.load(std::memory_order_relaxed);
+			do
+			{
+				rec->Next = oldHead;
+			} while (!head.compare_exchange_weak(oldHead, rec, std::memory_order_release, std::memory_order_relaxed));
+			return rec;
+		}
+
+		template<class Record>
+		INLINE void DestroyRecord(Record* rec) noexcept
+		{
+			rec->~Record();
+			MemoryAllocator<GenericAllocator>::DeallocateAligned(rec);
+		}
+	}
+
+	class EpochDomain final : public IReclamationDomain
+	{
+	public:
+		static constexpr sizet CollectThreshold = 64;
+
+	private:
+		static constexpr uint64 ActiveBit = 1;
+		static constexpr uint32 BagCount = 3;
+
+		struct LimboBag
+		{
+			uint64 Epoch = 0;
+			Vector<RetiredPointer> Items;
+		};
+
+		struct alignas(CACHE_LINE_SIZE) ThreadRecord
+		{
+			std::atomic<uint64> State{ 0 }; // (epoch << 1) | ActiveBit
+			std::atomic<bool> InUse{ false };
+			ThreadRecord* Next = nullptr;
+			uint32 Nesting = 0;
+			sizet RetiredSinceCollect = 0;
+			LimboBag Bags[BagCount];
+		};
+
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64> m_GlobalEpoch;
+		alignas(CACHE_LINE_SIZE) std::atomic<ThreadRecord*> m_Records;
+		Mutex m_OrphanMutex;
+		Vector<LimboBag> m_Orphans;
+
+		INLINE ThreadRecord* GetThreadRecord() noexcept
+		{
+			auto* rec = static_cast<ThreadRecord*>(Impl::GetReclamationThreadSlots().Find(m_DomainID));
+			if (rec != nullptr)
+				return rec;
+			RegisterThread();
+			return static_cast<ThreadRecord*>(Impl::GetReclamationThreadSlots().Find(m_DomainID));
+		}
+
+		void Collect(ThreadRecord* rec) noexcept
+		{
+			const auto epoch = m_GlobalEpoch.load(std::memory_order_acquire);
+			rec->RetiredSinceCollect = 0;
+			for (auto& bag : rec->Bags)
+			{
+				if (bag.Epoch + 2 <= epoch)
+					Impl::DeleteRetired(bag.Items);
+				rec->RetiredSinceCollect += bag.Items.size();
+			}
+			if (!m_OrphanMutex.try_lock())
+				return;
+			for (auto it = m_Orphans.begin(); it != m_Orphans.end();)
+			{
+				if (it->Epoch + 2 <= epoch)
+				{
+					Impl::DeleteRetired(it->Items);
+					it = m_Orphans.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			m_OrphanMutex.unlock();
+		}
+
+	public:
+		EpochDomain() noexcept
+			:m_GlobalEpoch(BagCount)
+			,m_Records(nullptr)
+		{
+
+		}
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+
+		/** Threads still registered keep their slot, it is skipped once the domain is gone */
+		~EpochDomain()
+		{
+			ReleaseDomainID();
+			auto* rec = m_Records.exchange(nullptr, std::memory_order_acquire);
+			while (rec != nullptr)
+			{
+				auto* next = rec->Next;
+				for (auto& bag : rec->Bags)
+					Impl::DeleteRetired(bag.Items);
+				Impl::DestroyRecord(rec);
+				rec = next;
+			}
+			for (auto& bag : m_Orphans)
+				Impl::DeleteRetired(bag.Items);
+		}
+
+		static EpochDomain& GetDefault() noexcept
+		{
+			static EpochDomain domain;
+			return domain;
+		}
+
+		void RegisterThread() override
+		{
+			auto& slots = Impl::GetReclamationThreadSlots();
+			if (slots.Find(m_DomainID) != nullptr)
+				return;
+			slots.Add(this, Impl::AcquireRecord(m_Records));
+		}
+
+		void UnregisterThread() override
+		{
+			auto& slots = Impl::GetReclamationThreadSlots();
+			auto* rec = static_cast<ThreadRecord*>(slots.Find(m_DomainID));
+			if (rec == nullptr)
+				return;
+			VerifyEqual(rec->Nesting, 0, "Trying to unregister a thread from an EpochDomain while inside a critical region.");
+			TryAdvance();
+			Collect(rec);
+			if (rec->RetiredSinceCollect > 0)
+			{
+				auto lck = Lock<Mutex>(m_OrphanMutex);
+				for (auto& bag : rec->Bags)
+				{
+					if (bag.Items.empty())
+						continue;
+					m_Orphans.push_back(std::move(bag));
+					bag = LimboBag{};
+				}
+			}
+			rec->RetiredSinceCollect = 0;
+			rec->State.store(0, std::memory_order_relaxed);
+			rec->InUse.store(false, std::memory_order_release);
+			slots.Remove(m_DomainID);
+		}
+
+		/** Enters a critical region, nodes read inside won't be freed until Exit, calls can be nested */
+		INLINE void Enter() noexcept
+		{
+			auto* rec = GetThreadRecord();
+			if (rec->Nesting++ != 0)
+				return;
+			auto epoch = m_GlobalEpoch.load(std::memory_order_relaxed);
+			while (true)
+			{
+				rec->State.store((epoch << 1) | ActiveBit, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const auto current = m_GlobalEpoch.load(std::memory_order_relaxed);
+				if (current == epoch)
+					break;
+				epoch = current;
+			}
+		}
+
+		INLINE void Exit() noexcept
+		{
+			auto* rec = GetThreadRecord();
+			VerifyGreater(rec->Nesting, 0, "Trying to exit an EpochDomain critical region that was not entered.");
+			if (--rec->Nesting != 0)
+				return;
+			rec->State.store(rec->State.load(std::memory_order_relaxed) & ~ActiveBit, std::memory_order_release);
+			if (rec->RetiredSinceCollect >= CollectThreshold)
+			{
+				TryAdvance();
+				Collect(rec);
+			}
+		}
+
+		/** Defers the destruction of an already unlinked node until no reader can hold it */
+		template<class T, class _Alloc_ = GenericAllocator>
+		INLINE void Retire(T* ptr) noexcept
+		{
+			Retire(ptr, &DestroyRetired<T, _Alloc_>);
+		}
+
+		void Retire(void* ptr, void(*deleter)(void*)) noexcept
+		{
+			auto* rec = GetThreadRecord();
+			const auto epoch = m_GlobalEpoch.load(std::memory_order_acquire);
+			auto& bag = rec->Bags[epoch % BagCount];
+			if (bag.Epoch != epoch)
+			{
+				// Same slot means it was filled at least BagCount epochs ago
+				rec->RetiredSinceCollect -= bag.Items.size();
+				Impl::DeleteRetired(bag.Items);
+				bag.Epoch = epoch;
+			}
+			bag.Items.push_back(RetiredPointer{ ptr, deleter });
+			if (++rec->RetiredSinceCollect >= CollectThreshold)
+			{
+				TryAdvance();
+				Collect(rec);
+			}
+		}
+
+		/** Moves the global epoch forward if every active thread has observed the current one */
+		bool TryAdvance() noexcept
+		{
+			auto epoch = m_GlobalEpoch.load(std::memory_order_seq_cst);
+			for (auto* rec = m_Records.load(std::memory_order_acquire); rec != nullptr; rec = rec->Next)
+			{
+				if (!rec->InUse.load(std::memory_order_acquire))
+					continue;
+				const auto state = rec->State.load(std::memory_order_seq_cst);
+				if ((state & ActiveBit) != 0 && (state >> 1) != epoch)
+					return false;
+			}
+			return m_GlobalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+		}
+
+		/** Blocks until everything retired by the calling thread has been freed, must be called outside a critical region */
+		void Synchronize() noexcept
+		{
+			auto* rec = GetThreadRecord();
+			VerifyEqual(rec->Nesting, 0, "Trying to synchronize an EpochDomain while inside a critical region.");
+			Collect(rec);
+			while (rec->RetiredSinceCollect > 0)
+			{
+				if (!TryAdvance())
+					THREAD_YIELD();
+				Collect(rec);
+			}
+		}
+
+		[[nodiscard]] INLINE uint64 GetEpoch()const noexcept { return m_GlobalEpoch.load(std::memory_order_relaxed); }
+	};
+
+	class EpochGuard
+	{
+		EpochDomain& m_Domain;
+
+	public:
+		explicit EpochGuard(EpochDomain& domain = EpochDomain::GetDefault()) noexcept
+			:m_Domain(domain)
+		{
+			m_Domain.Enter();
+		}
+		~EpochGuard()
+		{
+			m_Domain.Exit();
+		}
+		EpochGuard(const EpochGuard&) = delete;
+		EpochGuard& operator=(const EpochGuard&) = delete;
+	};
+
+	class HazardPointerDomain final : public IReclamationDomain
+	{
+	public:
+		static constexpr uint32 SlotsPerThread = 4;
+
+	private:
+		struct alignas(CACHE_LINE_SIZE) ThreadRecord
+		{
+			std::atomic<void*> Hazards[SlotsPerThread] = {};
+			std::atomic<bool> InUse{ false };
+			ThreadRecord* Next = nullptr;
+			Vector<RetiredPointer> Retired;
+		};
+
+		alignas(CACHE_LINE_SIZE) std::atomic<ThreadRecord*> m_Records;
+		std::atomic<uint32> m_RecordCount;
+		Mutex m_OrphanMutex;
+		Vector<RetiredPointer> m_Orphans;
+
+		INLINE ThreadRecord* GetThreadRecord() noexcept
+		{
+			auto* rec = static_cast<ThreadRecord*>(Impl::GetReclamationThreadSlots().Find(m_DomainID));
+			if (rec != nullptr)
+				return rec;
+			RegisterThread();
+			return static_cast<ThreadRecord*>(Impl::GetReclamationThreadSlots().Find(m_DomainID));
+		}
+
+		INLINE sizet GetScanThreshold()const noexcept
+		{
+			return 2 * SlotsPerThread * Max<sizet>(m_RecordCount.load(std::memory_order_relaxed), 1);
+		}
+
+		void Scan(Vector<RetiredPointer>& retired) noexcept
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			Vector<void*> hazards;
+			hazards.reserve(SlotsPerThread * m_RecordCount.load(std::memory_order_relaxed));
+			for (auto* rec = m_Records.load(std::memory_order_acquire); rec != nullptr; rec = rec->Next)
+			{
+				for (auto& hazard : rec->Hazards)
+				{
+					auto* ptr = hazard.load(std::memory_order_acquire);
+					if (ptr != nullptr)
+						hazards.push_back(ptr);
+				}
+			}
+			std::sort(hazards.begin(), hazards.end());
+
+			sizet kept = 0;
+			for (sizet i = 0; i < retired.size(); ++i)
+			{
+				const auto r = retired[i];
+				if (std::binary_search(hazards.begin(), hazards.end(), r.Pointer))
+					retired[kept++] = r;
+				else
+					r.Deleter(r.Pointer);
+			}
+			retired.resize(kept);
+		}
+
+	public:
+		HazardPointerDomain() noexcept
+			:m_Records(nullptr)
+			,m_RecordCount(0)
+		{
+
+		}
+		HazardPointerDomain(const HazardPointerDomain&) = delete;
+		HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+		/** Threads still registered keep their slot, it is skipped once the domain is gone */
+		~HazardPointerDomain()
+		{
+			ReleaseDomainID();
+			auto* rec = m_Records.exchange(nullptr, std::memory_order_acquire);
+			while (rec != nullptr)
+			{
+				auto* next = rec->Next;
+				Impl::DeleteRetired(rec->Retired);
+				Impl::DestroyRecord(rec);
+				rec = next;
+			}
+			Impl::DeleteRetired(m_Orphans);
+		}
+
+		static HazardPointerDomain& GetDefault() noexcept
+		{
+			static HazardPointerDomain domain;
+			return domain;
+		}
+
+		void RegisterThread() override
+		{
+			auto& slots = Impl::GetReclamationThreadSlots();
+			if (slots.Find(m_DomainID) != nullptr)
+				return;
+			slots.Add(this, Impl::AcquireRecord(m_Records));
+			m_RecordCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void UnregisterThread() override
+		{
+			auto& slots = Impl::GetReclamationThreadSlots();
+			auto* rec = static_cast<ThreadRecord*>(slots.Find(m_DomainID));
+			if (rec == nullptr)
+				return;
+			for (auto& hazard : rec->Hazards)
+				hazard.store(nullptr, std::memory_order_release);
+			Scan(rec->Retired);
+			if (!rec->Retired.empty())
+			{
+				auto lck = Lock<Mutex>(m_OrphanMutex);
+				m_Orphans.insert(m_Orphans.end(), rec->Retired.begin(), rec->Retired.end());
+				rec->Retired.clear();
+			}
+			rec->InUse.store(false, std::memory_order_release);
+			m_RecordCount.fetch_sub(1, std::memory_order_relaxed);
+			slots.Remove(m_DomainID);
+		}
+
+		/** Publishes the pointer loaded from source into the given hazard slot, it won't be freed until cleared */
+		template<class T>
+		INLINE T* Protect(const std::atomic<T*>& source, uint32 slot) noexcept
+		{
+			VerifyLess(slot, SlotsPerThread, "Trying to use an out of bounds hazard pointer slot.");
+			auto& hazard = GetThreadRecord()->Hazards[slot];
+			T* ptr = source.load(std::memory_order_relaxed);
+			while (true)
+			{
+				hazard.store(ptr, std::memory_order_seq_cst);
+				T* const current = source.load(std::memory_order_acquire);
+				if (current == ptr)
+					return ptr;
+				ptr = current;
+			}
+		}
+
+		INLINE void Clear(uint32 slot) noexcept
+		{
+			VerifyLess(slot, SlotsPerThread, "Trying to use an out of bounds hazard pointer slot.");
+			GetThreadRecord()->Hazards[slot].store(nullptr, std::memory_order_release);
+		}
+
+		template<class T, class _Alloc_ = GenericAllocator>
+		INLINE void Retire(T* ptr) noexcept
+		{
+			Retire(ptr, &DestroyRetired<T, _Alloc_>);
+		}
+
+		void Retire(void* ptr, void(*deleter)(void*)) noexcept
+		{
+			auto* rec = GetThreadRecord();
+			rec->Retired.push_back(RetiredPointer{ ptr, deleter });
+			if (rec->Retired.size() < GetScanThreshold())
+				return;
+			Scan(rec->Retired);
+			if (m_OrphanMutex.try_lock())
+			{
+				Scan(m_Orphans);
+				m_OrphanMutex.unlock();
+			}
+		}
+	};
+
+	class HazardGuard
+	{
+		HazardPointerDomain& m_Domain;
+		uint32 m_Slot;
+
+	public:
+		explicit HazardGuard(uint32 slot, HazardPointerDomain& domain = HazardPointerDomain::GetDefault()) noexcept
+			:m_Domain(domain)
+			,m_Slot(slot)
+		{
+
+		}
+		~HazardGuard()
+		{
+			m_Domain.Clear(m_Slot);
+		}
+		HazardGuard(const HazardGuard&) = delete;
+		HazardGuard& operator=(const HazardGuard&) = delete;
+
+		template<class T>
+		INLINE T* Protect(const std::atomic<T*>& source) noexcept
+		{
+			return m_Domain.Protect(source, m_Slot);
+		}
+	};
+}
+
+#endif /* CORE_RECLAMATION_H */
\ No newline at end of file
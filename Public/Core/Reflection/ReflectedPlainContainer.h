@@ -21,12 +21,14 @@ namespace greaper
 
 		static ReflectedSize_t ToStream(const String& data, IStream& stream)
 		{
-			return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
-				{
-					ReflectedSize_t size = data.size() * sizeof(String::value_type);
-					stream.Write(data.data(), size * sizeof(String::value_type));
-					return size;
-				});
+			// The size is known upfront, so the header and the characters go in one call
+			ReflectedSize_t size = GetSize(data);
+			const IOVec vecs[] = {
+				{ &size, sizeof(size) },
+				{ (void*)data.data(), data.size() * sizeof(String::value_type) }
+			};
+			stream.WriteV(vecs);
+			return size;
 		}
 
 		static ReflectedSize_t FromStream(String& data, IStream& stream)
@@ -36,9 +38,10 @@ namespace greaper
 			ReflectedReadSizeHeader(stream, size);
 
 			ReflectedSize_t stringSize = size - sizeof(ReflectedSize_t);
-			data.clear();
-			data.resize(stringSize);
-			stream.Read(data.data(), stringSize * sizeof(String::value_type));
+			// Read straight into the string, a view would copy it twice on most streams
+			data.resize(stringSize / sizeof(String::value_type));
+			const auto read = stream.Read(data.data(), (ssizet)(data.size() * sizeof(String::value_type)));
+			data.resize(read > 0 ? (sizet)read / sizeof(String::value_type) : 0);
 
 			return size;
 		}
@@ -69,12 +72,13 @@ namespace greaper
 
 		static ReflectedSize_t ToStream(const WString& data, IStream& stream)
 		{
-			return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
-				{
-					ReflectedSize_t size = data.size() * sizeof(WString::value_type);
-					stream.Write(data.data(), size * sizeof(WString::value_type));
-					return size;
-				});
+			ReflectedSize_t size = GetSize(data);
+			const IOVec vecs[] = {
+				{ &size, sizeof(size) },
+				{ (void*)data.data(), data.size() * sizeof(WString::value_type) }
+			};
+			stream.WriteV(vecs);
+			return size;
 		}
 
 		static ReflectedSize_t FromStream(WString& data, IStream& stream)
@@ -84,9 +88,10 @@ namespace greaper
 			ReflectedReadSizeHeader(stream, size);
 
 			ReflectedSize_t stringSize = size - sizeof(ReflectedSize_t);
-			data.clear();
-			data.resize(stringSize);
-			stream.Read(data.data(), stringSize * sizeof(WString::value_type));
+			// Read straight into the string, a view would copy it twice on most streams
+			data.resize(stringSize / sizeof(WString::value_type));
+			const auto read = stream.Read(data.data(), (ssizet)(data.size() * sizeof(WString::value_type)));
+			data.resize(read > 0 ? (sizet)read / sizeof(WString::value_type) : 0);
 
 			return size;
 		}
@@ -118,16 +123,29 @@ namespace greaper
 
 		static ReflectedSize_t ToStream(const Container_t& data, IStream& stream)
 		{
-			return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
-				{
-					ReflectedSize_t size = 0;
-
-					for (const auto& elem : data)
+			if constexpr (ReflectedIsBitwise<T>)
+			{
+				ReflectedSize_t size = sizeof(ReflectedSize_t) + N * sizeof(T);
+				const IOVec vecs[] = {
+					{ &size, sizeof(size) },
+					{ (void*)data.data(), N * sizeof(T) }
+				};
+				stream.WriteV(vecs);
+				return size;
+			}
+			else
+			{
+				return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
 					{
-						size += ReflectedWrite(elem, stream);
-					}
-					return size;
-				});
+						ReflectedSize_t size = 0;
+
+						for (const auto& elem : data)
+						{
+							size += ReflectedWrite(elem, stream);
+						}
+						return size;
+					});
+			}
 		}
 
 		static ReflectedSize_t FromStream(Container_t& data, IStream& stream)
@@ -136,9 +154,17 @@ namespace greaper
 
 			ReflectedReadSizeHeader(stream, size);
 
-			for (auto& elem : data)
+			if constexpr (ReflectedIsBitwise<T>)
 			{
-				ReflectedRead(elem, stream);
+				// Fixed size elements are stored as their bytes, read them at once
+				stream.Read(data.data(), (ssizet)(N * sizeof(T)));
+			}
+			else
+			{
+				for (auto& elem : data)
+				{
+					ReflectedRead(elem, stream);
+				}
 			}
 
 			return size;
@@ -191,18 +217,34 @@ namespace greaper
 
 		static ReflectedSize_t ToStream(const Container_t& data, IStream& stream)
 		{
-			return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
-				{
-					ReflectedSize_t size = 0;
-					const auto elemNum = (ReflectedSize_t)data.size();
-					size += ReflectedWrite(elemNum, stream);
-
-					for (const auto& elem : data)
+			if constexpr (ReflectedIsBitwise<T> && !std::is_same_v<T, bool>)
+			{
+				// Header, element count and elements in one call
+				auto elemNum = (ReflectedSize_t)data.size();
+				ReflectedSize_t size = sizeof(ReflectedSize_t) * 2 + data.size() * sizeof(T);
+				const IOVec vecs[] = {
+					{ &size, sizeof(size) },
+					{ &elemNum, sizeof(elemNum) },
+					{ (void*)data.data(), data.size() * sizeof(T) }
+				};
+				stream.WriteV(vecs);
+				return size;
+			}
+			else
+			{
+				return ReflectedWriteWithSizeHeader(stream, data, [&data, &stream]()
 					{
-						size += ReflectedWrite(elem, stream);
-					}
-					return size;
-				});
+						ReflectedSize_t size = 0;
+						const auto elemNum = (ReflectedSize_t)data.size();
+						size += ReflectedWrite(elemNum, stream);
+
+						for (const auto& elem : data)
+						{
+							size += ReflectedWrite(elem, stream);
+						}
+						return size;
+					});
+			}
 		}
 
 		static ReflectedSize_t FromStream(Container_t& data, IStream& stream)
@@ -215,14 +257,25 @@ namespace greaper
 			ReflectedRead(elemNum, stream);
 
 			data.clear();
-			if (data.capacity() < elemNum)
-				data.reserve(elemNum); // Pre-allocate all elements
-			for (ReflectedSize_t i = 0; i < elemNum; ++i)
+			// Vector<bool> packs its bits, so it has no contiguous storage to copy into
+			if constexpr (ReflectedIsBitwise<T> && !std::is_same_v<T, bool>)
 			{
-				T elem;
-				ReflectedRead(elem, stream);
+				// Fixed size elements are stored as their bytes, read them at once
+				data.resize(elemNum);
+				const auto read = stream.Read(data.data(), (ssizet)(data.size() * sizeof(T)));
+				data.resize(read > 0 ? (sizet)read / sizeof(T) : 0);
+			}
+			else
+			{
+				if (data.capacity() < elemNum)
+					data.reserve(elemNum); // Pre-allocate all elements
+				for (ReflectedSize_t i = 0; i < elemNum; ++i)
+				{
+					T elem;
+					ReflectedRead(elem, stream);
 
-				data.push_back(std::move(elem));
+					data.push_back(std::move(elem));
+				}
 			}
 
 			return size;
@@ -64,6 +64,39 @@ namespace greaper
 	ReflectedSize_t ReflectedReadSizeHeader(IStream& stream, ReflectedSize_t& size);
 
 	void ReflectedAddHeaderSize(ReflectedSize_t& size);
+
+	template<class T>
+	struct ReflectedHasFixedSize : std::bool_constant<ReflectedPlainType<T>::HasDynamicSize == 0> {};
+
+	/** Types serialized as their own bytes, so contiguous runs of them can be transferred at once */
+	template<class T>
+	inline constexpr bool ReflectedIsBitwise = std::conjunction_v<std::is_trivially_copyable<T>, ReflectedHasFixedSize<T>>;
+
+	template<class T, class TStream>
+	inline constexpr bool ReflectedIsDirectStream = std::conjunction_v<std::is_final<TStream>, std::is_base_of<IStream, TStream>,
+		std::is_trivially_copyable<T>, ReflectedHasFixedSize<T>>;
+
+	/**
+	 * Bitwise values on a final stream type, like MemoryStream or MMapStream,
+	 * skip ReflectedPlainType and the virtual Write, the stream's own WriteArray
+	 * gets inlined down to a memcpy.
+	 * Only calls made with the concrete stream type match, the container and
+	 * field serializers take an IStream&, so the values nested in them still
+	 * go through the virtual calls. Containers of bitwise values transfer
+	 * their elements with a single call anyway, it is the per element loops
+	 * of the rest that don't benefit.
+	 */
+	template<typename T, class TStream, std::enable_if_t<ReflectedIsDirectStream<T, TStream>, int> = 0>
+	INLINE ReflectedSize_t ReflectedWrite(const T& data, TStream& stream)
+	{
+		return (ReflectedSize_t)(stream.WriteArray(&data, 1) * sizeof(T));
+	}
+
+	template<typename T, class TStream, std::enable_if_t<ReflectedIsDirectStream<T, TStream>, int> = 0>
+	INLINE ReflectedSize_t ReflectedRead(T& data, TStream& stream)
+	{
+		return (ReflectedSize_t)(stream.ReadArray(&data, 1) * sizeof(T));
+	}
 }
 
 template<class T>
@@ -137,7 +170,7 @@ greaper::ReflectedSize_t greaper::ReflectedWriteWithSizeHeader(IStream& stream,
 	size = fn() + sizeof(size);
 	VerifyGreater(size, 0, "Trying to write a zero length type.");
 	stream.Seek(sizePos);
-	stream.Write(size, sizeof(size));
+	stream.Write(&size, sizeof(size));
 	stream.Skip(size - sizeof(size));
 	return size;
 }
@@ -9,6 +9,8 @@
 #define CORE_STREAM_H 1
 
 #include "Memory.h"
+#include "Base/IOVec.h"
+#include <span>
 
 namespace greaper
 {
@@ -26,6 +28,7 @@ namespace greaper
 		String m_Name;
 		ssizet m_Size;
 		uint16 m_Access;
+		mutable Vector<uint8> m_Scratch; // Backs the views of streams that can't hand out their storage
 
 	public:
 		IStream(uint16 accessMode = READ);
@@ -52,6 +55,41 @@ namespace greaper
 		virtual ssizet Read(void* buff, ssizet count)const = 0;
 		
 		virtual ssizet Write(const void* buff, ssizet count) = 0;
+
+		/** Reads count values of a trivially copyable T with one Read, returns how many were read whole */
+		template<typename T>
+		sizet ReadArray(T* data, sizet count)const;
+
+		/** Writes count values of a trivially copyable T with one Write, returns how many were written whole */
+		template<typename T>
+		sizet WriteArray(const T* data, sizet count);
+
+		/** Reads into each piece in turn, stopping at the first short one, returns the total bytes read */
+		virtual ssizet ReadV(std::span<const IOVec> vecs)const;
+
+		/**
+		 * Writes the pieces in order as one transfer, so a header and its payloads
+		 * take a single call, returns the total bytes written.
+		 */
+		virtual ssizet WriteV(std::span<const IOVec> vecs);
+
+		/**
+		 * Returns the next count bytes, fewer at the end of the stream, and moves
+		 * the cursor past them. Streams that can point into their storage do so,
+		 * the rest read into a scratch buffer. The view is only valid until the
+		 * next operation on the stream.
+		 */
+		virtual std::span<const uint8> ReadView(sizet count)const;
+
+		/**
+		 * Returns room for count bytes at the cursor, fewer if the stream can't
+		 * hold them, to be filled in place and handed to WriteCommit before any
+		 * other operation on the stream.
+		 */
+		virtual std::span<uint8> WriteReserve(sizet count);
+
+		/** Writes the first count bytes of the last WriteReserve and moves the cursor past them */
+		virtual void WriteCommit(sizet count);
 		
 		virtual void Skip(ssizet count) = 0;
 
@@ -0,0 +1,281 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_TIMER_WHEEL_H
+#define CORE_TIMER_WHEEL_H 1
+
+#include "Memory.h"
+#include "Enumeration.h"
+#include "InplaceFunction.h"
+#include <bit>
+
+namespace greaper
+{
+	using TimerCallback = InplaceFunction<void()>;
+
+	/**
+	 * Frames count phase updates, Time counts fixed size ticks, both hands share
+	 * the node storage and the handle space of the wheel.
+	 */
+	ENUMERATION(TimerDomain, Frames, Time);
+
+	struct TimerHandle
+	{
+		uint32 Index = static_cast<uint32>(-1);
+		uint32 Generation = 0;
+
+		[[nodiscard]] constexpr bool IsValid()const noexcept { return Index != static_cast<uint32>(-1); }
+
+		friend constexpr bool operator==(const TimerHandle& left, const TimerHandle& right) noexcept { return left.Index == right.Index && left.Generation == right.Generation; }
+		friend constexpr bool operator!=(const TimerHandle& left, const TimerHandle& right) noexcept { return !(left == right); }
+	};
+
+	/**
+	 * @brief Hierarchical timing wheel
+	 *
+	 * Each domain has Levels wheels of SlotsPerLevel slots, level L slots span
+	 * SlotsPerLevel^L ticks. Timers live in intrusive doubly linked lists of
+	 * pooled nodes, so Schedule and Cancel are O(1) and a cancelled timer costs
+	 * nothing afterwards. Advancing only visits the slot of each elapsed tick,
+	 * and cascades a higher level slot into the lower ones when its range starts.
+	 * Timers further than the top level wait in an overflow list that is
+	 * re-examined once per top level turn.
+	 */
+	class TimerWheel
+	{
+	public:
+		static constexpr uint32 SlotBits = 6;
+		static constexpr uint32 SlotsPerLevel = 1u << SlotBits;
+		static constexpr uint32 Levels = 5;
+
+	private:
+		static constexpr uint32 InvalidIndex = static_cast<uint32>(-1);
+		static constexpr uint32 ListCount = Levels * SlotsPerLevel + 1;
+		static constexpr uint32 OverflowList = Levels * SlotsPerLevel;
+		static constexpr uint64 SlotMask = SlotsPerLevel - 1;
+
+		struct Node
+		{
+			TimerCallback Callback;
+			uint64 Expiry = 0;
+			uint32 Prev = InvalidIndex;
+			uint32 Next = InvalidIndex;
+			uint32 Generation = 0;
+			uint32 List = InvalidIndex;
+			TimerDomain_t Domain = TimerDomain_t::Frames;
+		};
+
+		struct DomainWheel
+		{
+			uint32 Heads[ListCount];
+			uint64 Current = 0;
+			sizet Count = 0;
+		};
+
+		Vector<Node> m_Nodes;
+		uint32 m_FreeHead = InvalidIndex;
+		DomainWheel m_Domains[TimerDomain_t::COUNT];
+
+		INLINE uint32 AllocateNode()
+		{
+			if (m_FreeHead != InvalidIndex)
+			{
+				const auto index = m_FreeHead;
+				m_FreeHead = m_Nodes[index].Next;
+				return index;
+			}
+			m_Nodes.emplace_back();
+			return static_cast<uint32>(m_Nodes.size() - 1);
+		}
+
+		INLINE void FreeNode(uint32 index) noexcept
+		{
+			auto& node = m_Nodes[index];
+			node.Callback.Reset();
+			++node.Generation; // Invalidates the outstanding handles
+			node.List = InvalidIndex;
+			node.Prev = InvalidIndex;
+			node.Next = m_FreeHead;
+			m_FreeHead = index;
+		}
+
+		INLINE void Link(DomainWheel& wheel, uint32 index) noexcept
+		{
+			auto& node = m_Nodes[index];
+			const auto diff = node.Expiry ^ wheel.Current;
+			const auto level = diff == 0 ? 0u : static_cast<uint32>(std::bit_width(diff) - 1) / SlotBits;
+			const auto list = level >= Levels
+				? OverflowList
+				: level * SlotsPerLevel + static_cast<uint32>((node.Expiry >> (level * SlotBits)) & SlotMask);
+
+			node.List = list;
+			node.Prev = InvalidIndex;
+			node.Next = wheel.Heads[list];
+			if (node.Next != InvalidIndex)
+				m_Nodes[node.Next].Prev = index;
+			wheel.Heads[list] = index;
+		}
+
+		INLINE void Unlink(DomainWheel& wheel, uint32 index) noexcept
+		{
+			auto& node = m_Nodes[index];
+			if (node.Prev != InvalidIndex)
+				m_Nodes[node.Prev].Next = node.Next;
+			else
+				wheel.Heads[node.List] = node.Next;
+			if (node.Next != InvalidIndex)
+				m_Nodes[node.Next].Prev = node.Prev;
+			node.List = InvalidIndex;
+		}
+
+		INLINE void Relink(DomainWheel& wheel, uint32 list)
+		{
+			auto index = wheel.Heads[list];
+			wheel.Heads[list] = InvalidIndex;
+			while (index != InvalidIndex)
+			{
+				const auto next = m_Nodes[index].Next;
+				Link(wheel, index);
+				index = next;
+			}
+		}
+
+		INLINE bool IsLevelEmpty(const DomainWheel& wheel, uint32 level)const noexcept
+		{
+			for (uint32 slot = 0; slot < SlotsPerLevel; ++slot)
+			{
+				if (wheel.Heads[level * SlotsPerLevel + slot] != InvalidIndex)
+					return false;
+			}
+			return true;
+		}
+
+		INLINE void Cascade(DomainWheel& wheel)
+		{
+			const auto tick = wheel.Current;
+			for (uint32 level = 1; level < Levels; ++level)
+			{
+				if (((tick >> ((level - 1) * SlotBits)) & SlotMask) != 0)
+					return;
+				Relink(wheel, level * SlotsPerLevel + static_cast<uint32>((tick >> (level * SlotBits)) & SlotMask));
+			}
+			if (((tick >> ((Levels - 1) * SlotBits)) & SlotMask) == 0)
+				Relink(wheel, OverflowList);
+		}
+
+	public:
+		TimerWheel()
+		{
+			for (auto& wheel : m_Domains)
+			{
+				for (auto& head : wheel.Heads)
+					head = InvalidIndex;
+			}
+		}
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+		~TimerWheel() = default;
+
+		/** Schedules the callback to fire once the domain reaches the given tick, past ticks fire on the next one */
+		INLINE TimerHandle ScheduleAt(TimerDomain_t domain, uint64 expiryTick, TimerCallback callback)
+		{
+			auto& wheel = m_Domains[domain];
+			const auto index = AllocateNode();
+			auto& node = m_Nodes[index];
+			node.Callback = std::move(callback);
+			node.Expiry = Max(expiryTick, wheel.Current + 1);
+			node.Domain = domain;
+			Link(wheel, index);
+			++wheel.Count;
+			return TimerHandle{ index, node.Generation };
+		}
+
+		INLINE TimerHandle Schedule(TimerDomain_t domain, uint64 ticksToWait, TimerCallback callback)
+		{
+			return ScheduleAt(domain, m_Domains[domain].Current + Max<uint64>(ticksToWait, 1), std::move(callback));
+		}
+
+		/** Returns false if the timer already fired or was cancelled */
+		INLINE bool Cancel(const TimerHandle& handle) noexcept
+		{
+			if (!IsPending(handle))
+				return false;
+			auto& node = m_Nodes[handle.Index];
+			auto& wheel = m_Domains[node.Domain];
+			Unlink(wheel, handle.Index);
+			FreeNode(handle.Index);
+			--wheel.Count;
+			return true;
+		}
+
+		[[nodiscard]] INLINE bool IsPending(const TimerHandle& handle)const noexcept
+		{
+			if (handle.Index >= m_Nodes.size())
+				return false;
+			const auto& node = m_Nodes[handle.Index];
+			return node.Generation == handle.Generation && node.List != InvalidIndex;
+		}
+
+		/**
+		 * Moves the domain hand up to targetTick, firing every expired timer in order.
+		 * Callbacks may schedule or cancel timers, new timers never fire in the same tick.
+		 * Returns the amount of timers fired.
+		 */
+		INLINE sizet Advance(TimerDomain_t domain, uint64 targetTick)
+		{
+			auto& wheel = m_Domains[domain];
+			sizet fired = 0;
+			while (wheel.Current < targetTick)
+			{
+				if (wheel.Count == 0)
+				{
+					wheel.Current = targetTick;
+					break;
+				}
+				// Jump over the ticks of the empty lower levels, up to the next cascade
+				uint64 skipMask = 0;
+				for (uint32 level = 0; level < Levels && IsLevelEmpty(wheel, level); ++level)
+					skipMask = (skipMask << SlotBits) | SlotMask;
+				if (skipMask != 0)
+				{
+					wheel.Current = Min(wheel.Current | skipMask, targetTick);
+					if (wheel.Current == targetTick)
+						break;
+				}
+				++wheel.Current;
+				Cascade(wheel);
+
+				const auto list = static_cast<uint32>(wheel.Current & SlotMask);
+				while (wheel.Heads[list] != InvalidIndex)
+				{
+					const auto index = wheel.Heads[list];
+					Unlink(wheel, index);
+					auto callback = std::move(m_Nodes[index].Callback);
+					FreeNode(index);
+					--wheel.Count;
+					++fired;
+					callback();
+				}
+			}
+			return fired;
+		}
+
+		[[nodiscard]] INLINE uint64 GetCurrentTick(TimerDomain_t domain)const noexcept { return m_Domains[domain].Current; }
+
+		[[nodiscard]] INLINE sizet GetPendingCount(TimerDomain_t domain)const noexcept { return m_Domains[domain].Count; }
+
+		[[nodiscard]] INLINE sizet GetPendingCount()const noexcept
+		{
+			sizet count = 0;
+			for (const auto& wheel : m_Domains)
+				count += wheel.Count;
+			return count;
+		}
+	};
+}
+
+#endif /* CORE_TIMER_WHEEL_H */
\ No newline at end of file
@@ -90,6 +90,7 @@ typedef unsigned __int64 UINT_PTR, *PUINT_PTR;
 
 typedef __int64 LONG_PTR, *PLONG_PTR;
 typedef unsigned __int64 ULONG_PTR, *PULONG_PTR;
+typedef ULONG_PTR SIZE_T, *PSIZE_T;
 
 typedef CONST CHAR *LPCSTR, *PCSTR;
 typedef CONST WCHAR *LPCWSTR, *PCWSTR;
@@ -457,6 +458,341 @@ SwitchToThread(
     VOID
 );
 
+#define ERROR_TIMEOUT 1460L
+#define ERROR_HANDLE_EOF 38L
+
+WINBASEAPI
+DWORD
+WINAPI
+GetLastError(
+    VOID
+    );
+
+typedef ULONG_PTR KAFFINITY;
+
+typedef struct _GROUP_AFFINITY {
+    KAFFINITY Mask;
+    WORD   Group;
+    WORD   Reserved[3];
+} GROUP_AFFINITY, *PGROUP_AFFINITY;
+
+typedef enum _LOGICAL_PROCESSOR_RELATIONSHIP {
+    RelationProcessorCore,
+    RelationNumaNode,
+    RelationCache,
+    RelationProcessorPackage,
+    RelationGroup,
+    RelationAll = 0xffff
+} LOGICAL_PROCESSOR_RELATIONSHIP;
+
+typedef enum _PROCESSOR_CACHE_TYPE {
+    CacheUnified,
+    CacheInstruction,
+    CacheData,
+    CacheTrace
+} PROCESSOR_CACHE_TYPE;
+
+#define LTP_PC_SMT 0x1
+
+typedef struct _PROCESSOR_RELATIONSHIP {
+    BYTE  Flags;
+    BYTE  EfficiencyClass;
+    BYTE  Reserved[20];
+    WORD  GroupCount;
+    GROUP_AFFINITY GroupMask[1];
+} PROCESSOR_RELATIONSHIP, *PPROCESSOR_RELATIONSHIP;
+
+typedef struct _NUMA_NODE_RELATIONSHIP {
+    DWORD NodeNumber;
+    BYTE  Reserved[20];
+    GROUP_AFFINITY GroupMask;
+} NUMA_NODE_RELATIONSHIP, *PNUMA_NODE_RELATIONSHIP;
+
+typedef struct _CACHE_RELATIONSHIP {
+    BYTE  Level;
+    BYTE  Associativity;
+    WORD  LineSize;
+    DWORD CacheSize;
+    PROCESSOR_CACHE_TYPE Type;
+    BYTE  Reserved[20];
+    GROUP_AFFINITY GroupMask;
+} CACHE_RELATIONSHIP, *PCACHE_RELATIONSHIP;
+
+typedef struct _PROCESSOR_GROUP_INFO {
+    BYTE  MaximumProcessorCount;
+    BYTE  ActiveProcessorCount;
+    BYTE  Reserved[38];
+    KAFFINITY ActiveProcessorMask;
+} PROCESSOR_GROUP_INFO, *PPROCESSOR_GROUP_INFO;
+
+typedef struct _GROUP_RELATIONSHIP {
+    WORD  MaximumGroupCount;
+    WORD  ActiveGroupCount;
+    BYTE  Reserved[20];
+    PROCESSOR_GROUP_INFO GroupInfo[1];
+} GROUP_RELATIONSHIP, *PGROUP_RELATIONSHIP;
+
+typedef struct _SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX {
+    LOGICAL_PROCESSOR_RELATIONSHIP Relationship;
+    DWORD Size;
+    union {
+        PROCESSOR_RELATIONSHIP Processor;
+        NUMA_NODE_RELATIONSHIP NumaNode;
+        CACHE_RELATIONSHIP Cache;
+        GROUP_RELATIONSHIP Group;
+    };
+} SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, *PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX;
+
+#define THREAD_PRIORITY_IDLE            -15
+#define THREAD_PRIORITY_LOWEST          -2
+#define THREAD_PRIORITY_BELOW_NORMAL    -1
+#define THREAD_PRIORITY_NORMAL          0
+#define THREAD_PRIORITY_ABOVE_NORMAL    1
+#define THREAD_PRIORITY_HIGHEST         2
+#define THREAD_PRIORITY_TIME_CRITICAL   15
+
+WINBASEAPI
+BOOL
+WINAPI
+GetLogicalProcessorInformationEx(
+    LOGICAL_PROCESSOR_RELATIONSHIP RelationshipType,
+    PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX Buffer,
+    DWORD* ReturnedLength
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+SetThreadGroupAffinity(
+    HANDLE hThread,
+    CONST GROUP_AFFINITY* GroupAffinity,
+    PGROUP_AFFINITY PreviousGroupAffinity
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+SetThreadPriority(
+    HANDLE hThread,
+    int nPriority
+    );
+
+WINBASEAPI
+DWORD
+WINAPI
+GetCurrentProcessorNumber(
+    VOID
+    );
+
+typedef union _LARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER, *PLARGE_INTEGER;
+
+typedef struct _SECURITY_ATTRIBUTES {
+    DWORD nLength;
+    PVOID lpSecurityDescriptor;
+    BOOL bInheritHandle;
+} SECURITY_ATTRIBUTES, *PSECURITY_ATTRIBUTES, *LPSECURITY_ATTRIBUTES;
+
+typedef struct _OVERLAPPED {
+    ULONG_PTR Internal;
+    ULONG_PTR InternalHigh;
+    union {
+        struct {
+            DWORD Offset;
+            DWORD OffsetHigh;
+        };
+        PVOID Pointer;
+    };
+    HANDLE hEvent;
+} OVERLAPPED, *LPOVERLAPPED;
+
+#define GENERIC_READ                (0x80000000L)
+#define GENERIC_WRITE               (0x40000000L)
+#define FILE_SHARE_READ             0x00000001
+#define CREATE_ALWAYS               2
+#define OPEN_EXISTING               3
+#define OPEN_ALWAYS                 4
+#define FILE_ATTRIBUTE_NORMAL       0x00000080
+#define FILE_FLAG_RANDOM_ACCESS     0x10000000
+#define FILE_FLAG_SEQUENTIAL_SCAN   0x08000000
+#define FILE_BEGIN                  0
+
+WINBASEAPI
+HANDLE
+WINAPI
+CreateFileA(
+    LPCSTR lpFileName,
+    DWORD dwDesiredAccess,
+    DWORD dwShareMode,
+    LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+    DWORD dwCreationDisposition,
+    DWORD dwFlagsAndAttributes,
+    HANDLE hTemplateFile
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+CloseHandle(
+    HANDLE hObject
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+ReadFile(
+    HANDLE hFile,
+    PVOID lpBuffer,
+    DWORD nNumberOfBytesToRead,
+    DWORD* lpNumberOfBytesRead,
+    LPOVERLAPPED lpOverlapped
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+WriteFile(
+    HANDLE hFile,
+    const VOID* lpBuffer,
+    DWORD nNumberOfBytesToWrite,
+    DWORD* lpNumberOfBytesWritten,
+    LPOVERLAPPED lpOverlapped
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+SetFilePointerEx(
+    HANDLE hFile,
+    LARGE_INTEGER liDistanceToMove,
+    PLARGE_INTEGER lpNewFilePointer,
+    DWORD dwMoveMethod
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+GetFileSizeEx(
+    HANDLE hFile,
+    PLARGE_INTEGER lpFileSize
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+FlushFileBuffers(
+    HANDLE hFile
+    );
+
+typedef struct _SYSTEM_INFO {
+    union {
+        DWORD dwOemId;
+        struct {
+            WORD wProcessorArchitecture;
+            WORD wReserved;
+        };
+    };
+    DWORD dwPageSize;
+    PVOID lpMinimumApplicationAddress;
+    PVOID lpMaximumApplicationAddress;
+    ULONG_PTR dwActiveProcessorMask;
+    DWORD dwNumberOfProcessors;
+    DWORD dwProcessorType;
+    DWORD dwAllocationGranularity;
+    WORD wProcessorLevel;
+    WORD wProcessorRevision;
+} SYSTEM_INFO, *LPSYSTEM_INFO;
+
+#define PAGE_READONLY               0x02
+#define PAGE_READWRITE              0x04
+#define FILE_MAP_WRITE              0x0002
+#define FILE_MAP_READ               0x0004
+
+WINBASEAPI
+VOID
+WINAPI
+GetSystemInfo(
+    LPSYSTEM_INFO lpSystemInfo
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+SetEndOfFile(
+    HANDLE hFile
+    );
+
+WINBASEAPI
+HANDLE
+WINAPI
+CreateFileMappingA(
+    HANDLE hFile,
+    LPSECURITY_ATTRIBUTES lpFileMappingAttributes,
+    DWORD flProtect,
+    DWORD dwMaximumSizeHigh,
+    DWORD dwMaximumSizeLow,
+    LPCSTR lpName
+    );
+
+WINBASEAPI
+PVOID
+WINAPI
+MapViewOfFile(
+    HANDLE hFileMappingObject,
+    DWORD dwDesiredAccess,
+    DWORD dwFileOffsetHigh,
+    DWORD dwFileOffsetLow,
+    SIZE_T dwNumberOfBytesToMap
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+UnmapViewOfFile(
+    const VOID* lpBaseAddress
+    );
+
+WINBASEAPI
+BOOL
+WINAPI
+FlushViewOfFile(
+    const VOID* lpBaseAddress,
+    SIZE_T dwNumberOfBytesToFlush
+    );
+
+#if GREAPER_MIN_WINDOWS_SUPPORTED >= 0x0602
+#pragma comment(lib, "Synchronization.lib")
+
+WINBASEAPI
+BOOL
+WINAPI
+WaitOnAddress(
+    volatile VOID* Address,
+    PVOID CompareAddress,
+    SIZE_T AddressSize,
+    DWORD dwMilliseconds
+    );
+
+WINBASEAPI
+VOID
+WINAPI
+WakeByAddressSingle(
+    PVOID Address
+    );
+
+WINBASEAPI
+VOID
+WINAPI
+WakeByAddressAll(
+    PVOID Address
+    );
+#endif
+
 #else
 #include <Windows.h>
 #include <rpc.h>
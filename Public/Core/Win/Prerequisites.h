@@ -72,4 +72,5 @@ extern void CDECL __debugbreak();
 #define PlatformAlignedAlloc(bytes, alignment) _aligned_malloc(bytes, alignment)
 #define PlatformAlignedDealloc(mem) _aligned_free(mem)
 
+#include <intrin.h>
 #include "MinWinHeader.h"
\ No newline at end of file
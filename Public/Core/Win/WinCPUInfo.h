@@ -0,0 +1,172 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_WIN_CPU_INFO_H
+#define CORE_WIN_CPU_INFO_H 1
+
+#include "../Base/CPUInfo.h"
+
+namespace greaper
+{
+	/**
+	 * Logical processors are numbered as Group * 64 + the bit inside the group mask,
+	 * so a CPUSet can address machines with more than one processor group.
+	 */
+	class WinCPUInfo
+	{
+		static constexpr uint32 GroupBits = 64;
+
+		static CPUSet FromGroupAffinity(const GROUP_AFFINITY& affinity)
+		{
+			CPUSet set;
+			for (uint32 bit = 0; bit < GroupBits; ++bit)
+			{
+				const auto processor = (uint32)affinity.Group * GroupBits + bit;
+				if ((affinity.Mask & (KAFFINITY(1) << bit)) != 0 && processor < CPUSet::MaxProcessors)
+					set.Set(processor);
+			}
+			return set;
+		}
+
+		static Vector<uint8> QueryRelationship(LOGICAL_PROCESSOR_RELATIONSHIP relationship)
+		{
+			DWORD length = 0;
+			GetLogicalProcessorInformationEx(relationship, nullptr, &length);
+			Vector<uint8> buffer(length);
+			if (length == 0 || !GetLogicalProcessorInformationEx(relationship, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &length))
+				buffer.clear();
+			return buffer;
+		}
+
+		template<class Func>
+		static void ForEachRelationship(const Vector<uint8>& buffer, Func&& func)
+		{
+			sizet offset = 0;
+			while (offset < buffer.size())
+			{
+				const auto* info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.data() + offset);
+				func(*info);
+				offset += info->Size;
+			}
+		}
+
+	public:
+		static CPUTopology QueryTopology()
+		{
+			CPUTopology topology;
+			const auto buffer = QueryRelationship(RelationAll);
+			Vector<CPUSet> packages;
+
+			ForEachRelationship(buffer, [&topology, &packages](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info)
+				{
+					switch (info.Relationship)
+					{
+					case RelationNumaNode:
+					{
+						NUMANodeInfo node;
+						node.ID = info.NumaNode.NodeNumber;
+						node.LogicalProcessors = FromGroupAffinity(info.NumaNode.GroupMask);
+						topology.NUMANodes.push_back(node);
+						break;
+					}
+					case RelationCache:
+					{
+						if (info.Cache.Type == CacheTrace)
+							break;
+						CPUCacheInfo cache;
+						cache.Level = info.Cache.Level;
+						cache.IsData = info.Cache.Type != CacheInstruction;
+						cache.IsInstruction = info.Cache.Type != CacheData;
+						cache.SizeBytes = info.Cache.CacheSize;
+						cache.LineSize = info.Cache.LineSize;
+						cache.SharedBy = FromGroupAffinity(info.Cache.GroupMask);
+						topology.Caches.push_back(cache);
+						break;
+					}
+					case RelationProcessorPackage:
+					{
+						CPUSet package;
+						for (WORD i = 0; i < info.Processor.GroupCount; ++i)
+							package |= FromGroupAffinity(info.Processor.GroupMask[i]);
+						packages.push_back(package);
+						break;
+					}
+					default:
+						break;
+					}
+				});
+
+			// Cores are tagged once every package and node is known
+			ForEachRelationship(buffer, [&topology, &packages](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info)
+				{
+					if (info.Relationship != RelationProcessorCore)
+						return;
+
+					CPUCoreInfo core;
+					for (WORD i = 0; i < info.Processor.GroupCount; ++i)
+						core.LogicalProcessors |= FromGroupAffinity(info.Processor.GroupMask[i]);
+					const auto first = core.LogicalProcessors.First();
+					for (sizet i = 0; i < packages.size(); ++i)
+					{
+						if (packages[i].Test(first))
+						{
+							core.PackageID = (uint32)i;
+							break;
+						}
+					}
+					for (const auto& node : topology.NUMANodes)
+					{
+						if (node.LogicalProcessors.Test(first))
+						{
+							core.NUMANode = node.ID;
+							break;
+						}
+					}
+					topology.LogicalProcessorCount += core.LogicalProcessors.Count();
+					topology.Cores.push_back(core);
+				});
+
+			topology.PackageCount = Max<uint32>((uint32)packages.size(), 1);
+			return topology;
+		}
+
+		/** A thread can only run inside one processor group, the group of the lowest processor is used */
+		static bool SetCurrentThreadAffinity(const CPUSet& set)
+		{
+			const auto first = set.First();
+			if (first >= CPUSet::MaxProcessors)
+				return false;
+
+			GROUP_AFFINITY affinity{};
+			affinity.Group = (WORD)(first / GroupBits);
+			for (uint32 bit = 0; bit < GroupBits; ++bit)
+			{
+				if (set.Test((uint32)affinity.Group * GroupBits + bit))
+					affinity.Mask |= KAFFINITY(1) << bit;
+			}
+			return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != FALSE;
+		}
+
+		static bool SetCurrentThreadPriority(ThreadPriority_t priority, ThreadSchedulingPolicy_t policy)
+		{
+			UNUSED(policy);
+			static constexpr int nativePriorities[ThreadPriority_t::COUNT] = {
+				THREAD_PRIORITY_IDLE, THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL,
+				THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST, THREAD_PRIORITY_TIME_CRITICAL
+			};
+			return SetThreadPriority(GetCurrentThread(), nativePriorities[(sizet)priority]) != FALSE;
+		}
+
+		static uint32 GetCurrentProcessor()
+		{
+			return (uint32)GetCurrentProcessorNumber();
+		}
+	};
+	using OSCPUInfo = WinCPUInfo;
+}
+
+#endif /* CORE_WIN_CPU_INFO_H */
\ No newline at end of file
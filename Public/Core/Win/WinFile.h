@@ -0,0 +1,256 @@
+/***********************************************************************************
+*   Copyright 2021 Marcos Sánchez Torrent.                                         *
+*   All Rights Reserved.                                                           *
+***********************************************************************************/
+
+#pragma once
+
+#ifndef CORE_WIN_FILE_H
+#define CORE_WIN_FILE_H 1
+
+#include "../Base/FileInfo.h"
+#include "../Base/IOVec.h"
+
+namespace greaper
+{
+	/** Thin wrapper over the file HANDLE API, transfers bigger than a DWORD are split */
+	class WinFile
+	{
+		static constexpr DWORD MaxTransfer = 1u << 30;
+
+	public:
+		using Handle = HANDLE;
+		static inline const Handle InvalidHandle = INVALID_HANDLE_VALUE;
+
+		static Handle Open(const achar* path, bool read, bool write, FileOpenMode_t mode, FileAccessPattern_t pattern)
+		{
+			DWORD access = 0;
+			if (read)
+				access |= GENERIC_READ;
+			if (write)
+				access |= GENERIC_WRITE;
+			DWORD creation = OPEN_EXISTING;
+			if (mode == FileOpenMode_t::OpenOrCreate)
+				creation = OPEN_ALWAYS;
+			else if (mode == FileOpenMode_t::CreateOrTruncate)
+				creation = CREATE_ALWAYS;
+			// The access pattern can only be given when opening
+			DWORD flags = FILE_ATTRIBUTE_NORMAL;
+			if (pattern == FileAccessPattern_t::Sequential)
+				flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+			else if (pattern == FileAccessPattern_t::Random)
+				flags |= FILE_FLAG_RANDOM_ACCESS;
+			return CreateFileA(path, access, FILE_SHARE_READ, nullptr, creation, flags, nullptr);
+		}
+
+		static void Close(Handle handle)
+		{
+			if (handle != InvalidHandle)
+				CloseHandle(handle);
+		}
+
+		/** Reads at the current file offset, returns the bytes read or -1 on error */
+		static ssizet Read(Handle handle, void* buffer, sizet count)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				DWORD read = 0;
+				const auto toRead = (DWORD)Min<sizet>(count - done, MaxTransfer);
+				if (!ReadFile(handle, static_cast<uint8*>(buffer) + done, toRead, &read, nullptr))
+					return done > 0 ? (ssizet)done : -1;
+				if (read == 0)
+					break;
+				done += read;
+			}
+			return (ssizet)done;
+		}
+
+		/** Writes at the current file offset, returns the bytes written or -1 on error */
+		static ssizet Write(Handle handle, const void* buffer, sizet count)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				DWORD written = 0;
+				const auto toWrite = (DWORD)Min<sizet>(count - done, MaxTransfer);
+				if (!WriteFile(handle, static_cast<const uint8*>(buffer) + done, toWrite, &written, nullptr))
+					return done > 0 ? (ssizet)done : -1;
+				done += written;
+			}
+			return (ssizet)done;
+		}
+
+		/**
+		 * Reads each piece in turn at the current file offset, ReadFileScatter
+		 * only takes page sized pieces on unbuffered handles. Returns the bytes
+		 * read or -1 on error.
+		 */
+		static ssizet ReadV(Handle handle, const IOVec* vecs, sizet count)
+		{
+			sizet done = 0;
+			for (sizet i = 0; i < count; ++i)
+			{
+				const auto read = Read(handle, vecs[i].Data, vecs[i].Size);
+				if (read < 0)
+					return done > 0 ? (ssizet)done : -1;
+				done += (sizet)read;
+				if ((sizet)read < vecs[i].Size)
+					break;
+			}
+			return (ssizet)done;
+		}
+
+		/** Writes each piece in turn at the current file offset, see ReadV, returns the bytes written or -1 on error */
+		static ssizet WriteV(Handle handle, const IOVec* vecs, sizet count)
+		{
+			sizet done = 0;
+			for (sizet i = 0; i < count; ++i)
+			{
+				const auto written = Write(handle, vecs[i].Data, vecs[i].Size);
+				if (written < 0)
+					return done > 0 ? (ssizet)done : -1;
+				done += (sizet)written;
+				if ((sizet)written < vecs[i].Size)
+					break;
+			}
+			return (ssizet)done;
+		}
+
+		/** Reads at the given offset, the file offset is left after the read data, returns the bytes read or -1 on error */
+		static ssizet ReadAt(Handle handle, void* buffer, sizet count, int64 offset)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				DWORD read = 0;
+				OVERLAPPED overlapped{};
+				const auto position = (uint64)offset + done;
+				overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+				overlapped.OffsetHigh = (DWORD)(position >> 32);
+				const auto toRead = (DWORD)Min<sizet>(count - done, MaxTransfer);
+				if (!ReadFile(handle, static_cast<uint8*>(buffer) + done, toRead, &read, &overlapped))
+				{
+					// Reads with an offset report the end of the file as an error
+					if (GetLastError() == ERROR_HANDLE_EOF)
+						break;
+					return done > 0 ? (ssizet)done : -1;
+				}
+				if (read == 0)
+					break;
+				done += read;
+			}
+			return (ssizet)done;
+		}
+
+		/** Writes at the given offset, the file offset is left after the written data, returns the bytes written or -1 on error */
+		static ssizet WriteAt(Handle handle, const void* buffer, sizet count, int64 offset)
+		{
+			sizet done = 0;
+			while (done < count)
+			{
+				DWORD written = 0;
+				OVERLAPPED overlapped{};
+				const auto position = (uint64)offset + done;
+				overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+				overlapped.OffsetHigh = (DWORD)(position >> 32);
+				const auto toWrite = (DWORD)Min<sizet>(count - done, MaxTransfer);
+				if (!WriteFile(handle, static_cast<const uint8*>(buffer) + done, toWrite, &written, &overlapped))
+					return done > 0 ? (ssizet)done : -1;
+				done += written;
+			}
+			return (ssizet)done;
+		}
+
+		/** Returns the new offset or -1 on error */
+		static int64 Seek(Handle handle, int64 offset)
+		{
+			LARGE_INTEGER distance;
+			LARGE_INTEGER position;
+			distance.QuadPart = offset;
+			if (!SetFilePointerEx(handle, distance, &position, FILE_BEGIN))
+				return -1;
+			return position.QuadPart;
+		}
+
+		static int64 GetSize(Handle handle)
+		{
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(handle, &size))
+				return -1;
+			return size.QuadPart;
+		}
+
+		/** Windows only takes the hint when opening, see Open */
+		static void Advise(Handle handle, FileAccessPattern_t pattern, int64 offset = 0, int64 length = 0)
+		{
+			UNUSED(handle);
+			UNUSED(pattern);
+			UNUSED(offset);
+			UNUSED(length);
+		}
+
+		/** Forces the written data to the device */
+		static bool Sync(Handle handle)
+		{
+			return FlushFileBuffers(handle) != FALSE;
+		}
+
+		/** Grows or shrinks the file, no view of it may be mapped */
+		static bool Resize(Handle handle, int64 size)
+		{
+			if (Seek(handle, size) < 0)
+				return false;
+			return SetEndOfFile(handle) != FALSE;
+		}
+
+		/** Map offsets must be a multiple of this */
+		static sizet GetMapGranularity()
+		{
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return (sizet)info.dwAllocationGranularity;
+		}
+
+		/**
+		 * Maps the given range of the file, returns nullptr on failure. The mapping
+		 * object is closed straight away, the view keeps it alive until unmapped.
+		 */
+		static void* Map(Handle handle, int64 offset, sizet size, bool write, bool populate)
+		{
+			UNUSED(populate);
+			HANDLE mapping = CreateFileMappingA(handle, nullptr, write ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == nullptr)
+				return nullptr;
+			void* address = MapViewOfFile(mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ,
+				(DWORD)((uint64)offset >> 32), (DWORD)((uint64)offset & 0xFFFFFFFF), (SIZE_T)size);
+			CloseHandle(mapping);
+			return address;
+		}
+
+		static void Unmap(void* address, sizet size)
+		{
+			UNUSED(size);
+			if (address != nullptr)
+				UnmapViewOfFile(address);
+		}
+
+		/** PrefetchVirtualMemory needs Windows 8, the hint given on Open is used instead */
+		static void AdviseMap(void* address, sizet size, FileAccessPattern_t pattern, bool willNeed)
+		{
+			UNUSED(address);
+			UNUSED(size);
+			UNUSED(pattern);
+			UNUSED(willNeed);
+		}
+
+		/** Starts writing the dirty pages of the range back to the file */
+		static bool FlushMap(void* address, sizet size)
+		{
+			return FlushViewOfFile(address, (SIZE_T)size) != FALSE;
+		}
+	};
+	using OSFile = WinFile;
+}
+
+#endif /* CORE_WIN_FILE_H */
\ No newline at end of file
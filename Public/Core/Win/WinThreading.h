@@ -44,6 +44,11 @@ namespace greaper
 		::SwitchToThread();
 	}
 
+	INLINE void CPU_PAUSE() noexcept
+	{
+		_mm_pause();
+	}
+
 	namespace Impl
 	{
 		struct WinMutexImpl
@@ -238,6 +243,69 @@ namespace greaper
 			}
 		};
 		using SignalImpl = WinSignalImpl;
+
+#if GREAPER_MIN_WINDOWS_SUPPORTED >= 0x0602
+		struct WinWaitOnAddressImpl
+		{
+			static bool Wait(volatile uint32* address, uint32 compareValue, uint32 millis) noexcept
+			{
+				if (::WaitOnAddress(address, &compareValue, sizeof(compareValue), millis) != FALSE)
+					return true;
+				return ::GetLastError() != ERROR_TIMEOUT;
+			}
+			static void WakeOne(volatile uint32* address) noexcept
+			{
+				::WakeByAddressSingle((PVOID)address);
+			}
+			static void WakeAll(volatile uint32* address) noexcept
+			{
+				::WakeByAddressAll((PVOID)address);
+			}
+		};
+#else
+		/**
+		 * Windows 7 has no WaitOnAddress, waiters park on a condition variable picked
+		 * by hashing the address, as buckets are shared every wake is a broadcast.
+		 */
+		struct WinWaitOnAddressImpl
+		{
+			struct Bucket
+			{
+				SRWLOCK Lock;
+				CONDITION_VARIABLE Condition;
+			};
+			static constexpr sizet BucketCount = 64;
+
+			static Bucket& GetBucket(volatile uint32* address) noexcept
+			{
+				static Bucket buckets[BucketCount] = {};
+				return buckets[(reinterpret_cast<ptruint>(address) / CACHE_LINE_SIZE) & (BucketCount - 1)];
+			}
+			static bool Wait(volatile uint32* address, uint32 compareValue, uint32 millis) noexcept
+			{
+				auto& bucket = GetBucket(address);
+				bool woken = true;
+				AcquireSRWLockExclusive(&bucket.Lock);
+				if (*address == compareValue)
+					woken = SleepConditionVariableSRW(&bucket.Condition, &bucket.Lock, millis, 0) != FALSE;
+				ReleaseSRWLockExclusive(&bucket.Lock);
+				return woken;
+			}
+			static void WakeOne(volatile uint32* address) noexcept
+			{
+				WakeAll(address);
+			}
+			static void WakeAll(volatile uint32* address) noexcept
+			{
+				auto& bucket = GetBucket(address);
+				// Serialize with any waiter that has already checked the value but not yet slept
+				AcquireSRWLockExclusive(&bucket.Lock);
+				ReleaseSRWLockExclusive(&bucket.Lock);
+				WakeAllConditionVariable(&bucket.Condition);
+			}
+		};
+#endif
+		using WaitOnAddressImpl = WinWaitOnAddressImpl;
 	}
 }
 